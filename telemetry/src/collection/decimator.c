@@ -0,0 +1,344 @@
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#include "decimator.h"
+
+/* The number of independent partial sums kept while summing a column. Breaking the dependency between additions
+ * lets the compiler map the loop onto SIMD lanes without reassociating floating point math. */
+
+#define SUM_LANES 4
+
+/* Sums a column of samples
+ *
+ * @param x The samples to sum
+ * @param n The number of samples
+ * @return The sum of the samples
+ */
+static float sum_column(const float *x, size_t n) {
+    float lanes[SUM_LANES] = {0};
+    float sum = 0.0f;
+    size_t i = 0;
+
+    for (; i + SUM_LANES <= n; i += SUM_LANES) {
+        for (int l = 0; l < SUM_LANES; l++) {
+            lanes[l] += x[i + l];
+        }
+    }
+    for (; i < n; i++) {
+        sum += x[i];
+    }
+    for (int l = 0; l < SUM_LANES; l++) {
+        sum += lanes[l];
+    }
+    return sum;
+}
+
+/* CIC inputs are quantized to this many steps per unit (Q16), much finer than any block's resolution */
+
+#define CIC_SCALE 65536.0f
+
+/* Quantized inputs are clamped to this magnitude so they fit in 32 bits */
+
+#define CIC_INPUT_LIMIT 2147483520.0f
+
+/* The index of the CIC lane used to track the filter's DC gain */
+
+#define CIC_GAIN_LANE DECIMATOR_MAX_AXES
+
+/* Runs a lane's last integrator output through its comb stages, producing a decimated output
+ *
+ * @param integ The integrator stages of the lane
+ * @param comb The comb stages of the lane
+ * @return The output of the lane
+ */
+static int64_t cic_comb(const uint64_t *integ, uint64_t *comb) {
+    uint64_t y = integ[DECIMATOR_CIC_ORDER - 1];
+    for (int k = 0; k < DECIMATOR_CIC_ORDER; k++) {
+        uint64_t prev = comb[k];
+        comb[k] = y;
+        y -= prev;
+    }
+    return (int64_t)y;
+}
+
+/* Adds samples to the CIC integrators
+ *
+ * @param dec The decimator to add to
+ * @param cols The per-axis sample columns
+ * @param n The number of samples to add
+ */
+static void cic_add(struct decimator *dec, const float *const cols[], size_t n) {
+    uint64_t integ[DECIMATOR_CIC_ORDER];
+
+    /* The integrators are kept in locals while a column is processed so they can stay in registers */
+
+    for (int a = 0; a < dec->n_axes; a++) {
+        memcpy(integ, dec->cic.integ[a], sizeof(integ));
+        for (size_t i = 0; i < n; i++) {
+            float x = cols[a][i] * CIC_SCALE;
+            x = x > CIC_INPUT_LIMIT ? CIC_INPUT_LIMIT : (x < -CIC_INPUT_LIMIT ? -CIC_INPUT_LIMIT : x);
+            uint64_t y = (uint64_t)(int64_t)(int32_t)(x + copysignf(0.5f, x));
+            for (int k = 0; k < DECIMATOR_CIC_ORDER; k++) {
+                y += integ[k];
+                integ[k] = y;
+            }
+        }
+        memcpy(dec->cic.integ[a], integ, sizeof(integ));
+    }
+
+    /* The gain lane's input is always one */
+
+    memcpy(integ, dec->cic.integ[CIC_GAIN_LANE], sizeof(integ));
+    for (size_t i = 0; i < n; i++) {
+        uint64_t y = 1;
+        for (int k = 0; k < DECIMATOR_CIC_ORDER; k++) {
+            y += integ[k];
+            integ[k] = y;
+        }
+    }
+    memcpy(dec->cic.integ[CIC_GAIN_LANE], integ, sizeof(integ));
+}
+
+/* Empties the per-axis envelope, so the first sample of a window sets both bounds
+ *
+ * @param dec The decimator to reset the envelope of
+ */
+static void envelope_reset(struct decimator *dec) {
+    for (int a = 0; a < DECIMATOR_MAX_AXES; a++) {
+        dec->env.min[a] = FLT_MAX;
+        dec->env.max[a] = -FLT_MAX;
+    }
+}
+
+/* Widens the per-axis envelope of the current window to include a block of samples
+ *
+ * @param dec The decimator to update
+ * @param cols The per-axis sample columns
+ * @param n The number of samples
+ */
+static void envelope_add(struct decimator *dec, const float *const cols[], size_t n) {
+    for (int a = 0; a < dec->n_axes; a++) {
+        float min = dec->env.min[a];
+        float max = dec->env.max[a];
+        for (size_t i = 0; i < n; i++) {
+            min = cols[a][i] < min ? cols[a][i] : min;
+            max = cols[a][i] > max ? cols[a][i] : max;
+        }
+        dec->env.min[a] = min;
+        dec->env.max[a] = max;
+    }
+}
+
+/* Adds samples to running means with the Welford update, mean = mean_(n-1) + (x - mean_(n-1)) / n
+ *
+ * @param dec The decimator to add to
+ * @param cols The per-axis sample columns
+ * @param n The number of samples to add
+ */
+static void welford_add(struct decimator *dec, const float *const cols[], size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        uint16_t window_n = dec->window_n + i + 1;
+        for (int a = 0; a < dec->n_axes; a++) {
+            dec->acc[a] += (cols[a][i] - dec->acc[a]) / window_n;
+        }
+    }
+}
+
+/**
+ * Initialize a decimator
+ *
+ * @param dec The decimator to initialize
+ * @param mode How windows are reduced to an output
+ * @param n_axes The number of axes in each sample, at most DECIMATOR_MAX_AXES
+ * @param target_n The number of samples in each window
+ */
+void decimator_init(struct decimator *dec, enum decimator_mode_e mode, uint8_t n_axes, uint16_t target_n) {
+    dec->mode = mode;
+    dec->envelope = 0;
+    dec->n_axes = n_axes > DECIMATOR_MAX_AXES ? DECIMATOR_MAX_AXES : n_axes;
+    decimator_set_target(dec, target_n);
+    decimator_reset(dec);
+}
+
+/**
+ * Change the number of samples in a window. Takes effect on the current window.
+ *
+ * @param dec The decimator to modify
+ * @param target_n The new number of samples in each window, must be at least one
+ */
+void decimator_set_target(struct decimator *dec, uint16_t target_n) {
+    if (target_n == 0) {
+        target_n = 1;
+    }
+    if (dec->mode == DECIMATOR_CIC && target_n > DECIMATOR_CIC_MAX_WINDOW) {
+        target_n = DECIMATOR_CIC_MAX_WINDOW;
+    }
+    dec->target_n = target_n;
+    dec->inv_target_n = 1.0f / target_n;
+}
+
+/**
+ * Enable or disable tracking the minimum and maximum of each axis over a window
+ *
+ * @param dec The decimator to modify
+ * @param enable Non-zero to track the envelope
+ */
+void decimator_set_envelope(struct decimator *dec, int enable) { dec->envelope = enable != 0; }
+
+/**
+ * Discard the samples in the current window, and in CIC mode the filter's history
+ *
+ * @param dec The decimator to reset
+ */
+void decimator_reset(struct decimator *dec) {
+    memset(dec->acc, 0, sizeof(dec->acc));
+    memset(dec->sum, 0, sizeof(dec->sum));
+    memset(&dec->cic, 0, sizeof(dec->cic));
+    envelope_reset(dec);
+    dec->window_n = 0;
+}
+
+/**
+ * Add samples to the current window, stopping early if the window fills up
+ *
+ * @param dec The decimator to add samples to
+ * @param cols One column of samples per axis
+ * @param n The number of samples in each column
+ * @return The number of samples consumed from the columns
+ */
+size_t decimator_add_block(struct decimator *dec, const float *const cols[], size_t n) {
+    size_t space = dec->window_n < dec->target_n ? dec->target_n - dec->window_n : 0;
+    size_t take = n < space ? n : space;
+
+    if (dec->mode == DECIMATOR_WELFORD) {
+        welford_add(dec, cols, take);
+    } else if (dec->mode == DECIMATOR_CIC) {
+        cic_add(dec, cols, take);
+    } else {
+        for (int a = 0; a < dec->n_axes; a++) {
+            dec->acc[a] += sum_column(cols[a], take);
+        }
+    }
+    if (dec->envelope) {
+        envelope_add(dec, cols, take);
+    }
+
+    dec->window_n += take;
+    return take;
+}
+
+/**
+ * Add integer samples to the current window of a fixed point decimator, stopping early if the window fills up
+ *
+ * @param dec The decimator to add samples to, which must be in fixed point mode
+ * @param cols One column of samples per axis
+ * @param n The number of samples in each column
+ * @return The number of samples consumed from the columns
+ */
+size_t decimator_add_block_fixed(struct decimator *dec, const int32_t *const cols[], size_t n) {
+    size_t space = dec->window_n < dec->target_n ? dec->target_n - dec->window_n : 0;
+    size_t take = n < space ? n : space;
+
+    /* A full window of 32 bit samples can't overflow the 64 bit sums */
+
+    for (int a = 0; a < dec->n_axes; a++) {
+        int64_t sum = dec->sum[a];
+        for (size_t i = 0; i < take; i++) {
+            sum += cols[a][i];
+        }
+        dec->sum[a] = sum;
+    }
+
+    dec->window_n += take;
+    return take;
+}
+
+/**
+ * Check if the current window is ready to produce an output
+ *
+ * @param dec The decimator to check
+ * @return 1 if the window is full, 0 otherwise
+ */
+int decimator_full(struct decimator *dec) { return dec->window_n >= dec->target_n; }
+
+/**
+ * Get the minimum and maximum of each axis over the current window. Must be called before decimator_result, which
+ * starts a new window.
+ *
+ * @param dec The decimator to get the envelope of, which must be tracking it
+ * @param env Where to write the envelope
+ */
+void decimator_get_envelope(struct decimator *dec, struct decimator_envelope *env) {
+    if (dec->window_n == 0) {
+        memset(env, 0, sizeof(*env));
+        return;
+    }
+    *env = dec->env;
+}
+
+/**
+ * Get the output of the current window and start a new one
+ *
+ * @param dec The decimator to get the output of
+ * @param out Where to write one output value per axis
+ */
+void decimator_result(struct decimator *dec, float *out) {
+    if (dec->window_n == 0) {
+        memset(out, 0, dec->n_axes * sizeof(float));
+    } else if (dec->mode == DECIMATOR_CIC) {
+        /* The integrators carry over between windows, only the window count restarts */
+
+        float scale = 1.0f / ((float)cic_comb(dec->cic.integ[CIC_GAIN_LANE], dec->cic.comb[CIC_GAIN_LANE]) * CIC_SCALE);
+        for (int a = 0; a < dec->n_axes; a++) {
+            out[a] = (float)cic_comb(dec->cic.integ[a], dec->cic.comb[a]) * scale;
+        }
+        dec->window_n = 0;
+        envelope_reset(dec);
+        return;
+    } else if (dec->mode == DECIMATOR_WELFORD) {
+        memcpy(out, dec->acc, dec->n_axes * sizeof(float));
+    } else if (dec->mode == DECIMATOR_FIXED) {
+        for (int a = 0; a < dec->n_axes; a++) {
+            out[a] = (float)dec->sum[a] / dec->window_n;
+        }
+    } else {
+        /* The target can change mid-window, only the common case gets the precomputed reciprocal */
+
+        float scale = dec->window_n == dec->target_n ? dec->inv_target_n : 1.0f / dec->window_n;
+        for (int a = 0; a < dec->n_axes; a++) {
+            out[a] = dec->acc[a] * scale;
+        }
+    }
+    decimator_reset(dec);
+}
+
+/**
+ * Get the output of the current window of a fixed point decimator, rounded to the nearest integer, and start a new one
+ *
+ * @param dec The decimator to get the output of, which must be in fixed point mode
+ * @param out Where to write one output value per axis
+ */
+void decimator_result_fixed(struct decimator *dec, int32_t *out) {
+    int64_t half = dec->window_n / 2;
+
+    for (int a = 0; a < dec->n_axes; a++) {
+        if (dec->window_n == 0) {
+            out[a] = 0;
+        } else {
+            out[a] = (dec->sum[a] + (dec->sum[a] < 0 ? -half : half)) / dec->window_n;
+        }
+    }
+    decimator_reset(dec);
+}
+
+/**
+ * Get how far the output of a full window lags behind the newest sample in it, which is the group delay of the filter
+ *
+ * @param dec The decimator to get the delay of
+ * @return The delay in input samples
+ */
+float decimator_delay(struct decimator *dec) {
+    float order = dec->mode == DECIMATOR_CIC ? DECIMATOR_CIC_ORDER : 1;
+    return order * (dec->target_n - 1) / 2.0f;
+}
@@ -0,0 +1,71 @@
+#ifndef _INSPACE_DECIMATOR_H_
+#define _INSPACE_DECIMATOR_H_
+
+#include <nuttx/config.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* The maximum number of axes a decimator can reduce at once */
+
+#define DECIMATOR_MAX_AXES 3
+
+/* The number of integrator and comb stages in the CIC decimator */
+
+#define DECIMATOR_CIC_ORDER CONFIG_INSPACE_DOWNSAMPLING_CIC_ORDER
+
+/* The largest window the CIC decimator can use without its 64 bit registers overflowing on a full scale input */
+
+#define DECIMATOR_CIC_MAX_WINDOW 1024
+
+/* Ways a decimator can reduce a window of samples to one output */
+
+enum decimator_mode_e {
+    DECIMATOR_MEAN = 0,    /* Boxcar mean, per-axis sums scaled once when the window closes */
+    DECIMATOR_WELFORD = 1, /* Boxcar mean, running Welford update with a division per axis per sample */
+    DECIMATOR_CIC = 2,     /* Cascaded integrator-comb, attenuates content that would alias into the output rate */
+    DECIMATOR_FIXED = 3,   /* Boxcar mean of integer samples with exact 64 bit sums, fed by the _fixed functions */
+};
+
+/* Integer state of a CIC decimator. One extra lane is fed a constant so each output can be normalized by the
+ * filter's exact DC gain, even while the window size changes. */
+struct decimator_cic {
+    uint64_t integ[DECIMATOR_MAX_AXES + 1][DECIMATOR_CIC_ORDER]; /* Integrator stages, wrapping on overflow */
+    uint64_t comb[DECIMATOR_MAX_AXES + 1][DECIMATOR_CIC_ORDER];  /* Previous input of each comb stage */
+};
+
+/* The range of each axis over a window, in the units of the input */
+struct decimator_envelope {
+    float min[DECIMATOR_MAX_AXES];
+    float max[DECIMATOR_MAX_AXES];
+    uint64_t timestamp; /* The middle of the samples the range covers, set by the caller, which has their times */
+};
+
+/* Reduces windows of multi-axis samples to a single output per window.
+ * Input is taken in structure-of-arrays form (one column per axis) so the per-axis loops can be vectorized.
+ */
+struct decimator {
+    float acc[DECIMATOR_MAX_AXES];   /* Per-axis sums, or running means in Welford mode */
+    int64_t sum[DECIMATOR_MAX_AXES]; /* Per-axis sums in fixed point mode */
+    struct decimator_cic cic;        /* Filter state in CIC mode */
+    struct decimator_envelope env;   /* Range of the current window, if tracking the envelope */
+    float inv_target_n;              /* Reciprocal of target_n, so closing a window doesn't need a division */
+    uint16_t window_n;               /* The number of samples in the current window */
+    uint16_t target_n;               /* The number of samples in a full window */
+    uint8_t n_axes;                  /* The number of axes being reduced */
+    uint8_t mode;                    /* How the window is reduced, one of enum decimator_mode_e */
+    uint8_t envelope;                /* If the per-axis minimums and maximums are tracked, not in fixed point mode */
+};
+
+void decimator_init(struct decimator *dec, enum decimator_mode_e mode, uint8_t n_axes, uint16_t target_n);
+void decimator_set_target(struct decimator *dec, uint16_t target_n);
+void decimator_set_envelope(struct decimator *dec, int enable);
+void decimator_reset(struct decimator *dec);
+size_t decimator_add_block(struct decimator *dec, const float *const cols[], size_t n);
+size_t decimator_add_block_fixed(struct decimator *dec, const int32_t *const cols[], size_t n);
+int decimator_full(struct decimator *dec);
+void decimator_get_envelope(struct decimator *dec, struct decimator_envelope *env);
+void decimator_result(struct decimator *dec, float *out);
+void decimator_result_fixed(struct decimator *dec, int32_t *out);
+float decimator_delay(struct decimator *dec);
+
+#endif // _INSPACE_DECIMATOR_H_
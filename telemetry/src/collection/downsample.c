@@ -2,6 +2,13 @@
 #include "downsample.h"
 #include "../fusion/fusion.h"
 #include "../syslogging.h"
+#include "../transmission/downlink-profile.h"
+#include "../transmission/transmit.h"
+#include "decimator.h"
+#include "ingest.h"
+#include "odr-schedule.h"
+#include "rate-control.h"
+#include "resample.h"
 #include "status-update.h"
 #include "uORB/uORB.h"
 #include <fcntl.h>
@@ -9,6 +16,8 @@
 #include <nuttx/sensors/sensor.h>
 #include <poll.h>
 #include <pthread.h>
+#include <stddef.h>
+#include <string.h>
 #include <sys/ioctl.h>
 #include <time.h>
 #include <unistd.h>
@@ -23,7 +32,7 @@ enum uorb_sensors {
     SENSOR_MAG,   /* Magnetometer */
     SENSOR_GNSS,  /* GNSS */
     SENSOR_ALT,   /* Altitude fusion */
-    SENSOR_BARO,
+    SENSOR_BARO,  /* Barometer */
 };
 
 /* A buffer that can hold any of the types of data created by the sensors in uorb_inputs */
@@ -61,40 +70,252 @@ static struct orb_metadata const *uorb_metas[] = {
     [SENSOR_GNSS] = ORB_ID(sensor_gnss),   [SENSOR_ALT] = ORB_ID(fusion_altitude), [SENSOR_BARO] = ORB_ID(sensor_baro),
 };
 
-/* The default sampling rate for low-sample sensors or topics */
+/* Definitions of the downsampled topics */
+
+#if defined(CONFIG_DEBUG_UORB)
+static const char downsampled_accel_format[] =
+    "downsampled accel - timestamp:%" PRIu64 ",x:%hf,y:%hf,z:%hf,temperature:%hf";
+static const char downsampled_gyro_format[] =
+    "downsampled gyro - timestamp:%" PRIu64 ",x:%hf,y:%hf,z:%hf,temperature:%hf";
+static const char downsampled_mag_format[] =
+    "downsampled mag - timestamp:%" PRIu64 ",x:%hf,y:%hf,z:%hf,temperature:%hf,status:%" PRId32;
+static const char downsampled_gnss_format[] =
+    "downsampled gnss - timestamp:%" PRIu64 ",latitude:%" PRId32 ",longitude:%" PRId32;
+static const char downsampled_alt_format[] = "downsampled altitude - timestamp:%" PRIu64 ",altitude:%hf";
+static const char downsampled_baro_format[] =
+    "downsampled baro - timestamp:%" PRIu64 ",pressure:%hf,temperature:%hf";
+ORB_DEFINE(downsampled_accel, struct sensor_accel, downsampled_accel_format);
+ORB_DEFINE(downsampled_gyro, struct sensor_gyro, downsampled_gyro_format);
+ORB_DEFINE(downsampled_mag, struct sensor_mag, downsampled_mag_format);
+ORB_DEFINE(downsampled_gnss, struct coord_sample, downsampled_gnss_format);
+ORB_DEFINE(downsampled_alt, struct fusion_altitude, downsampled_alt_format);
+ORB_DEFINE(downsampled_baro, struct sensor_baro, downsampled_baro_format);
+#else
+ORB_DEFINE(downsampled_accel, struct sensor_accel, 0);
+ORB_DEFINE(downsampled_gyro, struct sensor_gyro, 0);
+ORB_DEFINE(downsampled_mag, struct sensor_mag, 0);
+ORB_DEFINE(downsampled_gnss, struct coord_sample, 0);
+ORB_DEFINE(downsampled_alt, struct fusion_altitude, 0);
+ORB_DEFINE(downsampled_baro, struct sensor_baro, 0);
+#endif
 
-#define LOW_SAMPLE_RATE_DEFAULT 10
+/* A buffer that can hold an output of any of the downsampled topics */
 
-static const uint32_t sample_freqs[] = {
-    [SENSOR_ACCEL] = CONFIG_INSPACE_TELEMETRY_ACCEL_SF, [SENSOR_GYRO] = CONFIG_INSPACE_TELEMETRY_GYRO_SF,
-    [SENSOR_MAG] = CONFIG_INSPACE_TELEMETRY_MAG_SF,     [SENSOR_GNSS] = CONFIG_INSPACE_TELEMETRY_GPS_SF,
-    [SENSOR_BARO] = CONFIG_INSPACE_TELEMETRY_BARO_SF,
+union downsampled_data {
+    struct sensor_accel accel;
+    struct sensor_gyro gyro;
+    struct sensor_mag mag;
+    struct coord_sample gnss;
+    struct fusion_altitude alt;
+    struct sensor_baro baro;
 };
 
-/* Data buffer for copying uORB data */
+/* How sensor windows are averaged */
+
+#ifdef CONFIG_INSPACE_DOWNSAMPLING_WELFORD
+#define DOWNSAMPLE_MEAN_MODE DECIMATOR_WELFORD
+#else
+#define DOWNSAMPLE_MEAN_MODE DECIMATOR_MEAN
+#endif
+
+/* How the vibration sensitive IMU windows are reduced, anti-aliased or averaged like the rest */
+
+#ifdef CONFIG_INSPACE_DOWNSAMPLING_ACCEL_CIC
+#define DOWNSAMPLE_ACCEL_MODE DECIMATOR_CIC
+#else
+#define DOWNSAMPLE_ACCEL_MODE DOWNSAMPLE_MEAN_MODE
+#endif
+
+#ifdef CONFIG_INSPACE_DOWNSAMPLING_GYRO_CIC
+#define DOWNSAMPLE_GYRO_MODE DECIMATOR_CIC
+#else
+#define DOWNSAMPLE_GYRO_MODE DOWNSAMPLE_MEAN_MODE
+#endif
+
+/* If the IMU sensors are resampled onto a shared grid, and the spacing of the grid for a sensor downlinking `outputs`
+ * every transmit period of `period_ms`. Sensors whose outputs divide each other's share grid instants. */
+
+#ifdef CONFIG_INSPACE_DOWNSAMPLING_RESAMPLE
+#define DOWNSAMPLE_RESAMPLE 1
+#else
+#define DOWNSAMPLE_RESAMPLE 0
+#endif
+
+#define resample_period_us(period_ms, outputs) ((period_ms) * 1000 / (outputs))
+
+/* Downsampling window for a sensor sampled at `freq` Hz making `outputs` every transmit period of `period_ms`, used
+ * until its rate has been measured */
+
+#define initial_window(freq, period_ms, outputs) ((freq) * (period_ms) / 1000 / (outputs))
+
+/* The transmit period outputs are spread over in milliseconds, TRANSMIT_PERIOD_MS until the transmit thread sets it */
+
+#define downsample_period_ms(radio_telem)                                                                              \
+    (radio_telem_period(radio_telem) != 0 ? radio_telem_period(radio_telem) : TRANSMIT_PERIOD_MS)
+
+/* Where a downsampled sensor's output goes in radio_raw_data, given the name of its output array */
+
+#define radio_slot(field)                                                                                              \
+    .out_offset = offsetof(radio_raw_data, field), .count_offset = offsetof(radio_raw_data, field##_n),                \
+    .out_size = sizeof(((radio_raw_data *)0)->field[0])
+
+/* Where a downsampled sensor's envelopes go in radio_raw_data, if they are tracked */
+
+#ifdef CONFIG_INSPACE_DOWNSAMPLING_ENVELOPE
+#define envelope_slot(field) .env_offset = offsetof(radio_raw_data, field)
+#else
+#define envelope_slot(field) .env_offset = 0
+#endif
+
+/* Describes how samples from a uORB topic are downsampled, published and added to the radio buffer */
+
+struct downsample_desc {
+    const struct orb_metadata *topic;         /* The topic outputs are published on */
+    uint8_t n_axes;                           /* Number of float fields averaged, 0 if not downsampled */
+    uint8_t axis_offsets[DECIMATOR_MAX_AXES]; /* Offsets of the averaged float fields in the uORB struct */
+    uint8_t mode;                             /* How windows are reduced, one of enum decimator_mode_e */
+    uint16_t out_offset;                      /* Offset of the output array in radio_raw_data */
+    uint16_t out_size;                        /* Size of an element of the output array */
+    uint16_t count_offset;                    /* Offset of the output array's element count in radio_raw_data */
+    uint16_t env_offset;                      /* Offset of the envelope array in radio_raw_data, 0 if not tracked */
+    uint8_t channel;                          /* The radio channel of the output array, from enum radio_channel_e */
+    uint8_t odr;                              /* The sensor whose rate profile the topic follows */
+    uint8_t resample;                         /* If outputs are resampled onto the grid shared by the IMU sensors */
+
+    /* In fixed point mode, outputs are a timestamp followed by the averaged fields as integers */
+
+    uint8_t out_axis_offsets[DECIMATOR_MAX_AXES]; /* Offsets of the averaged integer fields in an output */
+    double fixed_scale;                           /* Integer units per unit of the averaged uORB fields */
+};
+
+static const struct downsample_desc downsample_descs[] = {
+    [SENSOR_ACCEL] =
+        {
+            .n_axes = 3,
+            .axis_offsets = {offsetof(struct sensor_accel, x), offsetof(struct sensor_accel, y),
+                             offsetof(struct sensor_accel, z)},
+            .mode = DOWNSAMPLE_ACCEL_MODE,
+            .topic = ORB_ID(downsampled_accel),
+            radio_slot(accel),
+            .channel = RADIO_ACCEL,
+            .resample = DOWNSAMPLE_RESAMPLE,
+            envelope_slot(accel_env),
+            .odr = ODR_ACCEL,
+        },
+    [SENSOR_GYRO] =
+        {
+            .n_axes = 3,
+            .axis_offsets = {offsetof(struct sensor_gyro, x), offsetof(struct sensor_gyro, y),
+                             offsetof(struct sensor_gyro, z)},
+            .mode = DOWNSAMPLE_GYRO_MODE,
+            .topic = ORB_ID(downsampled_gyro),
+            radio_slot(gyro),
+            .channel = RADIO_GYRO,
+            .resample = DOWNSAMPLE_RESAMPLE,
+            envelope_slot(gyro_env),
+            .odr = ODR_GYRO,
+        },
+    [SENSOR_MAG] =
+        {
+            .n_axes = 3,
+            .axis_offsets = {offsetof(struct sensor_mag, x), offsetof(struct sensor_mag, y),
+                             offsetof(struct sensor_mag, z)},
+            .mode = DOWNSAMPLE_MEAN_MODE,
+            .topic = ORB_ID(downsampled_mag),
+            radio_slot(mag),
+            .channel = RADIO_MAG,
+            .resample = DOWNSAMPLE_RESAMPLE,
+            .odr = ODR_MAG,
+        },
+    [SENSOR_GNSS] =
+        {
+            .n_axes = 2,
+            .axis_offsets = {offsetof(struct sensor_gnss, latitude), offsetof(struct sensor_gnss, longitude)},
+            .mode = DECIMATOR_FIXED, /* Float sums can't hold a coordinate to the resolution of a coordinate block */
+            .topic = ORB_ID(downsampled_gnss),
+            radio_slot(gnss),
+            .channel = RADIO_GNSS,
+            .odr = ODR_GNSS,
+            .out_axis_offsets = {offsetof(struct coord_sample, latitude), offsetof(struct coord_sample, longitude)},
+            .fixed_scale = 1e7, /* 0.1 microdegrees */
+        },
+    [SENSOR_ALT] =
+        {
+            .n_axes = 1,
+            .axis_offsets = {offsetof(struct fusion_altitude, altitude)},
+            .mode = DOWNSAMPLE_MEAN_MODE,
+            .topic = ORB_ID(downsampled_alt),
+            radio_slot(alt),
+            .channel = RADIO_ALT,
+            .odr = ODR_BARO, /* Published by the fusion thread at the barometer's rate */
+        },
+    [SENSOR_BARO] =
+        {
+            .n_axes = 2,
+            .axis_offsets = {offsetof(struct sensor_baro, pressure), offsetof(struct sensor_baro, temperature)},
+            .mode = DOWNSAMPLE_MEAN_MODE,
+            .topic = ORB_ID(downsampled_baro),
+            radio_slot(baro),
+            .channel = RADIO_BARO,
+            .odr = ODR_BARO,
+        },
+};
+
+/* Data buffer for copying uORB data, as unions so every sample in it is aligned */
+
+static union uorb_data data_buf[CONFIG_INSPACE_DOWNSAMPLING_COPY_BUFFER / sizeof(union uorb_data)];
+
+/* Wakeup statistics of the downsample thread */
 
-static uint8_t data_buf[sizeof(union uorb_data) * 10];
+static struct ingest_stats ingest_stats;
+
+/* The most samples of any topic that fit in the data buffer */
+
+#define DATA_BUF_MAX_SAMPLES (CONFIG_INSPACE_DOWNSAMPLING_COPY_BUFFER / sizeof(struct fusion_altitude))
+
+/* The timestamp of a uORB sample, every downsampled topic starts with one */
+
+#define sample_timestamp(sample) (*(const uint64_t *)(sample))
+
+/* The averaged fields of a batch of samples, de-interleaved into one column per axis */
+
+static union {
+    float f[DECIMATOR_MAX_AXES][DATA_BUF_MAX_SAMPLES];
+    int32_t q[DECIMATOR_MAX_AXES][DATA_BUF_MAX_SAMPLES]; /* Converted to integers in fixed point mode */
+} axis_buf;
 
 /* The numbers of sensors that are available to be polled */
 
 #define NUM_SENSORS (sizeof(uorb_fds) / sizeof(uorb_fds[0]))
 
+_Static_assert(NUM_SENSORS <= DOWNSAMPLE_MAX_RATES, "Every sensor's rate must fit in DOWNSAMPLE_MAX_RATES");
+
 typedef struct {
-    float out[3];             /* downsampled output, 3 fields for sensors with 3 axes */
-    uint16_t window_n;        /* number of samples accumulated in the current downsampling window */
-    uint16_t target_window_n; /* target number of input samples per downsampled output */
-    uint16_t total_n;         /* total samples since last buffer swap, used for dynamic rate adjustment */
-    uint16_t dropped_n;       /* output blocks dropped since last buffer swap */
-    uint16_t output_n;        /* output blocks written since last swap */
+    struct decimator dec;          /* reduces the current downsampling window to one output */
+    uint64_t window_start;         /* timestamp of the first sample in the current window */
+    struct rate_control rate;      /* chooses the window from the measured input rate */
+    uint16_t dropped_n;            /* outputs left out of the radio buffer because it was full since last buffer swap */
+    uint16_t output_n;             /* windows closed since last swap */
+    struct resampler rs;           /* interpolates window outputs onto the shared grid, if resampled */
+    struct decimator_envelope env; /* range of the windows closed since the last output was written */
+    uint64_t env_start;            /* timestamp of the first sample of the windows env covers */
+    uint8_t env_written;           /* if env was written with an output, so the next window replaces it */
+    int pub_fd;                    /* advertisement of the downsampled topic, negative if it couldn't be advertised */
 } sensor_downsampling_t;
 
-static sensor_downsampling_t sensor_downsamples[] = {
-    [SENSOR_ACCEL] = {.target_window_n = CONFIG_INSPACE_TELEMETRY_ACCEL_SF / CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ},
-    [SENSOR_GYRO] = {.target_window_n = CONFIG_INSPACE_TELEMETRY_GYRO_SF / CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ},
-    [SENSOR_MAG] = {.target_window_n = CONFIG_INSPACE_TELEMETRY_MAG_SF / CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ},
-    [SENSOR_GNSS] = {.target_window_n = CONFIG_INSPACE_TELEMETRY_GPS_SF / CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ},
-    [SENSOR_ALT] = {.target_window_n = CONFIG_INSPACE_TELEMETRY_ALT_SF / CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ},
-};
+static sensor_downsampling_t sensor_downsamples[NUM_SENSORS];
+
+/* The number of bytes copied from each topic at once, sized to its queue */
+
+static size_t copy_lens[NUM_SENSORS];
+
+static int downsample_batch(sensor_downsampling_t *ds, const struct downsample_desc *desc, const uint8_t *samples,
+                            size_t n, size_t sample_size, radio_raw_data *buff);
+static void downsample_fill(const struct downsample_desc *desc, union downsampled_data *out, const uint8_t *last,
+                            uint64_t timestamp, const float *means);
+static int downsample_output(sensor_downsampling_t *ds, const struct downsample_desc *desc, radio_raw_data *buff,
+                             const union downsampled_data *out);
+static void downsample_set_profile(enum odr_profile_e profile, uint32_t period_ms);
 
 /*
  * Downsample thread, takes data in from uorb topics and downsamples it to the target frequency
@@ -103,6 +324,9 @@ void *downsample_main(void *arg) {
     int err;
     struct downsample_args *unpacked_args = (struct downsample_args *)(arg);
     radio_telem_t *radio_telem = unpacked_args->radio_telem;
+    enum flight_state_e flight_state;
+    enum flight_substate_e flight_substate;
+    enum odr_profile_e profile;
 
     ininfo("Downsample thread started.\n");
 
@@ -126,6 +350,23 @@ void *downsample_main(void *arg) {
 
     ininfo("Sensors subscribed.\n");
 
+    /* Sensors are sampled at the rates of the current flight state, which the fusion thread sets */
+
+    state_get_flightstate(unpacked_args->state, &flight_state);
+    state_get_flightsubstate(unpacked_args->state, &flight_substate);
+    profile = odr_profile(flight_state, flight_substate);
+
+    /* Outputs are spread over the transmit period, which the transmit thread sets from the radio's airtime */
+
+    uint32_t period_ms = downsample_period_ms(radio_telem);
+
+    for (int i = 0; i < NUM_SENSORS; i++) {
+        decimator_init(&sensor_downsamples[i].dec, downsample_descs[i].mode, downsample_descs[i].n_axes, 1);
+        decimator_set_envelope(&sensor_downsamples[i].dec, downsample_descs[i].env_offset != 0);
+        sensor_downsamples[i].env_written = 1;
+    }
+    downsample_set_profile(profile, period_ms);
+
     /* Set sensor specific requirements */
     /* TODO: move this to the main or init thread */
 
@@ -147,62 +388,78 @@ void *downsample_main(void *arg) {
         }
     }
 
-#ifndef CONFIG_INSPACE_MOCKING
-    /* Set sample frequencies for all sensors
-     *
-     * NOTE: setting frequencies when mocking will break some flight records
-     * since all measurements in the CSV are synced line to line, so if we set
-     * accel to be faster than barometer, the measurements will be out of sync
-     * chronologically. Hence, disable frequency configurations when mocking.
-     */
-
-    ininfo("Setting sensor sample frequencies.\n");
-
-    for (int i = 0; i < sizeof(sample_freqs) / sizeof(sample_freqs[0]); i++) {
-
-        /* Skip invalid sensors */
+    /* Batch samples so each wakeup drains several of them. Batches are sized for the highest rate of any flight
+     * state, so they can't overflow a queue when the rates go up. */
 
+    for (int i = 0; i < NUM_SENSORS; i++) {
         if (uorb_fds[i].fd < 0) {
             continue;
         }
+        copy_lens[i] = ingest_configure(uorb_fds[i].fd, uorb_metas[i], odr_max_frequency(downsample_descs[i].odr),
+                                        CONFIG_INSPACE_DOWNSAMPLING_BATCH_MS, sizeof(data_buf));
+    }
+    ingest_stats_init(&ingest_stats, "downsample");
 
-        ininfo("Setting frequency of '%s' to %luHz\n", uorb_metas[i]->o_name, sample_freqs[i]);
-        err = orb_set_frequency(uorb_fds[i].fd, sample_freqs[i]);
-        if (err < 0) {
-            inerr("Failed to set frequency of '%s' to %luHz: %d\n", uorb_metas[i]->o_name, sample_freqs[i], errno);
+    /* Outputs are published whether or not the transmit thread keeps up */
+
+    for (int i = 0; i < NUM_SENSORS; i++) {
+        sensor_downsamples[i].pub_fd = orb_advertise_multi_queue(downsample_descs[i].topic, NULL, NULL,
+                                                                 DOWNSAMPLED_QUEUE_SIZE);
+        if (sensor_downsamples[i].pub_fd < 0) {
+            inerr("Failed to advertise '%s': %d\n", downsample_descs[i].topic->o_name, errno);
         }
     }
 
-    ininfo("Sensor frequencies set.\n");
-#endif
+    /* The last time the transmit thread took data, to measure the transmit period */
 
-    /* keepint track of sampling rates */
-    uint32_t rate_counts[NUM_SENSORS] = {0};
-    struct timespec rate_report_start;
-    clock_gettime(CLOCK_MONOTONIC, &rate_report_start);
+    struct timespec last_taken = {0};
 
     /* Measure data forever */
     for (;;) {
         poll(uorb_fds, NUM_SENSORS, -1);
 
-        if (sem_trywait(&radio_telem->swapped) == 0) {
+        /* Start from the new rates when the flight state or transmit period changes, rather than waiting for them to
+         * be measured */
+
+        state_get_flightstate(unpacked_args->state, &flight_state);
+        state_get_flightsubstate(unpacked_args->state, &flight_substate);
+        if (odr_profile(flight_state, flight_substate) != profile || downsample_period_ms(radio_telem) != period_ms) {
+            profile = odr_profile(flight_state, flight_substate);
+            period_ms = downsample_period_ms(radio_telem);
+            ininfo("Downsampling for a transmit period of %lu ms\n", (unsigned long)period_ms);
+            downsample_set_profile(profile, period_ms);
+        }
+
+        /* Windows are re-estimated every time the transmit thread takes the published data */
+
+        if (radio_telem_reclaim(radio_telem)) {
+            struct timespec now;
+            float period_s = 0;
+
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            if (last_taken.tv_sec != 0 || last_taken.tv_nsec != 0) {
+                period_s = (now.tv_sec - last_taken.tv_sec) + (now.tv_nsec - last_taken.tv_nsec) / 1e9f;
+            }
+            last_taken = now;
+
             for (int k = 0; k < NUM_SENSORS; k++) {
-                if (k == SENSOR_BARO) continue;
-                int new_target_window_n = sensor_downsamples[k].total_n / (CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ - 1);
-                if (sensor_downsamples[k].dropped_n > 0) {
-                    new_target_window_n = new_target_window_n *
-                                          (CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ + sensor_downsamples[k].dropped_n) /
-                                          CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ;
-                }
-                if (new_target_window_n > 0 && new_target_window_n != sensor_downsamples[k].target_window_n) {
-                    sensor_downsamples[k].target_window_n = new_target_window_n;
+                sensor_downsampling_t *ds = &sensor_downsamples[k];
+                if (downsample_descs[k].n_axes == 0) continue;
+
+                uint16_t window_n = rate_control_update(&ds->rate, period_s, ds->output_n);
+                indebug("'%s' at %.1fHz, %+.1f outputs, %u not downlinked, window of %u\n", uorb_metas[k]->o_name,
+                        ds->rate.input_hz, ds->rate.error, ds->dropped_n, window_n);
+                if (window_n != ds->dec.target_n) {
+                    decimator_set_target(&ds->dec, window_n);
                 }
-                sensor_downsamples[k].total_n = 0;
-                sensor_downsamples[k].dropped_n = 0;
-                sensor_downsamples[k].output_n = 0;
+                ds->dropped_n = 0;
+                ds->output_n = 0;
             }
         }
 
+        int outputs = 0;
+        uint32_t samples = 0;
+
         for (int i = 0; i < NUM_SENSORS; i++) {
 
             /* Skip invalid sensors and sensors without new data */
@@ -215,228 +472,259 @@ void *downsample_main(void *arg) {
 
             uorb_fds[i].revents = 0; /* Mark the event as handled */
 
-            err = orb_copy_multi(uorb_fds[i].fd, &data_buf, sizeof(data_buf));
+            /* Anything left queued after the copy keeps the topic ready, so it's read on the next poll */
+
+            err = orb_copy_multi(uorb_fds[i].fd, data_buf, copy_lens[i]);
             if (err < 0) {
-                inerr("Error reading data from %s: %d\n", uorb_metas[i]->o_name, errno);
+                inerr("Error reading data from %s: %d\n", uorb_metas[i]->o_name, err);
                 continue;
             }
+            samples += err / uorb_metas[i]->o_size;
 
-            for (int j = 0; j < (err / uorb_metas[i]->o_size); j++) {
-                sensor_downsamples[i].total_n++;
-                sensor_downsamples[i].window_n++;
-                rate_counts[i]++;
-
-                switch (i) {
-                case SENSOR_ACCEL: {
-                    if (radio_telem->empty_buff->accel_n == CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ) {
-                        sensor_downsamples[SENSOR_ACCEL].dropped_n++;
-                        sensor_downsamples[SENSOR_ACCEL].window_n = 0;
-                        break;
-                    }
-
-                    struct sensor_accel accel_input = ((struct sensor_accel *)data_buf)[j];
-
-                    /*
-                    using the Welford formula to calculate the mean, one pass for each axis
-                    mean = mean_(n-1) + (x - mean_(n-1)) / n
-                    */
-                    sensor_downsamples[SENSOR_ACCEL].out[0] +=
-                        (accel_input.x - sensor_downsamples[SENSOR_ACCEL].out[0]) /
-                        sensor_downsamples[SENSOR_ACCEL].window_n;
-                    sensor_downsamples[SENSOR_ACCEL].out[1] +=
-                        (accel_input.y - sensor_downsamples[SENSOR_ACCEL].out[1]) /
-                        sensor_downsamples[SENSOR_ACCEL].window_n;
-                    sensor_downsamples[SENSOR_ACCEL].out[2] +=
-                        (accel_input.z - sensor_downsamples[SENSOR_ACCEL].out[2]) /
-                        sensor_downsamples[SENSOR_ACCEL].window_n;
-
-                    if (sensor_downsamples[SENSOR_ACCEL].window_n >= sensor_downsamples[SENSOR_ACCEL].target_window_n) {
-
-                        struct sensor_accel sensor_accel = {
-                            .timestamp = accel_input.timestamp,
-                            .x = sensor_downsamples[SENSOR_ACCEL].out[0],
-                            .y = sensor_downsamples[SENSOR_ACCEL].out[1],
-                            .z = sensor_downsamples[SENSOR_ACCEL].out[2],
-                        };
-
-                        radio_telem->empty_buff->accel[radio_telem->empty_buff->accel_n++] = sensor_accel;
-                        sensor_downsamples[SENSOR_ACCEL].output_n++;
-                        sensor_downsamples[SENSOR_ACCEL].out[0] = 0;
-                        sensor_downsamples[SENSOR_ACCEL].out[1] = 0;
-                        sensor_downsamples[SENSOR_ACCEL].out[2] = 0;
-                        sensor_downsamples[SENSOR_ACCEL].window_n = 0;
-                    }
-
-                    break;
-                }
-                case SENSOR_GYRO: {
-                    if (radio_telem->empty_buff->gyro_n == CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ) {
-                        sensor_downsamples[SENSOR_GYRO].dropped_n++;
-                        sensor_downsamples[SENSOR_GYRO].window_n = 0;
-                        break;
-                    }
-
-                    struct sensor_gyro gyro_input = ((struct sensor_gyro *)data_buf)[j];
-
-                    /*
-                    using the Welford formula to calculate the mean, one pass for each axis
-                    mean = mean_(n-1) + (x - mean_(n-1)) / n
-                    */
-                    sensor_downsamples[SENSOR_GYRO].out[0] += (gyro_input.x - sensor_downsamples[SENSOR_GYRO].out[0]) /
-                                                              sensor_downsamples[SENSOR_GYRO].window_n;
-                    sensor_downsamples[SENSOR_GYRO].out[1] += (gyro_input.y - sensor_downsamples[SENSOR_GYRO].out[1]) /
-                                                              sensor_downsamples[SENSOR_GYRO].window_n;
-                    sensor_downsamples[SENSOR_GYRO].out[2] += (gyro_input.z - sensor_downsamples[SENSOR_GYRO].out[2]) /
-                                                              sensor_downsamples[SENSOR_GYRO].window_n;
-
-                    if (sensor_downsamples[SENSOR_GYRO].window_n >= sensor_downsamples[SENSOR_GYRO].target_window_n) {
-                        struct sensor_gyro sensor_gyro = {
-                            .timestamp = gyro_input.timestamp,
-                            .x = sensor_downsamples[SENSOR_GYRO].out[0],
-                            .y = sensor_downsamples[SENSOR_GYRO].out[1],
-                            .z = sensor_downsamples[SENSOR_GYRO].out[2],
-                        };
-
-                        radio_telem->empty_buff->gyro[radio_telem->empty_buff->gyro_n++] = sensor_gyro;
-                        sensor_downsamples[SENSOR_GYRO].output_n++;
-                        sensor_downsamples[SENSOR_GYRO].out[0] = 0;
-                        sensor_downsamples[SENSOR_GYRO].out[1] = 0;
-                        sensor_downsamples[SENSOR_GYRO].out[2] = 0;
-                        sensor_downsamples[SENSOR_GYRO].window_n = 0;
-                    }
-
-                    break;
-                }
-                case SENSOR_MAG: {
-                    if (radio_telem->empty_buff->mag_n == CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ) {
-                        sensor_downsamples[SENSOR_MAG].dropped_n++;
-                        sensor_downsamples[SENSOR_MAG].window_n = 0;
-                        break;
-                    }
-
-                    struct sensor_mag mag_input = ((struct sensor_mag *)data_buf)[j];
-
-                    /*
-                    using the Welford formula to calculate the mean, one pass for each axis
-                    mean = mean_(n-1) + (x - mean_(n-1)) / n
-                    */
-                    sensor_downsamples[SENSOR_MAG].out[0] +=
-                        (mag_input.x - sensor_downsamples[SENSOR_MAG].out[0]) / sensor_downsamples[SENSOR_MAG].window_n;
-                    sensor_downsamples[SENSOR_MAG].out[1] +=
-                        (mag_input.y - sensor_downsamples[SENSOR_MAG].out[1]) / sensor_downsamples[SENSOR_MAG].window_n;
-                    sensor_downsamples[SENSOR_MAG].out[2] +=
-                        (mag_input.z - sensor_downsamples[SENSOR_MAG].out[2]) / sensor_downsamples[SENSOR_MAG].window_n;
-
-                    if (sensor_downsamples[SENSOR_MAG].window_n >= sensor_downsamples[SENSOR_MAG].target_window_n) {
-                        struct sensor_mag sensor_mag = {
-                            .timestamp = mag_input.timestamp,
-                            .x = sensor_downsamples[SENSOR_MAG].out[0],
-                            .y = sensor_downsamples[SENSOR_MAG].out[1],
-                            .z = sensor_downsamples[SENSOR_MAG].out[2],
-                        };
-
-                        if (radio_telem->empty_buff->mag_n == CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ) {
-                            inerr("Magnetometer buffer full, dropping data\n");
-                            sensor_downsamples[SENSOR_MAG].dropped_n++;
-                            sensor_downsamples[SENSOR_MAG].window_n = 0;
-                            break;
-                        }
-
-                        radio_telem->empty_buff->mag[radio_telem->empty_buff->mag_n++] = sensor_mag;
-                        sensor_downsamples[SENSOR_MAG].output_n++;
-                        sensor_downsamples[SENSOR_MAG].out[0] = 0;
-                        sensor_downsamples[SENSOR_MAG].out[1] = 0;
-                        sensor_downsamples[SENSOR_MAG].out[2] = 0;
-                        sensor_downsamples[SENSOR_MAG].window_n = 0;
-                    }
-
-                    break;
-                }
-                case SENSOR_GNSS: {
-                    if (radio_telem->empty_buff->gnss_n == CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ) {
-                        sensor_downsamples[SENSOR_GNSS].dropped_n++;
-                        sensor_downsamples[SENSOR_GNSS].window_n = 0;
-                        break;
-                    }
-
-                    struct sensor_gnss gnss_input = ((struct sensor_gnss *)data_buf)[j];
-
-                    /*
-                    using the Welford formula to calculate the mean, one pass for each axis
-                    mean = mean_(n-1) + (x - mean_(n-1)) / n
-                    */
-                    sensor_downsamples[SENSOR_GNSS].out[0] +=
-                        (gnss_input.latitude - sensor_downsamples[SENSOR_GNSS].out[0]) /
-                        sensor_downsamples[SENSOR_GNSS].window_n;
-                    sensor_downsamples[SENSOR_GNSS].out[1] +=
-                        (gnss_input.longitude - sensor_downsamples[SENSOR_GNSS].out[1]) /
-                        sensor_downsamples[SENSOR_GNSS].window_n;
-
-                    if (sensor_downsamples[SENSOR_GNSS].window_n >= sensor_downsamples[SENSOR_GNSS].target_window_n) {
-                        struct sensor_gnss sensor_gnss = {
-                            .timestamp = gnss_input.timestamp,
-                            .latitude = sensor_downsamples[SENSOR_GNSS].out[0],
-                            .longitude = sensor_downsamples[SENSOR_GNSS].out[1],
-                        };
-
-                        if (radio_telem->empty_buff->gnss_n == CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ) {
-                            inerr("GNSS buffer full, dropping data\n");
-                            sensor_downsamples[SENSOR_GNSS].dropped_n++;
-                            sensor_downsamples[SENSOR_GNSS].window_n = 0;
-                            break;
-                        }
-
-                        radio_telem->empty_buff->gnss[radio_telem->empty_buff->gnss_n++] = sensor_gnss;
-                        sensor_downsamples[SENSOR_GNSS].output_n++;
-                        sensor_downsamples[SENSOR_GNSS].out[0] = 0;
-                        sensor_downsamples[SENSOR_GNSS].out[1] = 0;
-                        sensor_downsamples[SENSOR_GNSS].window_n = 0;
-                    }
-
-                    break;
-                }
-                case SENSOR_ALT: {
-                    if (radio_telem->empty_buff->alt_n == CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ) {
-                        sensor_downsamples[SENSOR_ALT].dropped_n++;
-                        sensor_downsamples[SENSOR_ALT].window_n = 0;
-                        break;
-                    }
-
-                    struct fusion_altitude alt_input = ((struct fusion_altitude *)data_buf)[j];
-
-                    /*
-                    using the Welford formula to calculate the mean, one pass for each axis
-                    mean = mean_(n-1) + (x - mean_(n-1)) / n
-                    */
-                    sensor_downsamples[SENSOR_ALT].out[0] +=
-                        (alt_input.altitude - sensor_downsamples[SENSOR_ALT].out[0]) /
-                        sensor_downsamples[SENSOR_ALT].window_n;
-
-                    if (sensor_downsamples[SENSOR_ALT].window_n >= sensor_downsamples[SENSOR_ALT].target_window_n) {
-                        struct fusion_altitude sensor_alt = {
-                            .timestamp = alt_input.timestamp,
-                            .altitude = sensor_downsamples[SENSOR_ALT].out[0],
-                        };
-
-                        if (radio_telem->empty_buff->alt_n == CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ) {
-                            inerr("Altitude buffer full, dropping data\n");
-                            sensor_downsamples[SENSOR_ALT].dropped_n++;
-                            sensor_downsamples[SENSOR_ALT].window_n = 0;
-                            break;
-                        }
-
-                        radio_telem->empty_buff->alt[radio_telem->empty_buff->alt_n++] = sensor_alt;
-                        sensor_downsamples[SENSOR_ALT].output_n++;
-                        sensor_downsamples[SENSOR_ALT].out[0] = 0;
-                        sensor_downsamples[SENSOR_ALT].window_n = 0;
-                    }
-                    break;
-                }
-                }
+            /* Topics that aren't downlinked still need to be read to clear the poll event */
+
+            if (downsample_descs[i].n_axes != 0) {
+                outputs += downsample_batch(&sensor_downsamples[i], &downsample_descs[i], (uint8_t *)data_buf,
+                                            err / uorb_metas[i]->o_size, uorb_metas[i]->o_size,
+                                            radio_telem_writable(radio_telem));
             }
         }
+
+        ingest_stats_wakeup(&ingest_stats, samples);
+
+        if (outputs > 0) {
+            radio_telem_publish(radio_telem);
+        }
     }
 
     publish_error(PROC_ID_DOWNSAMPLE, ERROR_PROCESS_DEAD);
     pthread_exit(0);
-}
\ No newline at end of file
+}
+
+/**
+ * Get the measured input rates of the downsampled sensors. The values are updated by the downsample thread every
+ * transmit period and are read without synchronization, so they are only for inspection.
+ *
+ * @param rates Where to store the rates
+ * @param max The number of rates that fit in `rates`
+ * @return The number of rates stored
+ */
+int downsample_get_rates(struct downsample_rate *rates, int max) {
+    int n = 0;
+    for (int i = 0; i < NUM_SENSORS && n < max; i++) {
+        if (downsample_descs[i].n_axes == 0) {
+            continue;
+        }
+        rates[n].name = uorb_metas[i]->o_name;
+        rates[n].input_hz = sensor_downsamples[i].rate.input_hz;
+        rates[n].error = sensor_downsamples[i].rate.error;
+        n++;
+    }
+    return n;
+}
+
+/* Fills in a floating point output
+ *
+ * @param desc The descriptor of the sensor
+ * @param out The output to fill in
+ * @param last The last uORB sample of the window, whose fields that aren't averaged are copied into the output
+ * @param timestamp The instant the output represents
+ * @param means One value per averaged field
+ */
+static void downsample_fill(const struct downsample_desc *desc, union downsampled_data *out, const uint8_t *last,
+                            uint64_t timestamp, const float *means) {
+    memcpy(out, last, desc->out_size);
+    *(uint64_t *)out = timestamp;
+    for (int a = 0; a < desc->n_axes; a++) {
+        *(float *)((uint8_t *)out + desc->axis_offsets[a]) = means[a];
+    }
+}
+
+/* Publishes an output and adds it to the sensor's array in the radio buffer, along with the envelope of the windows
+ * it covers. The output is still published if the radio buffer is full.
+ *
+ * @param ds The downsampling state of the sensor
+ * @param desc The descriptor of the sensor
+ * @param buff The radio buffer to add the output to
+ * @param out The output
+ * @return 1 if the output was added to the radio buffer, 0 otherwise
+ */
+static int downsample_output(sensor_downsampling_t *ds, const struct downsample_desc *desc, radio_raw_data *buff,
+                             const union downsampled_data *out) {
+    int *out_n = (int *)((uint8_t *)buff + desc->count_offset);
+
+    if (ds->pub_fd >= 0 && orb_publish(desc->topic, ds->pub_fd, out) < 0) {
+        inwarn("Failed to publish '%s': %d\n", desc->topic->o_name, errno);
+    }
+
+    if (*out_n == RADIO_DATA_LEN) {
+        ds->dropped_n++;
+        ds->env_written = 1;
+        return 0;
+    }
+
+    memcpy((uint8_t *)buff + desc->out_offset + (*out_n) * desc->out_size, out, desc->out_size);
+    if (desc->env_offset != 0) {
+        struct decimator_envelope *env = (struct decimator_envelope *)((uint8_t *)buff + desc->env_offset);
+        env[*out_n] = ds->env;
+    }
+    ds->env_written = 1;
+
+    (*out_n)++;
+    return 1;
+}
+
+/* Sets every sensor's downsampling window, expected input rate and number of outputs from its sample frequency in a
+ * rate profile and its share of the downlink in the matching downlink profile. The current windows keep their samples.
+ *
+ * @param profile The profile of the current part of the flight
+ * @param period_ms The transmit period the outputs are spread over, in milliseconds
+ */
+static void downsample_set_profile(enum odr_profile_e profile, uint32_t period_ms) {
+    for (int i = 0; i < NUM_SENSORS; i++) {
+        const struct downsample_desc *desc = &downsample_descs[i];
+        sensor_downsampling_t *ds = &sensor_downsamples[i];
+        uint32_t freq = odr_frequency(desc->odr, profile);
+        uint8_t outputs = downlink_outputs(desc->channel, profile);
+
+        if (outputs == 0) {
+            outputs = 1;
+        }
+        decimator_set_target(&ds->dec, initial_window(freq, period_ms, outputs));
+        rate_control_init(&ds->rate, outputs, freq, period_ms / 1000.0f);
+
+        /* The grid only starts over when its spacing changes */
+
+        if (desc->resample && ds->rs.period_us != resample_period_us(period_ms, outputs)) {
+            resampler_init(&ds->rs, desc->n_axes, resample_period_us(period_ms, outputs));
+        }
+    }
+}
+
+/* Adds a batch of samples to a sensor's downsampling windows, outputting each window's mean once it is full. Outputs
+ * are always published, and left out of the radio buffer while it is full.
+ *
+ * An output is a copy of the last sample in its window with the averaged fields replaced by the decimator's output,
+ * and its timestamp moved back by the decimator's group delay so it matches the instant the output represents. If the
+ * sensor's envelope is tracked, the window's range is written to the matching element of its envelope array. In fixed
+ * point mode, the averaged fields are converted to integers as they are added, and an output is only the timestamp
+ * and the integer means.
+ *
+ * Resampled sensors instead output the values interpolated at each grid instant between their last two windows.
+ *
+ * @param ds The downsampling state of the sensor
+ * @param desc The descriptor of the sensor
+ * @param samples The uORB samples to add
+ * @param n The number of samples
+ * @param sample_size The size of a uORB sample
+ * @param buff The radio buffer to write outputs into
+ * @return The number of outputs added to the radio buffer
+ */
+static int downsample_batch(sensor_downsampling_t *ds, const struct downsample_desc *desc, const uint8_t *samples,
+                            size_t n, size_t sample_size, radio_raw_data *buff) {
+    int outputs = 0;
+    union downsampled_data out;
+    const float *cols[DECIMATOR_MAX_AXES];
+    const int32_t *fixed_cols[DECIMATOR_MAX_AXES];
+    float means[DECIMATOR_MAX_AXES];
+    int32_t fixed_means[DECIMATOR_MAX_AXES];
+    size_t j = 0;
+
+    if (n == 0) {
+        return 0;
+    }
+
+    /* De-interleave the averaged fields so the decimator can work on contiguous columns */
+
+    for (int a = 0; a < desc->n_axes; a++) {
+        if (desc->mode == DECIMATOR_FIXED) {
+            for (size_t k = 0; k < n; k++) {
+                axis_buf.q[a][k] = lround(*(const float *)(samples + k * sample_size + desc->axis_offsets[a]) *
+                                          desc->fixed_scale);
+            }
+        } else {
+            for (size_t k = 0; k < n; k++) {
+                axis_buf.f[a][k] = *(const float *)(samples + k * sample_size + desc->axis_offsets[a]);
+            }
+        }
+    }
+
+    rate_control_samples(&ds->rate, sample_timestamp(samples), sample_timestamp(samples + (n - 1) * sample_size), n);
+
+    while (j < n) {
+        if (ds->dec.window_n == 0) {
+            ds->window_start = sample_timestamp(samples + j * sample_size);
+        }
+
+        if (desc->mode == DECIMATOR_FIXED) {
+            for (int a = 0; a < desc->n_axes; a++) {
+                fixed_cols[a] = &axis_buf.q[a][j];
+            }
+            j += decimator_add_block_fixed(&ds->dec, fixed_cols, n - j);
+        } else {
+            for (int a = 0; a < desc->n_axes; a++) {
+                cols[a] = &axis_buf.f[a][j];
+            }
+            j += decimator_add_block(&ds->dec, cols, n - j);
+        }
+
+        if (!decimator_full(&ds->dec)) {
+            return outputs;
+        }
+
+        /* Estimate the sample period from the window's own timestamps to convert the delay to time */
+
+        const uint8_t *last = samples + (j - 1) * sample_size;
+        uint64_t last_us = sample_timestamp(last);
+        uint64_t timestamp = last_us;
+        uint16_t window_n = ds->dec.window_n;
+        if (window_n > 1) {
+            uint64_t shift = decimator_delay(&ds->dec) * (timestamp - ds->window_start) / (window_n - 1);
+            timestamp = shift < timestamp ? timestamp - shift : 0;
+        }
+
+        /* A resampled output covers every window closed since the last one, so their envelopes are merged. The range
+         * is stamped with the middle of the raw samples it covers rather than the output's time, which the decimator's
+         * delay has moved. */
+
+        if (desc->env_offset != 0) {
+            struct decimator_envelope window_env;
+            decimator_get_envelope(&ds->dec, &window_env);
+            if (ds->env_written) {
+                ds->env = window_env;
+                ds->env_start = ds->window_start;
+                ds->env_written = 0;
+            } else {
+                for (int a = 0; a < DECIMATOR_MAX_AXES; a++) {
+                    ds->env.min[a] = window_env.min[a] < ds->env.min[a] ? window_env.min[a] : ds->env.min[a];
+                    ds->env.max[a] = window_env.max[a] > ds->env.max[a] ? window_env.max[a] : ds->env.max[a];
+                }
+            }
+            ds->env.timestamp = ds->env_start + (last_us - ds->env_start) / 2;
+        }
+        ds->output_n++;
+
+        if (desc->mode == DECIMATOR_FIXED) {
+            decimator_result_fixed(&ds->dec, fixed_means);
+            memset(&out, 0, desc->out_size);
+            *(uint64_t *)&out = timestamp;
+            for (int a = 0; a < desc->n_axes; a++) {
+                *(int32_t *)((uint8_t *)&out + desc->out_axis_offsets[a]) = fixed_means[a];
+            }
+            outputs += downsample_output(ds, desc, buff, &out);
+        } else if (desc->resample) {
+            uint64_t grid_us;
+            decimator_result(&ds->dec, means);
+            resampler_push(&ds->rs, timestamp, means);
+            while (resampler_next(&ds->rs, &grid_us, means)) {
+                downsample_fill(desc, &out, last, grid_us, means);
+                outputs += downsample_output(ds, desc, buff, &out);
+            }
+        } else {
+            decimator_result(&ds->dec, means);
+            downsample_fill(desc, &out, last, timestamp, means);
+            outputs += downsample_output(ds, desc, buff, &out);
+        }
+    }
+    return outputs;
+}
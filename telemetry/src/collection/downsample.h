@@ -3,11 +3,38 @@
 
 #include "../radio-telem.h"
 
+/* Topics the downsampled outputs are published on, for any thread that wants the downlink's data rates. GNSS outputs
+ * are struct coord_sample and altitude outputs are struct fusion_altitude, the rest are their sensor's uORB struct. */
+
+ORB_DECLARE(downsampled_accel);
+ORB_DECLARE(downsampled_gyro);
+ORB_DECLARE(downsampled_mag);
+ORB_DECLARE(downsampled_gnss);
+ORB_DECLARE(downsampled_alt);
+ORB_DECLARE(downsampled_baro);
+
+/* Queue depth of the downsampled topics, which holds the most outputs a transmit period can hold, bursts included */
+
+#define DOWNSAMPLED_QUEUE_SIZE RADIO_DATA_LEN
+
 struct downsample_args {
     rocket_state_t *state;
     radio_telem_t *radio_telem;
 };
 
+/* The most downsampled sensors whose rates downsample_get_rates() reports */
+
+#define DOWNSAMPLE_MAX_RATES 6
+
+/* The measured input rate of a downsampled sensor, and how far it was from the target number of outputs in the last
+ * transmit period */
+struct downsample_rate {
+    const char *name; /* The name of the sensor's uORB topic */
+    float input_hz;   /* The measured input sample rate */
+    float error;      /* Outputs produced in the last transmit period minus the target */
+};
+
 void *downsample_main(void *arg);
+int downsample_get_rates(struct downsample_rate *rates, int max);
 
 #endif // _INSPACE_DOWNSAMPLE_
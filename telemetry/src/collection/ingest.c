@@ -0,0 +1,105 @@
+#include <errno.h>
+
+#include "../syslogging.h"
+#include "ingest.h"
+
+/* How often wakeup statistics are reported, in seconds */
+
+#define INGEST_REPORT_PERIOD_S 10
+
+/* The fraction of a topic's queue a batch is allowed to fill, leaving room for late wakeups */
+
+#define INGEST_QUEUE_FILL 2
+
+/**
+ * Set up batched reading of a topic. The batch interval is limited so a batch fills at most half of the topic's queue,
+ * and the number of bytes to copy at once is sized to the queue so a wakeup can drain it with one copy.
+ *
+ * @param fd The subscription to the topic
+ * @param meta The metadata of the topic
+ * @param max_freq The highest frequency the topic will be published at in Hz, 0 to use its current frequency
+ * @param interval_ms The longest the topic's samples should be held back to be delivered together, 0 to not batch
+ * @param buf_size The size of the buffer samples will be copied into
+ * @return The number of bytes to copy from the topic at once
+ */
+size_t ingest_configure(int fd, const struct orb_metadata *meta, uint32_t max_freq, uint32_t interval_ms,
+                        size_t buf_size) {
+    struct orb_state state;
+    uint32_t capacity = buf_size / meta->o_size;
+    uint64_t interval_us = (uint64_t)interval_ms * 1000;
+
+    if (orb_get_state(fd, &state) < 0) {
+        inwarn("Couldn't get the state of '%s', not batching: %d\n", meta->o_name, errno);
+        return capacity * meta->o_size;
+    }
+
+    if (state.queue_size > capacity) {
+        inwarn("Queue of '%s' is %u samples but only %u fit in the copy buffer\n", meta->o_name, state.queue_size,
+               capacity);
+    } else if (state.queue_size > 0) {
+        capacity = state.queue_size;
+    }
+
+    if (max_freq == 0) {
+        max_freq = state.max_frequency;
+    }
+    if (interval_us == 0 || max_freq == 0) {
+        return capacity * meta->o_size;
+    }
+
+    /* A batch shouldn't be able to overflow the queue before it's read */
+
+    if (interval_us * max_freq > (uint64_t)capacity * 1000000 / INGEST_QUEUE_FILL) {
+        interval_us = (uint64_t)capacity * 1000000 / INGEST_QUEUE_FILL / max_freq;
+    }
+
+    ininfo("Batching '%s' every %lluus, up to %u samples per copy\n", meta->o_name, (unsigned long long)interval_us,
+           capacity);
+    if (orb_set_batch_interval(fd, interval_us) < 0) {
+        inwarn("Couldn't set batch interval of '%s': %d\n", meta->o_name, errno);
+    }
+    return capacity * meta->o_size;
+}
+
+/**
+ * Initialize wakeup statistics
+ *
+ * @param stats The statistics to initialize
+ * @param name The name of the thread they are for
+ */
+void ingest_stats_init(struct ingest_stats *stats, const char *name) {
+    stats->name = name;
+    stats->wakeups = 0;
+    stats->samples = 0;
+    stats->wakeups_hz = 0;
+    stats->samples_per_wakeup = 0;
+    clock_gettime(CLOCK_MONOTONIC, &stats->start);
+}
+
+/**
+ * Record a wakeup, reporting the statistics if a reporting period has passed
+ *
+ * @param stats The statistics of the thread that woke up
+ * @param samples The number of samples read in the wakeup
+ */
+void ingest_stats_wakeup(struct ingest_stats *stats, uint32_t samples) {
+    struct timespec now;
+    float elapsed;
+
+    stats->wakeups++;
+    stats->samples += samples;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    elapsed = (now.tv_sec - stats->start.tv_sec) + (now.tv_nsec - stats->start.tv_nsec) / 1e9f;
+    if (elapsed < INGEST_REPORT_PERIOD_S) {
+        return;
+    }
+
+    stats->wakeups_hz = stats->wakeups / elapsed;
+    stats->samples_per_wakeup = (float)stats->samples / stats->wakeups;
+    ininfo("%s: %.1f wakeups/s, %.1f samples/wakeup\n", stats->name, stats->wakeups_hz, stats->samples_per_wakeup);
+
+    stats->wakeups = 0;
+    stats->samples = 0;
+    stats->start = now;
+}
@@ -0,0 +1,24 @@
+#ifndef _INSPACE_INGEST_H_
+#define _INSPACE_INGEST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <uORB/uORB.h>
+
+/* Wakeup statistics of a thread reading uORB topics, reported periodically so the effect of batching can be seen */
+struct ingest_stats {
+    const char *name;         /* The name of the thread, used when reporting */
+    struct timespec start;    /* When the current reporting interval started */
+    uint32_t wakeups;         /* Wakeups in the current reporting interval */
+    uint32_t samples;         /* Samples read in the current reporting interval */
+    float wakeups_hz;         /* Wakeups per second in the last reporting interval */
+    float samples_per_wakeup; /* Average samples read per wakeup in the last reporting interval */
+};
+
+size_t ingest_configure(int fd, const struct orb_metadata *meta, uint32_t max_freq, uint32_t interval_ms,
+                        size_t buf_size);
+void ingest_stats_init(struct ingest_stats *stats, const char *name);
+void ingest_stats_wakeup(struct ingest_stats *stats, uint32_t samples);
+
+#endif // _INSPACE_INGEST_H_
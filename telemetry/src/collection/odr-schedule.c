@@ -0,0 +1,163 @@
+#include <errno.h>
+#include <uORB/uORB.h>
+
+#include "../syslogging.h"
+#include "odr-schedule.h"
+
+/* uORB sensor metadatas */
+
+ORB_DECLARE(sensor_accel);
+ORB_DECLARE(sensor_gyro);
+ORB_DECLARE(sensor_mag);
+ORB_DECLARE(sensor_baro);
+ORB_DECLARE(sensor_gnss);
+
+static struct orb_metadata const *odr_metas[] = {
+    [ODR_ACCEL] = ORB_ID(sensor_accel), [ODR_GYRO] = ORB_ID(sensor_gyro), [ODR_MAG] = ORB_ID(sensor_mag),
+    [ODR_BARO] = ORB_ID(sensor_baro),   [ODR_GNSS] = ORB_ID(sensor_gnss),
+};
+
+/* Sample frequencies in Hz of each sensor in each profile */
+
+static const uint32_t odr_rates[ODR_NUM_PROFILES][ODR_NUM_SENSORS] = {
+    [ODR_PROFILE_IDLE] =
+        {
+            [ODR_ACCEL] = CONFIG_INSPACE_TELEMETRY_IDLE_ACCEL_SF,
+            [ODR_GYRO] = CONFIG_INSPACE_TELEMETRY_IDLE_GYRO_SF,
+            [ODR_MAG] = CONFIG_INSPACE_TELEMETRY_IDLE_MAG_SF,
+            [ODR_BARO] = CONFIG_INSPACE_TELEMETRY_IDLE_BARO_SF,
+            [ODR_GNSS] = CONFIG_INSPACE_TELEMETRY_IDLE_GPS_SF,
+        },
+    [ODR_PROFILE_ASCENT] =
+        {
+            [ODR_ACCEL] = CONFIG_INSPACE_TELEMETRY_ACCEL_SF,
+            [ODR_GYRO] = CONFIG_INSPACE_TELEMETRY_GYRO_SF,
+            [ODR_MAG] = CONFIG_INSPACE_TELEMETRY_MAG_SF,
+            [ODR_BARO] = CONFIG_INSPACE_TELEMETRY_BARO_SF,
+            [ODR_GNSS] = CONFIG_INSPACE_TELEMETRY_GPS_SF,
+        },
+    [ODR_PROFILE_DESCENT] =
+        {
+            [ODR_ACCEL] = CONFIG_INSPACE_TELEMETRY_DESCENT_ACCEL_SF,
+            [ODR_GYRO] = CONFIG_INSPACE_TELEMETRY_DESCENT_GYRO_SF,
+            [ODR_MAG] = CONFIG_INSPACE_TELEMETRY_DESCENT_MAG_SF,
+            [ODR_BARO] = CONFIG_INSPACE_TELEMETRY_DESCENT_BARO_SF,
+            [ODR_GNSS] = CONFIG_INSPACE_TELEMETRY_DESCENT_GPS_SF,
+        },
+    [ODR_PROFILE_LANDED] =
+        {
+            [ODR_ACCEL] = CONFIG_INSPACE_TELEMETRY_LANDED_ACCEL_SF,
+            [ODR_GYRO] = CONFIG_INSPACE_TELEMETRY_LANDED_GYRO_SF,
+            [ODR_MAG] = CONFIG_INSPACE_TELEMETRY_LANDED_MAG_SF,
+            [ODR_BARO] = CONFIG_INSPACE_TELEMETRY_LANDED_BARO_SF,
+            [ODR_GNSS] = CONFIG_INSPACE_TELEMETRY_LANDED_GPS_SF,
+        },
+};
+
+#if defined(CONFIG_INSPACE_SYSLOG_OUTPUT)
+static const char *ODR_PROFILES[] = {
+    [ODR_PROFILE_IDLE] = "idle",
+    [ODR_PROFILE_ASCENT] = "ascent",
+    [ODR_PROFILE_DESCENT] = "descent",
+    [ODR_PROFILE_LANDED] = "landed",
+};
+#endif
+
+/**
+ * Get the rate profile of a flight state
+ *
+ * @param state The flight state
+ * @param substate The flight substate
+ * @return The profile sensors should be sampled with in the flight state
+ */
+enum odr_profile_e odr_profile(enum flight_state_e state, enum flight_substate_e substate) {
+    switch (state) {
+    case STATE_IDLE:
+        return ODR_PROFILE_IDLE;
+    case STATE_LANDED:
+        return ODR_PROFILE_LANDED;
+    default:
+        /* An unknown substate could be anywhere in the flight, so it gets the highest rates */
+
+        return substate == SUBSTATE_DESCENT ? ODR_PROFILE_DESCENT : ODR_PROFILE_ASCENT;
+    }
+}
+
+/**
+ * Get the frequency a sensor is sampled at in a profile
+ *
+ * @param sensor The sensor
+ * @param profile The rate profile
+ * @return The sample frequency in Hz
+ */
+uint32_t odr_frequency(enum odr_sensor_e sensor, enum odr_profile_e profile) { return odr_rates[profile][sensor]; }
+
+/**
+ * Get the highest frequency a sensor is sampled at in any profile, for sizing anything that has to keep up with it
+ *
+ * @param sensor The sensor
+ * @return The highest sample frequency in Hz
+ */
+uint32_t odr_max_frequency(enum odr_sensor_e sensor) {
+    uint32_t max = 0;
+    for (int p = 0; p < ODR_NUM_PROFILES; p++) {
+        max = odr_rates[p][sensor] > max ? odr_rates[p][sensor] : max;
+    }
+    return max;
+}
+
+/**
+ * Subscribe to the sensors whose rates are scheduled. No profile is applied until odr_schedule_apply is called.
+ *
+ * @param sched The schedule to initialize
+ */
+void odr_schedule_init(struct odr_schedule *sched) {
+    sched->profile = -1;
+    for (int i = 0; i < ODR_NUM_SENSORS; i++) {
+        sched->fds[i] = orb_subscribe(odr_metas[i]);
+        if (sched->fds[i] < 0) {
+            inerr("Failed to subscribe to '%s' to set its rate: %d\n", odr_metas[i]->o_name, errno);
+        }
+    }
+}
+
+/**
+ * Set every sensor to its frequency in a profile. Does nothing if the profile is already applied, so it can be called
+ * whenever the flight state may have changed.
+ *
+ * @param sched The schedule to apply the profile with
+ * @param profile The profile to apply
+ * @return 0 on success, or the negative error code of the last sensor that couldn't be set
+ */
+int odr_schedule_apply(struct odr_schedule *sched, enum odr_profile_e profile) {
+    int err = 0;
+
+    if (sched->profile == profile) {
+        return 0;
+    }
+    sched->profile = profile;
+
+#ifndef CONFIG_INSPACE_MOCKING
+    /* NOTE: setting frequencies when mocking will break some flight records
+     * since all measurements in the CSV are synced line to line, so if we set
+     * accel to be faster than barometer, the measurements will be out of sync
+     * chronologically. Hence, disable frequency configurations when mocking.
+     */
+
+    ininfo("Applying %s sensor rates\n", ODR_PROFILES[profile]);
+    for (int i = 0; i < ODR_NUM_SENSORS; i++) {
+        if (sched->fds[i] < 0) {
+            continue;
+        }
+
+        indebug("Setting frequency of '%s' to %luHz\n", odr_metas[i]->o_name, odr_rates[profile][i]);
+        if (orb_set_frequency(sched->fds[i], odr_rates[profile][i]) < 0) {
+            err = -errno;
+            inerr("Failed to set frequency of '%s' to %luHz: %d\n", odr_metas[i]->o_name, odr_rates[profile][i],
+                  errno);
+        }
+    }
+#endif
+
+    return err;
+}
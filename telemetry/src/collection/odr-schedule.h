@@ -0,0 +1,42 @@
+#ifndef _INSPACE_ODR_SCHEDULE_H_
+#define _INSPACE_ODR_SCHEDULE_H_
+
+#include <stdint.h>
+
+#include "../rocket-state/rocket-state.h"
+
+/* Sensors whose output data rate follows the flight state */
+
+enum odr_sensor_e {
+    ODR_ACCEL = 0, /* Accelerometer */
+    ODR_GYRO = 1,  /* Gyroscope */
+    ODR_MAG = 2,   /* Magnetometer */
+    ODR_BARO = 3,  /* Barometer, which also sets the rate of fusion altitude */
+    ODR_GNSS = 4,  /* GNSS */
+    ODR_NUM_SENSORS,
+};
+
+/* Sets of sensor rates, one for each part of a flight */
+
+enum odr_profile_e {
+    ODR_PROFILE_IDLE = 0,    /* On the pad, waiting for liftoff */
+    ODR_PROFILE_ASCENT = 1,  /* Airborne before apogee, or airborne in an unknown substate */
+    ODR_PROFILE_DESCENT = 2, /* Airborne after apogee */
+    ODR_PROFILE_LANDED = 3,  /* Landed, until the flight data is copied out */
+    ODR_NUM_PROFILES,
+};
+
+/* Sets sensor sample frequencies from the profile of the current flight state. Holds its own subscriptions so the
+ * rates it requests don't depend on any other thread's. */
+struct odr_schedule {
+    int fds[ODR_NUM_SENSORS]; /* Subscriptions used to set each sensor's frequency, negative if unavailable */
+    int8_t profile;           /* The profile that was last applied, negative if none has been */
+};
+
+enum odr_profile_e odr_profile(enum flight_state_e state, enum flight_substate_e substate);
+uint32_t odr_frequency(enum odr_sensor_e sensor, enum odr_profile_e profile);
+uint32_t odr_max_frequency(enum odr_sensor_e sensor);
+void odr_schedule_init(struct odr_schedule *sched);
+int odr_schedule_apply(struct odr_schedule *sched, enum odr_profile_e profile);
+
+#endif // _INSPACE_ODR_SCHEDULE_H_
@@ -0,0 +1,93 @@
+#include <math.h>
+
+#include "rate-control.h"
+
+/* Weight given to the newest measurement of the input rate and transmit period */
+
+#define RATE_SMOOTHING 0.3f
+
+/* How strongly past output errors correct the number of outputs aimed for */
+
+#define RATE_INTEGRAL_GAIN 0.3f
+
+/**
+ * Initialize a rate controller
+ *
+ * @param rc The rate controller to initialize
+ * @param target The number of outputs wanted every transmit period
+ * @param input_hz The expected input sample rate, used until it is measured
+ * @param period_s The expected transmit period in seconds, used until it is measured
+ */
+void rate_control_init(struct rate_control *rc, uint16_t target, float input_hz, float period_s) {
+    rc->input_hz = input_hz;
+    rc->period_s = period_s;
+    rc->error = 0;
+    rc->integral = 0;
+    rc->first_us = 0;
+    rc->last_us = 0;
+    rc->samples = 0;
+    rc->target = target;
+}
+
+/**
+ * Record a batch of input samples
+ *
+ * @param rc The rate controller of the sensor the samples are from
+ * @param first_us The timestamp of the first sample in the batch
+ * @param last_us The timestamp of the last sample in the batch
+ * @param n The number of samples in the batch
+ */
+void rate_control_samples(struct rate_control *rc, uint64_t first_us, uint64_t last_us, uint32_t n) {
+    if (n == 0) {
+        return;
+    }
+
+    /* Intervals are counted from the last sample seen, the very first sample only starts the count */
+
+    if (rc->last_us == 0) {
+        rc->first_us = first_us;
+        n--;
+    }
+    rc->samples += n;
+    rc->last_us = last_us;
+}
+
+/**
+ * Update the measurements at the end of a transmit period and choose the window for the next one
+ *
+ * @param rc The rate controller to update
+ * @param period_s The measured length of the period that ended in seconds, 0 if unknown
+ * @param outputs The number of outputs produced in the period, including any that would have been if the radio buffer
+ * wasn't full
+ * @return The number of input samples to put in each downsampling window
+ */
+uint16_t rate_control_update(struct rate_control *rc, float period_s, float outputs) {
+    float expected = rc->target;
+    float desired;
+    float window;
+
+    if (rc->samples > 0 && rc->last_us > rc->first_us) {
+        float measured = rc->samples * 1e6f / (rc->last_us - rc->first_us);
+        rc->input_hz += RATE_SMOOTHING * (measured - rc->input_hz);
+    }
+
+    /* A period shorter or longer than usual only had time for proportionally fewer or more outputs, which isn't an
+     * error of the window and mustn't wind up the integral */
+
+    if (period_s > 0) {
+        expected = rc->target * period_s / rc->period_s;
+        rc->period_s += RATE_SMOOTHING * (period_s - rc->period_s);
+    }
+
+    /* Aim for more outputs after periods that fell short, and fewer after ones that went over */
+
+    rc->error = outputs - expected;
+    rc->integral = fminf(fmaxf(rc->integral + rc->error, -rc->target), rc->target);
+    desired = fminf(fmaxf(rc->target - RATE_INTEGRAL_GAIN * rc->integral, 0.5f), 2.0f * rc->target);
+
+    rc->first_us = rc->last_us;
+    rc->samples = 0;
+
+    window = roundf(rc->input_hz * rc->period_s / desired);
+    return window < 1 ? 1 : (window > UINT16_MAX ? UINT16_MAX : window);
+}
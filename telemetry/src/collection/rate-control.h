@@ -0,0 +1,25 @@
+#ifndef _INSPACE_RATE_CONTROL_H_
+#define _INSPACE_RATE_CONTROL_H_
+
+#include <stdint.h>
+
+/* Chooses a sensor's downsampling window so it produces a target number of outputs every transmit period. The input
+ * rate is measured from sample timestamps, and the number of outputs actually produced each period is fed back so
+ * rounding and phase errors don't accumulate.
+ */
+struct rate_control {
+    float input_hz;     /* Smoothed input sample rate measured from timestamps */
+    float period_s;     /* Smoothed length of a transmit period */
+    float error;        /* Outputs produced minus those the last period had time for */
+    float integral;     /* Sum of past errors, used to correct the target */
+    uint64_t first_us;  /* Timestamp of the first sample seen this period */
+    uint64_t last_us;   /* Timestamp of the last sample seen this period */
+    uint32_t samples;   /* Samples seen this period */
+    uint16_t target;    /* Outputs wanted every period */
+};
+
+void rate_control_init(struct rate_control *rc, uint16_t target, float input_hz, float period_s);
+void rate_control_samples(struct rate_control *rc, uint64_t first_us, uint64_t last_us, uint32_t n);
+uint16_t rate_control_update(struct rate_control *rc, float period_s, float outputs);
+
+#endif // _INSPACE_RATE_CONTROL_H_
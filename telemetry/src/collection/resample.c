@@ -0,0 +1,70 @@
+#include <string.h>
+
+#include "resample.h"
+
+/* The longest gap between window outputs that is interpolated across, in grid periods. Longer gaps mean the sensor
+ * stopped, so grid instants inside them are skipped instead of being filled with a made up line. */
+
+#define RESAMPLE_MAX_GAP 4
+
+/**
+ * Initialize a resampler
+ *
+ * @param rs The resampler to initialize
+ * @param n_axes The number of axes in each output, at most DECIMATOR_MAX_AXES
+ * @param period_us The spacing of the output grid in microseconds, the same for every channel that should line up
+ */
+void resampler_init(struct resampler *rs, uint8_t n_axes, uint32_t period_us) {
+    memset(rs, 0, sizeof(*rs));
+    rs->n_axes = n_axes > DECIMATOR_MAX_AXES ? DECIMATOR_MAX_AXES : n_axes;
+    rs->period_us = period_us > 0 ? period_us : 1;
+}
+
+/**
+ * Add a window output. Any grid instants it makes available are then produced by resampler_next.
+ *
+ * @param rs The resampler to add to
+ * @param timestamp The instant the output represents in microseconds, after the previous output's
+ * @param values One value per axis
+ */
+void resampler_push(struct resampler *rs, uint64_t timestamp, const float *values) {
+    int restart =
+        rs->next_us == 0 || timestamp <= rs->cur_us || timestamp - rs->cur_us > RESAMPLE_MAX_GAP * rs->period_us;
+
+    rs->prev_us = rs->cur_us;
+    rs->cur_us = timestamp;
+    memcpy(rs->prev, rs->cur, sizeof(rs->prev));
+    memcpy(rs->cur, values, rs->n_axes * sizeof(float));
+
+    /* Without a previous output to interpolate from, start at the first grid instant this output reaches */
+
+    if (restart) {
+        rs->prev_us = timestamp;
+        memcpy(rs->prev, rs->cur, sizeof(rs->prev));
+        rs->next_us = (timestamp + rs->period_us - 1) / rs->period_us * rs->period_us;
+    }
+}
+
+/**
+ * Produce the next grid instant between the last two window outputs
+ *
+ * @param rs The resampler to produce from
+ * @param timestamp Where to write the grid instant in microseconds
+ * @param values Where to write the interpolated value of each axis
+ * @return 1 if a grid instant was produced, 0 if there are none until the next push
+ */
+int resampler_next(struct resampler *rs, uint64_t *timestamp, float *values) {
+    float frac;
+
+    if (rs->next_us == 0 || rs->next_us > rs->cur_us) {
+        return 0;
+    }
+
+    frac = rs->cur_us == rs->prev_us ? 1.0f : (float)(rs->next_us - rs->prev_us) / (rs->cur_us - rs->prev_us);
+    for (int a = 0; a < rs->n_axes; a++) {
+        values[a] = rs->prev[a] + frac * (rs->cur[a] - rs->prev[a]);
+    }
+    *timestamp = rs->next_us;
+    rs->next_us += rs->period_us;
+    return 1;
+}
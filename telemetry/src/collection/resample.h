@@ -0,0 +1,26 @@
+#ifndef _INSPACE_RESAMPLE_H_
+#define _INSPACE_RESAMPLE_H_
+
+#include <stdint.h>
+
+#include "decimator.h"
+
+/* Resamples a channel's window outputs onto a grid of instants shared by every channel, by linear interpolation
+ * between consecutive outputs. The grid is every multiple of the grid period since boot, so channels resampled with
+ * the same period produce outputs with identical timestamps however their windows line up.
+ */
+struct resampler {
+    uint64_t period_us;             /* The spacing of the grid */
+    uint64_t next_us;               /* The next grid instant to produce, 0 before the first output */
+    uint64_t prev_us;               /* Timestamp of the previous window output */
+    uint64_t cur_us;                /* Timestamp of the latest window output */
+    float prev[DECIMATOR_MAX_AXES]; /* Values of the previous window output */
+    float cur[DECIMATOR_MAX_AXES];  /* Values of the latest window output */
+    uint8_t n_axes;                 /* The number of axes being resampled */
+};
+
+void resampler_init(struct resampler *rs, uint8_t n_axes, uint32_t period_us);
+void resampler_push(struct resampler *rs, uint64_t timestamp, const float *values);
+int resampler_next(struct resampler *rs, uint64_t *timestamp, float *values);
+
+#endif // _INSPACE_RESAMPLE_H_
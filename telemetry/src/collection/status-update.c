@@ -1,4 +1,5 @@
-
+#include <errno.h>
+#include <pthread.h>
 #include <uORB/uORB.h>
 
 #include "../syslogging.h"
@@ -15,6 +16,37 @@ ORB_DEFINE(error_message, struct error_message, 0);
 ORB_DEFINE(status_message, struct status_message, 0);
 #endif
 
+/* The event topics, advertised by whichever thread publishes on them first */
+
+static pthread_mutex_t event_lock = PTHREAD_MUTEX_INITIALIZER;
+static int status_fd = -1;
+static int error_fd = -1;
+
+/* Publish an event on a topic queued deep enough that the transmit thread can read every event published between two
+ * packets, not just the latest. The topic is advertised persistent on the first event so that events published before
+ * anything subscribes are still there for late subscribers.
+ *
+ * @param meta The topic
+ * @param fd The topic's advertised file descriptor, or -1 if it hasn't been advertised yet
+ * @param msg The event
+ * @return 0 if the event was published successfully, or a negative error code on failure
+ */
+static int publish_event(const struct orb_metadata *meta, int *fd, const void *msg) {
+    int err = 0;
+
+    pthread_mutex_lock(&event_lock);
+    if (*fd < 0) {
+        *fd = orb_advertise_multi_queue_persist(meta, msg, NULL, STATUS_QUEUE_LEN);
+        if (*fd < 0) {
+            err = -errno;
+        }
+    } else if (orb_publish(meta, *fd, msg) < 0) {
+        err = -errno;
+    }
+    pthread_mutex_unlock(&event_lock);
+    return err;
+}
+
 /**
  * Publish a status message
  *
@@ -23,7 +55,7 @@ ORB_DEFINE(status_message, struct status_message, 0);
  */
 int publish_status(enum status_code_e status_code) {
     struct status_message status = {.timestamp = orb_absolute_time(), .status_code = status_code};
-    return orb_publish_auto(ORB_ID(status_message), NULL, &status, NULL);
+    return publish_event(ORB_ID(status_message), &status_fd, &status);
 }
 
 /**
@@ -35,5 +67,5 @@ int publish_status(enum status_code_e status_code) {
 int publish_error(enum process_id_e proc_id, enum error_code_e error_code) {
     struct error_message error = {.timestamp = orb_absolute_time(), .proc_id = proc_id, .error_code = error_code};
     ininfo("Publishing an error message for process %d with code %d\n", proc_id, error_code);
-    return orb_publish_auto(ORB_ID(error_message), NULL, &error, NULL);
+    return publish_event(ORB_ID(error_message), &error_fd, &error);
 }
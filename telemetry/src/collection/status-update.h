@@ -5,6 +5,10 @@
 
 #include "uORB/uORB.h"
 
+/* The number of status or error messages uORB holds until they're read */
+
+#define STATUS_QUEUE_LEN CONFIG_INSPACE_TELEMETRY_EVENT_QUEUE_LEN
+
 /* Possible status codes */
 enum status_code_e {
     STATUS_SYSTEMS_NOMINAL = 0x00, /* All systems nominal */
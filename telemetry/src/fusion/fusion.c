@@ -4,6 +4,7 @@
 #include <pthread.h>
 #include <sys/ioctl.h>
 
+#include "../collection/odr-schedule.h"
 #include "../collection/status-update.h"
 #include "../rocket-state/rocket-state.h"
 #include "../syslogging.h"
@@ -55,6 +56,7 @@ void *fusion_main(void *arg) {
     struct sensor_baro baro_data[BARO_INPUT_BUFFER_SIZE];
     struct sensor_accel accel_data[ACCEL_INPUT_BUFFER_SIZE];
     struct detector detector;
+    struct odr_schedule odr;
     struct fusion_altitude calculated_altitude;
     struct accel_sample calculated_accel_mag;
     struct pollfd fds[2] = {
@@ -82,6 +84,12 @@ void *fusion_main(void *arg) {
 
     ininfo("Fusion topics subscribed.\n");
 
+    /* Sensor rates follow the flight state. They are set from here since this thread detects the state changes, so
+     * the new rates take effect on the sample that caused them. */
+
+    odr_schedule_init(&odr);
+    odr_schedule_apply(&odr, odr_profile(flight_state, flight_substate));
+
     detector_init(&detector, orb_absolute_time());
     detector_set_state(&detector, flight_state, flight_substate);
 
@@ -128,6 +136,7 @@ void *fusion_main(void *arg) {
             state_get_flightstate(state, &flight_state);
             state_get_flightsubstate(state, &flight_substate);
             publish_state_update(flight_state, flight_substate);
+            odr_schedule_apply(&odr, odr_profile(flight_state, flight_substate));
 
             /* NOTE: This is how the detector gets set into the IDLE state by the logging thread */
             detector_set_state(&detector, flight_state, flight_substate);
@@ -141,6 +150,9 @@ void *fusion_main(void *arg) {
 
             state_get_flightstate(state, &flight_state);
             if (flight_state == STATE_IDLE) {
+                /* Raise the sensor rates first, logging and writing the state to NV storage are slow */
+
+                odr_schedule_apply(&odr, ODR_PROFILE_ASCENT);
                 ininfo("Changing to SUBSTATE_ASCENT, altitude is %f and acceleration is %f\n",
                        detector_get_alt(&detector), detector_get_accel(&detector));
                 state_set_flightstate(state, STATE_AIRBORNE);
@@ -155,6 +167,7 @@ void *fusion_main(void *arg) {
 
             state_get_flightstate(state, &flight_state);
             if (flight_state == STATE_AIRBORNE) {
+                odr_schedule_apply(&odr, ODR_PROFILE_DESCENT);
                 ininfo("Changing to SUBSTATE_DESCENT, altitude is %f and acceleration is %f\n",
                        detector_get_alt(&detector), detector_get_accel(&detector));
                 state_set_flightsubstate(state, SUBSTATE_DESCENT);
@@ -169,6 +182,7 @@ void *fusion_main(void *arg) {
         case DETECTOR_LANDING_EVENT: {
             /* We can set to landing from anywhere */
 
+            odr_schedule_apply(&odr, ODR_PROFILE_LANDED);
             ininfo("Changing to STATE_LANDED, altitude is %f and acceleration is %f\n", detector_get_alt(&detector),
                    detector_get_accel(&detector));
             state_set_flightstate(state, STATE_LANDED);
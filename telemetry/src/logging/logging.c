@@ -15,6 +15,8 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "../collection/ingest.h"
+#include "../collection/odr-schedule.h"
 #include "../collection/status-update.h"
 #include "../packets/packets.h"
 #include "../syslogging.h"
@@ -105,6 +107,25 @@ static struct orb_metadata const *uorb_metas[] = {
 
 #define NUM_SENSORS (sizeof(uorb_fds) / sizeof(uorb_fds[0]))
 
+/* The sensor whose rate profile each sensor topic follows */
+
+static const uint8_t odr_sensors[] = {
+    [SENSOR_ACCEL] = ODR_ACCEL, [SENSOR_GYRO] = ODR_GYRO, [SENSOR_MAG] = ODR_MAG,
+    [SENSOR_GNSS] = ODR_GNSS,   [SENSOR_ALT] = ODR_BARO,  [SENSOR_BARO] = ODR_BARO,
+};
+
+/* Data buffer for copying uORB data */
+
+static union uorb_data data_buf[CONFIG_INSPACE_TELEMETRY_LOG_COPY_BUFFER / sizeof(union uorb_data)];
+
+/* The number of bytes copied from each topic at once, sized to its queue */
+
+static size_t copy_lens[NUM_SENSORS];
+
+/* Wakeup statistics of the logging thread */
+
+static struct ingest_stats ingest_stats;
+
 static int log_buffer(FILE *storage, uint8_t *buffer, size_t buffer_size);
 static int clear_file(FILE *to_clear);
 static int try_open_file(FILE **file_to_open, const char *filename, const char *open_option);
@@ -153,7 +174,20 @@ void *logging_main(void *arg) {
         }
     }
 
-    union uorb_data data_buf[10];
+    /* Batch sensor samples so each wakeup logs several of them, sized for the highest rate of any flight state. Status
+     * and error messages are rare and logged as soon as they arrive. */
+
+    for (int i = 0; i < NUM_SENSORS; i++) {
+        if (uorb_fds[i].fd < 0) {
+            continue;
+        } else if (i < STATUS_MESSAGE) {
+            copy_lens[i] = ingest_configure(uorb_fds[i].fd, uorb_metas[i], odr_max_frequency(odr_sensors[i]),
+                                            CONFIG_INSPACE_TELEMETRY_LOG_BATCH_MS, sizeof(data_buf));
+        } else {
+            copy_lens[i] = ingest_configure(uorb_fds[i].fd, uorb_metas[i], 0, 0, sizeof(data_buf));
+        }
+    }
+    ingest_stats_init(&ingest_stats, "logging");
 
     struct timespec current_time;
     clock_gettime(CLOCK_REALTIME, &current_time);
@@ -165,6 +199,8 @@ void *logging_main(void *arg) {
     for (;;) {
         poll(uorb_fds, NUM_SENSORS, -1);
 
+        uint32_t samples = 0;
+
         for (int i = 0; i < NUM_SENSORS; i++) {
 
             /* Skip invalid sensors and sensors without new data */
@@ -175,11 +211,14 @@ void *logging_main(void *arg) {
 
             uorb_fds[i].revents = 0; /* Mark the event as handled */
 
-            err = orb_copy_multi(uorb_fds[i].fd, &data_buf, sizeof(data_buf));
+            /* Anything left queued after the copy keeps the topic ready, so it's read on the next poll */
+
+            err = orb_copy_multi(uorb_fds[i].fd, data_buf, copy_lens[i]);
             if (err < 0) {
                 inerr("Error reading data from %s: %d\n", uorb_metas[i]->o_name, err);
                 continue;
             }
+            samples += err / uorb_metas[i]->o_size;
 
             for (int j = 0; j < (err / uorb_metas[i]->o_size); j++) {
                 /* we write the header and body separately to reduce memory copies, in the case the header write
@@ -270,6 +309,8 @@ void *logging_main(void *arg) {
                 }
             }
         }
+
+        ingest_stats_wakeup(&ingest_stats, samples);
     }
 
 err_cleanup:
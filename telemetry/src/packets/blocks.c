@@ -0,0 +1,169 @@
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "packets.h"
+
+/* The size of every block body is the sum of its fields, so the structs match the packet specification */
+
+#define BLOCK_FIELD_SIZE(body, type, sign, field, unit, scale, source) +sizeof(type)
+#define BLOCK_ARRAY_SIZE(body, type, sign, field, count, unit) +(count) * sizeof(type)
+#define BLOCK_SIZE_ASSERT(name)                                                                                        \
+    _Static_assert(sizeof(struct name##_t) == sizeof(int16_t) name##_fields(BLOCK_FIELD_SIZE, BLOCK_ARRAY_SIZE, name), \
+                   #name " must have no padding");                                                                     \
+    _Static_assert(sizeof(blk_hdr_t) + sizeof(struct name##_t) <= BLOCK_MAX_SIZE, #name " must fit in a block");
+
+BLOCK_BODIES(BLOCK_SIZE_ASSERT)
+
+#define BLOCK_COUNT(type, id, body, sample, description) +1
+
+_Static_assert(DATA_RES_ABOVE == 0 BLOCK_TYPES(BLOCK_COUNT), "Block type ids must run on from 0 without gaps");
+_Static_assert(sizeof(struct axes_blk_t) == sizeof(struct accel_blk_t) &&
+                   sizeof(struct axes_blk_t) == sizeof(struct ang_vel_blk_t),
+               "Delta encoded samples must decode to fixed size blocks");
+
+/* The fields of every block body */
+
+#define BLOCK_FIELD_DESC(body, type, sign, field, unit, scale, source)                                                 \
+    {#field, unit, offsetof(struct body##_t, field), sizeof(type), 1, sign},
+#define BLOCK_ARRAY_DESC(body, type, sign, field, count, unit)                                                         \
+    {#field, unit, offsetof(struct body##_t, field), sizeof(type), count, sign},
+#define BLOCK_FIELD_TABLE(name)                                                                                        \
+    static const struct block_field name##_fields_table[] = {                                                          \
+        {"time_offset", "ms", offsetof(struct name##_t, time_offset), sizeof(int16_t), 1, BLOCK_SIGNED},               \
+        name##_fields(BLOCK_FIELD_DESC, BLOCK_ARRAY_DESC, name)};
+
+BLOCK_BODIES(BLOCK_FIELD_TABLE)
+
+/* The layout of every block body. Bodies that are only ever decoded into, like axes_blk, aren't in the block table. */
+
+#define BLOCK_BODY_DESC(name)                                                                                          \
+    __attribute__((unused)) static const struct block_body_desc name##_desc = {                                        \
+        #name "_t", sizeof(struct name##_t), name##_fields_table,                                                      \
+        sizeof(name##_fields_table) / sizeof(name##_fields_table[0])};
+
+BLOCK_BODIES(BLOCK_BODY_DESC)
+
+/* Every block type, indexed by its id */
+
+#define BLOCK_DESC(type, id, body, sample, description) [type] = {#type, description, &body##_desc, &sample##_desc},
+
+static const struct block_desc block_descs[DATA_RES_ABOVE] = {BLOCK_TYPES(BLOCK_DESC)};
+
+/**
+ * Get the description of a block type
+ *
+ * @param type The block type
+ * @return The block type's name, description and layout, or NULL if it isn't a known type
+ */
+const struct block_desc *block_desc(enum block_type_e type) {
+    if ((unsigned)type >= DATA_RES_ABOVE) {
+        return NULL;
+    }
+    return &block_descs[type];
+}
+
+/**
+ * Read one of the values of a field of a block body
+ *
+ * @param body The block body
+ * @param field The field, from the body's layout
+ * @param i The index of the value, 0 for fields that aren't arrays
+ * @param value Where to store the value
+ * @return 0 on success, or -ERANGE if the field has no value i
+ */
+int block_field_value(const void *body, const struct block_field *field, int i, int64_t *value) {
+    const uint8_t *at;
+
+    if (i < 0 || i >= field->count) {
+        return -ERANGE;
+    }
+
+    at = (const uint8_t *)body + field->offset + i * field->size;
+    switch (field->size) {
+    case sizeof(uint8_t): {
+        uint8_t raw = *at;
+        *value = field->is_signed ? (int8_t)raw : raw;
+        return 0;
+    }
+    case sizeof(uint16_t): {
+        uint16_t raw;
+        memcpy(&raw, at, sizeof(raw));
+        *value = field->is_signed ? (int16_t)raw : raw;
+        return 0;
+    }
+    case sizeof(uint32_t): {
+        uint32_t raw;
+        memcpy(&raw, at, sizeof(raw));
+        *value = field->is_signed ? (int64_t)(int32_t)raw : (int64_t)raw;
+        return 0;
+    }
+    default:
+        return -ERANGE;
+    }
+}
+
+/**
+ * Decode a data packet, passing each sample of each of its blocks to a callback in the order they were packed. Delta
+ * encoded blocks are expanded into their samples. Parity packets have to be recovered into the data packet they stand
+ * in for first.
+ *
+ * @param packet The packet
+ * @param len The length of the packet
+ * @param on_sample Called with each sample
+ * @param arg Passed to on_sample
+ * @return 0 once every sample has been passed, whatever non-zero value on_sample stopped decoding with, or -EINVAL if
+ * the packet is malformed
+ */
+int packet_decode(const uint8_t *packet, size_t len, block_sample_f on_sample, void *arg) {
+    const pkt_hdr_t *header = (const pkt_hdr_t *)packet;
+    const uint8_t *at = packet + sizeof(pkt_hdr_t);
+    const uint8_t *end = packet + len;
+    int err;
+
+    if (len < sizeof(pkt_hdr_t) || len > PACKET_MAX_SIZE) {
+        return -EINVAL;
+    }
+
+    for (int b = 0; b < header->type_count; b++) {
+        const blk_hdr_t *block = (const blk_hdr_t *)at;
+        const struct block_desc *desc;
+
+        if (end - at < (ptrdiff_t)sizeof(blk_hdr_t) || (desc = block_desc(block->type)) == NULL) {
+            return -EINVAL;
+        }
+        at += sizeof(blk_hdr_t);
+
+        /* Blocks whose samples decode to a different body are delta encoded */
+
+        if (desc->sample != desc->body) {
+            struct axes_blk_t samples[UINT8_MAX];
+            int body_len = delta_blk_decode(at, end - at, block->count, samples);
+
+            if (body_len < 0) {
+                return body_len;
+            }
+            for (int i = 0; i < block->count; i++) {
+                err = on_sample(arg, block->type, desc->sample, &samples[i]);
+                if (err) {
+                    return err;
+                }
+            }
+            at += body_len;
+            continue;
+        }
+
+        if ((size_t)(end - at) < block->count * desc->body->len) {
+            return -EINVAL;
+        }
+        for (int i = 0; i < block->count; i++) {
+            err = on_sample(arg, block->type, desc->body, at);
+            if (err) {
+                return err;
+            }
+            at += desc->body->len;
+        }
+    }
+
+    return at == end ? 0 : -EINVAL;
+}
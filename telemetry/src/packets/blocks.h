@@ -0,0 +1,186 @@
+#ifndef _INSPACE_TELEMETRY_BLOCKS_H_
+#define _INSPACE_TELEMETRY_BLOCKS_H_
+
+/* The registry of every block the telemetry sends. packets.h and blocks.c expand it into the block type ids, the block
+ * body structs and their initializers, the size table and its static asserts, the encoders from uORB samples and the
+ * field tables the decoder reads packets with. Adding a block type only takes a body below, if it needs a new one, and
+ * an entry in BLOCK_TYPES, plus one in BLOCK_ENCODERS if it's encoded from a single sample. */
+
+/* Unit conversions fields are scaled with when they're encoded */
+
+#define as_is(value) (value)
+#define us_to_ms(us) (us / 1000)
+#define pascals(millibar) (millibar * 100)
+#define millimeters(meters) (meters * 1000)
+#define tenth_degree(radian) (radian * 1800 / M_PI)
+#define tenth_microtesla(microtesla) (microtesla * 10)
+#define cm_per_sec_squared(meters_per_sec_squared) (meters_per_sec_squared * 100)
+#define millidegrees(celsius) (celsius * 1000)
+
+/* The fields of each block body after its time offset, which is the offset from the absolute time in the packet
+ * header in milliseconds. A body `name` is struct name_t, and name_fields(FIELD, ARRAY, name) lists its fields as
+ * FIELD(name, type, sign, field, unit, scale, source) for single values, encoded as scale(sample->source), and
+ * ARRAY(name, type, sign, field, count, unit) for arrays, which are never encoded from a single sample. `sign` is
+ * BLOCK_SIGNED or BLOCK_UNSIGNED, matching the type, so decoders know how to widen the field's values. */
+
+#define BLOCK_SIGNED true
+#define BLOCK_UNSIGNED false
+
+/* Altitude */
+
+#define alt_blk_fields(FIELD, ARRAY, body) FIELD(body, int32_t, BLOCK_SIGNED, altitude, "mm", millimeters, altitude)
+
+/* Temperature */
+
+#define temp_blk_fields(FIELD, ARRAY, body)                                                                            \
+    FIELD(body, int32_t, BLOCK_SIGNED, temperature, "m degC", millidegrees, temperature)
+
+/* Relative humidity */
+
+#define hum_blk_fields(FIELD, ARRAY, body) FIELD(body, uint32_t, BLOCK_UNSIGNED, humidity, "0.0001 %", as_is, humidity)
+
+/* Pressure */
+
+#define pres_blk_fields(FIELD, ARRAY, body) FIELD(body, uint32_t, BLOCK_UNSIGNED, pressure, "Pa", pascals, pressure)
+
+/* Angular velocity */
+
+#define ang_vel_blk_fields(FIELD, ARRAY, body)                                                                         \
+    FIELD(body, int16_t, BLOCK_SIGNED, x, "0.1 deg/s", tenth_degree, x)                                                \
+    FIELD(body, int16_t, BLOCK_SIGNED, y, "0.1 deg/s", tenth_degree, y)                                                \
+    FIELD(body, int16_t, BLOCK_SIGNED, z, "0.1 deg/s", tenth_degree, z)
+
+/* Linear acceleration */
+
+#define accel_blk_fields(FIELD, ARRAY, body)                                                                           \
+    FIELD(body, int16_t, BLOCK_SIGNED, x, "cm/s^2", cm_per_sec_squared, x)                                             \
+    FIELD(body, int16_t, BLOCK_SIGNED, y, "cm/s^2", cm_per_sec_squared, y)                                             \
+    FIELD(body, int16_t, BLOCK_SIGNED, z, "cm/s^2", cm_per_sec_squared, z)
+
+/* Magnetic field */
+
+#define mag_blk_fields(FIELD, ARRAY, body)                                                                             \
+    FIELD(body, int16_t, BLOCK_SIGNED, x, "0.1 uT", tenth_microtesla, x)                                               \
+    FIELD(body, int16_t, BLOCK_SIGNED, y, "0.1 uT", tenth_microtesla, y)                                               \
+    FIELD(body, int16_t, BLOCK_SIGNED, z, "0.1 uT", tenth_microtesla, z)
+
+/* The range of linear acceleration over a downsampling window, in the x, y and z axes, at the middle of the samples it
+ * covers. The mean of the window is sent in an acceleration block, whose time offset is the same unless the CIC
+ * decimator's longer delay moved it. */
+
+#define accel_env_blk_fields(FIELD, ARRAY, body)                                                                       \
+    ARRAY(body, int16_t, BLOCK_SIGNED, min, 3, "cm/s^2")                                                               \
+    ARRAY(body, int16_t, BLOCK_SIGNED, max, 3, "cm/s^2")
+
+/* The range of angular velocity over a downsampling window, in the x, y and z axes, at the middle of the samples it
+ * covers. The mean of the window is sent in an angular velocity block, whose time offset is the same unless the CIC
+ * decimator's longer delay moved it. */
+
+#define ang_vel_env_blk_fields(FIELD, ARRAY, body)                                                                     \
+    ARRAY(body, int16_t, BLOCK_SIGNED, min, 3, "0.1 deg/s")                                                            \
+    ARRAY(body, int16_t, BLOCK_SIGNED, max, 3, "0.1 deg/s")
+
+/* A three-axis sample, laid out like the bodies of acceleration and angular velocity blocks, in their units */
+
+#define axes_blk_fields(FIELD, ARRAY, body) ARRAY(body, int16_t, BLOCK_SIGNED, axes, 3, "")
+
+/* The start of a delta encoded block of three-axis samples taken at a regular period. The block header counts every
+ * sample, including the base sample here. It is followed by `len` bytes holding each following sample as the
+ * difference of its x, y and z axes from the sample before, each difference zig-zag encoded and then written as a
+ * varint of 7 bits per byte, least significant first. Sample i is at time_offset + i * period / 10 milliseconds,
+ * rounded to the nearest millisecond, to within a millisecond. The base sample is in the units of the matching fixed
+ * size block. */
+
+#define delta_blk_fields(FIELD, ARRAY, body)                                                                           \
+    FIELD(body, uint16_t, BLOCK_UNSIGNED, period, "0.1 ms", as_is, none)                                               \
+    FIELD(body, uint8_t, BLOCK_UNSIGNED, len, "B", as_is, none)                                                        \
+    ARRAY(body, int16_t, BLOCK_SIGNED, base, 3, "")
+
+/* Latitude and longitude */
+
+#define coord_blk_fields(FIELD, ARRAY, body)                                                                           \
+    FIELD(body, int32_t, BLOCK_SIGNED, latitude, "0.1 udeg", as_is, latitude)                                          \
+    FIELD(body, int32_t, BLOCK_SIGNED, longitude, "0.1 udeg", as_is, longitude)
+
+/* A voltage and the unique ID of the sensor it was measured by */
+
+#define volt_blk_fields(FIELD, ARRAY, body)                                                                            \
+    FIELD(body, int16_t, BLOCK_SIGNED, voltage, "mV", as_is, none)                                                     \
+    FIELD(body, uint8_t, BLOCK_UNSIGNED, id, "", as_is, none)
+
+/* The rocket's current status, one of the values in status_code_e */
+
+#define status_blk_fields(FIELD, ARRAY, body) FIELD(body, uint8_t, BLOCK_UNSIGNED, status_code, "", as_is, status_code)
+
+/* An error, one of the values in error_code_e, and the process it came from, which must be less than 32 as the top 3
+ * bits are reserved */
+
+#define error_blk_fields(FIELD, ARRAY, body)                                                                           \
+    FIELD(body, uint8_t, BLOCK_UNSIGNED, originating_process, "", as_is, proc_id)                                      \
+    FIELD(body, uint8_t, BLOCK_UNSIGNED, error_code, "", as_is, error_code)
+
+/* A switch of the radio's settings, from the first packet sent on the new settings. Every packet after it is sent on
+ * them too. */
+
+#define radio_switch_blk_fields(FIELD, ARRAY, body)                                                                    \
+    FIELD(body, uint8_t, BLOCK_UNSIGNED, first_packet, "", as_is, none)                                                \
+    FIELD(body, uint8_t, BLOCK_UNSIGNED, spread, "", as_is, none)                                                      \
+    FIELD(body, uint16_t, BLOCK_UNSIGNED, bandwidth, "kHz", as_is, none)
+
+/* Every block body, as BODY(name) */
+
+#define BLOCK_BODIES(BODY)                                                                                             \
+    BODY(alt_blk)                                                                                                      \
+    BODY(temp_blk)                                                                                                     \
+    BODY(hum_blk)                                                                                                      \
+    BODY(pres_blk)                                                                                                     \
+    BODY(ang_vel_blk)                                                                                                  \
+    BODY(accel_blk)                                                                                                    \
+    BODY(mag_blk)                                                                                                      \
+    BODY(accel_env_blk)                                                                                                \
+    BODY(ang_vel_env_blk)                                                                                              \
+    BODY(axes_blk)                                                                                                     \
+    BODY(delta_blk)                                                                                                    \
+    BODY(coord_blk)                                                                                                    \
+    BODY(volt_blk)                                                                                                     \
+    BODY(status_blk)                                                                                                   \
+    BODY(error_blk)                                                                                                    \
+    BODY(radio_switch_blk)
+
+/* Every block type, in order of their ids, as BLOCK(type, id, body, sample, description). Each sample of a block is
+ * decoded as a `sample` body, which differs from `body` for delta blocks. */
+
+#define BLOCK_TYPES(BLOCK)                                                                                             \
+    BLOCK(DATA_ALT_SEA, 0x0, alt_blk, alt_blk, "Altitude above sea level")                                             \
+    BLOCK(DATA_ALT_LAUNCH, 0x1, alt_blk, alt_blk, "Altitude above launch level")                                       \
+    BLOCK(DATA_TEMP, 0x2, temp_blk, temp_blk, "Temperature data")                                                      \
+    BLOCK(DATA_PRESSURE, 0x3, pres_blk, pres_blk, "Pressure data")                                                     \
+    BLOCK(DATA_ACCEL_REL, 0x4, accel_blk, accel_blk, "Relative linear acceleration data")                              \
+    BLOCK(DATA_ANGULAR_VEL, 0x5, ang_vel_blk, ang_vel_blk, "Angular velocity data")                                    \
+    BLOCK(DATA_HUMIDITY, 0x6, hum_blk, hum_blk, "Humidity data")                                                       \
+    BLOCK(DATA_LAT_LONG, 0x7, coord_blk, coord_blk, "Latitude and longitude coordinates")                              \
+    BLOCK(DATA_VOLTAGE, 0x8, volt_blk, volt_blk, "Voltage in millivolts with a unique ID")                             \
+    BLOCK(DATA_MAGNETIC, 0x9, mag_blk, mag_blk, "Magnetic field data")                                                 \
+    BLOCK(DATA_STATUS, 0xA, status_blk, status_blk, "Status information")                                              \
+    BLOCK(DATA_ERROR, 0xB, error_blk, error_blk, "Error information")                                                  \
+    BLOCK(DATA_ACCEL_ENV, 0xC, accel_env_blk, accel_env_blk, "Range of relative linear acceleration over a window")    \
+    BLOCK(DATA_ANG_VEL_ENV, 0xD, ang_vel_env_blk, ang_vel_env_blk, "Range of angular velocity over a window")          \
+    BLOCK(DATA_ACCEL_DELTA, 0xE, delta_blk, accel_blk, "Linear acceleration at a regular period, delta encoded")       \
+    BLOCK(DATA_ANG_VEL_DELTA, 0xF, delta_blk, ang_vel_blk, "Angular velocity at a regular period, delta encoded")      \
+    BLOCK(DATA_RADIO_SWITCH, 0x10, radio_switch_blk, radio_switch_blk, "Radio settings later packets are sent on")
+
+/* Every body encoded from a single sample, as ENCODER(function, source, body, label). The function writes a sample of
+ * type `source` into the body, using `label` in its errors. */
+
+#define BLOCK_ENCODERS(ENCODER)                                                                                        \
+    ENCODER(orb_accel_pkt, struct sensor_accel, accel_blk, "Accel")                                                    \
+    ENCODER(orb_ang_vel_pkt, struct sensor_gyro, ang_vel_blk, "Ang vel")                                               \
+    ENCODER(orb_mag_pkt, struct sensor_mag, mag_blk, "Mag")                                                            \
+    ENCODER(orb_baro_pkt, struct sensor_baro, pres_blk, "Baro")                                                        \
+    ENCODER(orb_baro_temp_pkt, struct sensor_baro, temp_blk, "Baro temp")                                              \
+    ENCODER(orb_alt_pkt, struct fusion_altitude, alt_blk, "Alt")                                                       \
+    ENCODER(coord_pkt, struct coord_sample, coord_blk, "GNSS")                                                         \
+    ENCODER(orb_error_pkt, struct error_message, error_blk, "Error")                                                   \
+    ENCODER(orb_status_pkt, struct status_message, status_blk, "Status")
+
+#endif // _INSPACE_TELEMETRY_BLOCKS_H_
@@ -97,6 +97,7 @@ int packet_buffer_init(packet_buffer_t *buffer) {
     for (int i = 0; i < PACKET_QUEUE_NUM_BUFFERS; i++) {
         packet_queue_push(&buffer->empty_queue, &buffer->buffers[i]);
     }
+    atomic_init(&buffer->overwrites, 0);
     return 0;
 }
 
@@ -112,6 +113,9 @@ packet_node_t *packet_buffer_get_empty(packet_buffer_t *buffer) {
     if (!packet) {
         indebug("No empty packets to write into, getting a full packet to overwrite\n");
         packet = packet_queue_rpop(&buffer->full_queue);
+        if (packet) {
+            atomic_fetch_add(&buffer->overwrites, 1);
+        }
     }
 
     if (packet) {
@@ -120,6 +124,21 @@ packet_node_t *packet_buffer_get_empty(packet_buffer_t *buffer) {
     return packet;
 }
 
+/**
+ * Takes an empty packet from the buffer, never overwriting a full one
+ *
+ * @param buffer The buffer to get the packet from
+ * @return An empty packet or NULL if every packet is full
+ */
+packet_node_t *packet_buffer_get_unused(packet_buffer_t *buffer) {
+    packet_node_t *packet = packet_queue_lpop(&buffer->empty_queue);
+
+    if (packet) {
+        packet->end = packet->packet;
+    }
+    return packet;
+}
+
 /**
  * Takes a full packet from the buffer, or blocks until there is one
  *
@@ -149,3 +168,25 @@ void packet_buffer_put_empty(packet_buffer_t *buffer, packet_node_t *node) {
 void packet_buffer_put_full(packet_buffer_t *buffer, packet_node_t *node) {
     packet_queue_push(&buffer->full_queue, node);
 }
+
+/**
+ * Get the number of full packets waiting in the buffer
+ *
+ * @param buffer The buffer
+ * @return The number of full packets
+ */
+size_t packet_buffer_depth(packet_buffer_t *buffer) {
+    size_t depth;
+    pthread_mutex_lock(&buffer->full_queue.lock);
+    depth = sq_count(&buffer->full_queue.q);
+    pthread_mutex_unlock(&buffer->full_queue.lock);
+    return depth;
+}
+
+/**
+ * Get the number of full packets that were overwritten before they were used
+ *
+ * @param buffer The buffer
+ * @return The number of overwritten packets since the buffer was initialized
+ */
+unsigned packet_buffer_overwrites(packet_buffer_t *buffer) { return atomic_load(&buffer->overwrites); }
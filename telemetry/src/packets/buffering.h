@@ -3,6 +3,7 @@
 
 #include <nuttx/queue.h>
 #include <pthread.h>
+#include <stdatomic.h>
 
 #include "packets.h"
 
@@ -38,12 +39,17 @@ typedef struct {
     struct packet_queue full_queue;
     /* A queue of empty packets to be written into */
     struct packet_queue empty_queue;
+    /* The number of full packets taken to be overwritten because there were no empty ones */
+    atomic_uint overwrites;
 } packet_buffer_t;
 
 int packet_buffer_init(packet_buffer_t *buffer);
 packet_node_t *packet_buffer_get_empty(packet_buffer_t *buffer);
+packet_node_t *packet_buffer_get_unused(packet_buffer_t *buffer);
 packet_node_t *packet_buffer_get_full(packet_buffer_t *buffer);
 void packet_buffer_put_empty(packet_buffer_t *buffer, packet_node_t *node);
 void packet_buffer_put_full(packet_buffer_t *buffer, packet_node_t *node);
+size_t packet_buffer_depth(packet_buffer_t *buffer);
+unsigned packet_buffer_overwrites(packet_buffer_t *buffer);
 
 #endif // _INSPACE_PACKET_QUEUE_H_
@@ -0,0 +1,165 @@
+#include <errno.h>
+#include <string.h>
+
+#include "fec.h"
+
+_Static_assert(sizeof(struct fec_hdr_t) == PACKET_FEC_OVERHEAD, "Data packets must leave room for the parity header");
+
+/* Get the parity header of a parity packet
+ *
+ * @param packet The parity packet
+ * @return The header after its pkt_hdr_t
+ */
+static struct fec_hdr_t *fec_hdr(const uint8_t *packet) { return (struct fec_hdr_t *)(packet + sizeof(pkt_hdr_t)); }
+
+/* XOR bytes into a buffer
+ *
+ * @param dst The buffer to XOR into
+ * @param src The bytes to XOR
+ * @param len The number of bytes
+ */
+static void xor_bytes(uint8_t *dst, const uint8_t *src, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        dst[i] ^= src[i];
+    }
+}
+
+/**
+ * Start a parity encoder
+ *
+ * @param enc The encoder to initialize
+ * @param group The number of data packets each parity packet covers
+ * @return 0 on success, or -EINVAL if the group is too small or too large
+ */
+int fec_encoder_init(struct fec_encoder *enc, uint8_t group) {
+    if (group < 2 || group > FEC_MAX_GROUP) {
+        return -EINVAL;
+    }
+    enc->group = group;
+    enc->count = 0;
+    enc->len = 0;
+    return 0;
+}
+
+/**
+ * Add a data packet to the current group. Data packets must be added in the order they're sent.
+ *
+ * @param enc The encoder
+ * @param packet The data packet
+ * @param len The length of the data packet, at most PACKET_MAX_SIZE - PACKET_FEC_OVERHEAD
+ * @return The length of the parity packet in enc->parity if the packet completed a group, 0 if it didn't, or -EINVAL
+ * if the packet can't be covered
+ */
+int fec_encoder_add(struct fec_encoder *enc, const uint8_t *packet, size_t len) {
+    const pkt_hdr_t *hdr = (const pkt_hdr_t *)packet;
+    pkt_hdr_t *parity = (pkt_hdr_t *)enc->parity;
+    size_t body_len = len - sizeof(pkt_hdr_t);
+
+    if (len < sizeof(pkt_hdr_t) || len > PACKET_MAX_SIZE - PACKET_FEC_OVERHEAD) {
+        return -EINVAL;
+    }
+
+    if (enc->count == 0) {
+        memset(enc->parity, 0, sizeof(enc->parity));
+        memcpy(parity->call_sign, hdr->call_sign, sizeof(parity->call_sign));
+        parity->packet_num = hdr->packet_num;
+        parity->type_count = FEC_PARITY_MARK;
+        enc->len = sizeof(pkt_hdr_t) + sizeof(struct fec_hdr_t);
+    }
+
+    parity->timestamp ^= hdr->timestamp;
+    fec_hdr(enc->parity)->count = ++enc->count;
+    fec_hdr(enc->parity)->len_xor ^= len;
+    fec_hdr(enc->parity)->type_count_xor ^= hdr->type_count;
+    xor_bytes(enc->parity + sizeof(pkt_hdr_t) + sizeof(struct fec_hdr_t), packet + sizeof(pkt_hdr_t), body_len);
+    if (sizeof(pkt_hdr_t) + sizeof(struct fec_hdr_t) + body_len > enc->len) {
+        enc->len = sizeof(pkt_hdr_t) + sizeof(struct fec_hdr_t) + body_len;
+    }
+
+    if (enc->count < enc->group) {
+        return 0;
+    }
+    enc->count = 0;
+    return enc->len;
+}
+
+/**
+ * Check if a received packet is a parity packet
+ *
+ * @param packet The packet
+ * @param len The length of the packet
+ * @return True if the packet is a parity packet
+ */
+bool fec_is_parity(const uint8_t *packet, size_t len) {
+    return len >= sizeof(pkt_hdr_t) + sizeof(struct fec_hdr_t) &&
+           ((const pkt_hdr_t *)packet)->type_count == FEC_PARITY_MARK;
+}
+
+/**
+ * Rebuild the one lost data packet of a group from the group's parity packet and the packets that were received
+ *
+ * @param parity The group's parity packet
+ * @param parity_len The length of the parity packet
+ * @param packets The group's data packets in the order they were sent, as many as the parity header counts, with NULL
+ * for the lost packet
+ * @param lens The lengths of the group's data packets
+ * @param out Where to rebuild the lost packet, at least PACKET_MAX_SIZE bytes
+ * @param out_len Where to put the length of the rebuilt packet
+ * @return The index in the group of the rebuilt packet, -ENOENT if no packet was lost, -ERANGE if more than one was,
+ * or -EINVAL if the parity packet is malformed
+ */
+int fec_recover(const uint8_t *parity, size_t parity_len, const uint8_t *const *packets, const size_t *lens,
+                uint8_t *out, size_t *out_len) {
+    const struct fec_hdr_t *fhdr = fec_hdr(parity);
+    pkt_hdr_t *hdr = (pkt_hdr_t *)out;
+    size_t payload_len;
+    uint8_t len;
+    int lost = -ENOENT;
+
+    if (!fec_is_parity(parity, parity_len) || parity_len > PACKET_MAX_SIZE || fhdr->count < 2 ||
+        fhdr->count > FEC_MAX_GROUP) {
+        return -EINVAL;
+    }
+    payload_len = parity_len - sizeof(pkt_hdr_t) - sizeof(struct fec_hdr_t);
+    len = fhdr->len_xor;
+
+    for (int i = 0; i < fhdr->count; i++) {
+        if (packets[i] == NULL) {
+            if (lost >= 0) {
+                return -ERANGE;
+            }
+            lost = i;
+        }
+    }
+    if (lost < 0) {
+        return lost;
+    }
+
+    /* Everything but the lost packet cancels out of the parity */
+
+    memcpy(out, parity, sizeof(pkt_hdr_t));
+    memset(out + sizeof(pkt_hdr_t), 0, PACKET_MAX_SIZE - sizeof(pkt_hdr_t));
+    memcpy(out + sizeof(pkt_hdr_t), parity + sizeof(pkt_hdr_t) + sizeof(struct fec_hdr_t), payload_len);
+    hdr->packet_num += lost;
+    hdr->type_count = fhdr->type_count_xor;
+
+    for (int i = 0; i < fhdr->count; i++) {
+        const pkt_hdr_t *received = (const pkt_hdr_t *)packets[i];
+        if (received == NULL) {
+            continue;
+        }
+        if (lens[i] < sizeof(pkt_hdr_t) || lens[i] - sizeof(pkt_hdr_t) > payload_len) {
+            return -EINVAL;
+        }
+        hdr->timestamp ^= received->timestamp;
+        hdr->type_count ^= received->type_count;
+        len ^= lens[i];
+        xor_bytes(out + sizeof(pkt_hdr_t), packets[i] + sizeof(pkt_hdr_t), lens[i] - sizeof(pkt_hdr_t));
+    }
+
+    if (len < sizeof(pkt_hdr_t) || len - sizeof(pkt_hdr_t) > payload_len) {
+        return -EINVAL;
+    }
+    *out_len = len;
+    return lost;
+}
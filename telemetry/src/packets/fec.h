@@ -0,0 +1,42 @@
+#ifndef _INSPACE_FEC_H_
+#define _INSPACE_FEC_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "packets.h"
+
+/* Marks a parity packet in place of the block type count, which no data packet can reach */
+
+#define FEC_PARITY_MARK 0xFF
+
+/* The most data packets a parity packet can cover */
+
+#define FEC_MAX_GROUP 32
+
+/* Follows the pkt_hdr_t of a parity packet, whose packet number is the first data packet it covers and whose timestamp
+ * is the XOR of the covered packets' timestamps. After it is the XOR of every covered packet's bytes after its
+ * pkt_hdr_t, zero padded to the longest. */
+struct fec_hdr_t {
+    uint8_t count;          /* The number of consecutive data packets covered */
+    uint8_t len_xor;        /* The XOR of the covered packets' lengths */
+    uint8_t type_count_xor; /* The XOR of the covered packets' block type counts */
+} TIGHTLY_PACKED;
+
+/* Builds a parity packet over every group of consecutive data packets, so the ground can rebuild any one packet of the
+ * group that's lost. */
+struct fec_encoder {
+    uint8_t parity[PACKET_MAX_SIZE]; /* The parity packet of the current group */
+    size_t len;                      /* The length of the parity packet so far */
+    uint8_t group;                   /* The number of data packets covered by each parity packet */
+    uint8_t count;                   /* The number of data packets in the current group so far */
+};
+
+int fec_encoder_init(struct fec_encoder *enc, uint8_t group);
+int fec_encoder_add(struct fec_encoder *enc, const uint8_t *packet, size_t len);
+bool fec_is_parity(const uint8_t *packet, size_t len);
+int fec_recover(const uint8_t *parity, size_t parity_len, const uint8_t *const *packets, const size_t *lens,
+                uint8_t *out, size_t *out_len);
+
+#endif // _INSPACE_FEC_H_
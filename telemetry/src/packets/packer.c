@@ -0,0 +1,122 @@
+#include <errno.h>
+#include <string.h>
+
+#include "packer.h"
+
+/* The most samples a block header can count */
+
+#define BLOCK_MAX_COUNT UINT8_MAX
+
+/**
+ * Start filling a packet with a header and no blocks
+ *
+ * @param pk The packer to initialize
+ * @param packet The packet to fill, at least PACKET_MAX_SIZE bytes
+ * @param packet_num The sequence number of the packet
+ * @param mission_time The mission time of the packet in milliseconds
+ */
+void packer_init(struct packer *pk, uint8_t *packet, uint8_t packet_num, uint32_t mission_time) {
+    pk->packet = packet;
+    pk->end = pkt_init(packet, packet_num, mission_time);
+    pk->block = NULL;
+}
+
+/**
+ * Make room for a sample at the end of the packet. The sample is added to the last block if it has the same type,
+ * otherwise a new block is created for it.
+ *
+ * @param pk The packer to add the sample with
+ * @param type The block type of the sample
+ * @param mission_time The time of the sample in milliseconds, which must be representable as an offset from the packet
+ * header's timestamp if it starts a new block
+ * @return Where to write the sample's block body, or NULL if it doesn't fit
+ */
+void *packer_add(struct packer *pk, enum block_type_e type, uint32_t mission_time) {
+    size_t body_len = blk_body_len(type);
+    uint8_t *body = pk->end;
+
+    if (pk->block != NULL && pk->block->type == type && pk->block->count < BLOCK_MAX_COUNT) {
+        if (packer_size(pk) + body_len > PACKET_DATA_MAX_SIZE) {
+            return NULL;
+        }
+    } else {
+        uint8_t *end = pkt_create_blk(pk->packet, pk->end, type, mission_time);
+        if (end == NULL) {
+            return NULL;
+        }
+        pk->block = (blk_hdr_t *)pk->end;
+        body = block_body(pk->end);
+    }
+
+    pk->block->count++;
+    pk->end = body + body_len;
+    return body;
+}
+
+/**
+ * Add a whole block whose body was built by the caller, for block types whose samples don't all take the same space.
+ * Nothing can be appended to the block afterwards.
+ *
+ * @param pk The packer to add the block with
+ * @param type The block type
+ * @param count The number of samples in the block
+ * @param body The block body
+ * @param body_len The size of the block body
+ * @return 0 on success, or -ENOSPC if the block doesn't fit
+ */
+int packer_add_block(struct packer *pk, enum block_type_e type, uint8_t count, const void *body, size_t body_len) {
+    blk_hdr_t *block = (blk_hdr_t *)pk->end;
+
+    if (packer_size(pk) + sizeof(blk_hdr_t) + body_len > PACKET_DATA_MAX_SIZE) {
+        return -ENOSPC;
+    }
+
+    blk_hdr_init(block, type, count);
+    memcpy(block_body(pk->end), body, body_len);
+    ((pkt_hdr_t *)pk->packet)->type_count++;
+    pk->end = block_body(pk->end) + body_len;
+    pk->block = NULL;
+    return 0;
+}
+
+/**
+ * Remove the last sample added with packer_add, along with its block if it was the block's only sample
+ *
+ * @param pk The packer to remove the sample from
+ */
+void packer_undo(struct packer *pk) {
+    if (pk->block == NULL) {
+        return;
+    }
+
+    pk->end -= blk_body_len(pk->block->type);
+    if (--pk->block->count == 0) {
+        ((pkt_hdr_t *)pk->packet)->type_count--;
+        pk->end = (uint8_t *)pk->block;
+        pk->block = NULL;
+    }
+}
+
+/**
+ * Get the size of the packet filled so far
+ *
+ * @param pk The packer
+ * @return The number of bytes in the packet, including its header
+ */
+size_t packer_size(struct packer *pk) { return pk->end - pk->packet; }
+
+/**
+ * Get the room left in the packet
+ *
+ * @param pk The packer
+ * @return The number of bytes that can still be added to the packet
+ */
+size_t packer_space(struct packer *pk) { return PACKET_DATA_MAX_SIZE - packer_size(pk); }
+
+/**
+ * Get the timestamp that the time offsets of the packet's samples are relative to
+ *
+ * @param pk The packer
+ * @return The packet header's timestamp in half-minutes
+ */
+uint16_t packer_base_time(struct packer *pk) { return ((pkt_hdr_t *)pk->packet)->timestamp; }
@@ -0,0 +1,25 @@
+#ifndef _INSPACE_PACKER_H_
+#define _INSPACE_PACKER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "packets.h"
+
+/* Fills a packet block by block without ever letting it grow past PACKET_DATA_MAX_SIZE. Consecutive samples of the
+ * same type share a block. */
+struct packer {
+    uint8_t *packet;  /* The packet being filled, starting with its header */
+    uint8_t *end;     /* Where the next block or sample goes */
+    blk_hdr_t *block; /* The block the last sample was added to, NULL if there isn't one */
+};
+
+void packer_init(struct packer *pk, uint8_t *packet, uint8_t packet_num, uint32_t mission_time);
+void *packer_add(struct packer *pk, enum block_type_e type, uint32_t mission_time);
+int packer_add_block(struct packer *pk, enum block_type_e type, uint8_t count, const void *body, size_t body_len);
+void packer_undo(struct packer *pk);
+size_t packer_size(struct packer *pk);
+size_t packer_space(struct packer *pk);
+uint16_t packer_base_time(struct packer *pk);
+
+#endif // _INSPACE_PACKER_H_
@@ -1,20 +1,10 @@
+#include <errno.h>
 #include <string.h>
 
 #include "../syslogging.h"
 #include "packets.h"
 #include <math.h>
 
-/* Unit conversion helpers */
-
-#define us_to_ms(us) (us / 1000)
-#define pascals(millibar) (millibar * 100)
-#define millimeters(meters) (meters * 1000)
-#define point_one_microdegrees(degrees) (1E7f * degrees)
-#define tenth_degree(radian) (radian * 1800 / M_PI)
-#define tenth_microtesla(microtesla) (microtesla * 10)
-#define cm_per_sec_squared(meters_per_sec_squared) (meters_per_sec_squared * 100)
-#define millidegrees(celsius) (celsius * 1000)
-
 /* Get the absolute timestamp that should be used for a packet created
  * at the given mission time
  */
@@ -59,6 +49,53 @@ static int has_offset(enum block_type_e type) {
     }
 }
 
+/* The most bytes a varint of a difference between two int16 values takes */
+
+#define VARINT_MAX_LEN 3
+
+/* The time offset of sample i of a delta block from its first, in milliseconds, given the block's period in tenths of
+ * milliseconds */
+
+#define delta_offset(i, period) (((int32_t)(i) * (period) + 5) / 10)
+
+/* Write a zig-zag varint
+ *
+ * @param out Where to write the varint, with room for VARINT_MAX_LEN bytes
+ * @param value The value to write, which must fit in 17 bits
+ * @return The number of bytes written
+ */
+static size_t varint_write(uint8_t *out, int32_t value) {
+    uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    size_t len = 0;
+
+    while (zigzag >= 0x80) {
+        out[len++] = (zigzag & 0x7f) | 0x80;
+        zigzag >>= 7;
+    }
+    out[len++] = zigzag;
+    return len;
+}
+
+/* Read a zig-zag varint
+ *
+ * @param in The varint
+ * @param end The end of the bytes the varint can be read from
+ * @param value Where to store the value read
+ * @return The number of bytes read, or 0 if there isn't a whole varint of at most VARINT_MAX_LEN bytes
+ */
+static size_t varint_read(const uint8_t *in, const uint8_t *end, int32_t *value) {
+    uint32_t zigzag = 0;
+
+    for (size_t len = 0; len < VARINT_MAX_LEN && in + len < end; len++) {
+        zigzag |= (uint32_t)(in[len] & 0x7f) << (7 * len);
+        if (!(in[len] & 0x80)) {
+            *value = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+            return len + 1;
+        }
+    }
+    return 0;
+}
+
 /* Get the timestamp out of a block body
  * @param block_body The body of the block to get a timestamp from
  * @return A the timestamp field of the block
@@ -97,38 +134,17 @@ void blk_hdr_init(blk_hdr_t *b, const enum block_type_e type, const uint8_t coun
 
 /* Return the length of a block of this type's body
  * @param type The type of block to get the length of
- * @return The number of bytes in the block body
+ * @return The number of bytes in the block body. Delta blocks vary in length, this is only the part before their
+ * differences.
  */
 size_t blk_body_len(enum block_type_e type) {
-    switch (type) {
-    case DATA_ALT_SEA:
-        return sizeof(struct alt_blk_t);
-    case DATA_ALT_LAUNCH:
-        return sizeof(struct alt_blk_t);
-    case DATA_TEMP:
-        return sizeof(struct temp_blk_t);
-    case DATA_PRESSURE:
-        return sizeof(struct pres_blk_t);
-    case DATA_ACCEL_REL:
-        return sizeof(struct accel_blk_t);
-    case DATA_ANGULAR_VEL:
-        return sizeof(struct ang_vel_blk_t);
-    case DATA_HUMIDITY:
-        return sizeof(struct hum_blk_t);
-    case DATA_LAT_LONG:
-        return sizeof(struct coord_blk_t);
-    case DATA_VOLTAGE:
-        return sizeof(struct volt_blk_t);
-    case DATA_MAGNETIC:
-        return sizeof(struct mag_blk_t);
-    case DATA_STATUS:
-        return sizeof(struct status_blk_t);
-    case DATA_ERROR:
-        return sizeof(struct error_blk_t);
-    default:
+    const struct block_desc *desc = block_desc(type);
+
+    if (desc == NULL) {
         inerr("Length requested for unsupported type %d\n", type);
         return -1;
     }
+    return desc->body->len;
 }
 
 /* Initialize a packet with a header and return a pointer to the first byte of its body
@@ -169,7 +185,7 @@ uint8_t *pkt_create_blk(uint8_t *packet, uint8_t *block, enum block_type_e type,
         inerr("Packet is too small to contain a header\n");
         return NULL;
     }
-    if ((packet_size + block_size) > PACKET_MAX_SIZE) {
+    if ((packet_size + block_size) > PACKET_DATA_MAX_SIZE) {
         return NULL;
     }
     if (has_offset(type)) {
@@ -182,214 +198,193 @@ uint8_t *pkt_create_blk(uint8_t *packet, uint8_t *block, enum block_type_e type,
     return block + block_size;
 }
 
-/*
- * Construct an altitude block.
- * @param b The altitude block to initialize.
- * @param altitude The altitude value measured in millimetres above launch
- * height.
- */
-void alt_blk_init(struct alt_blk_t *b, const int32_t altitude) { b->altitude = altitude; }
-
-/*
- * Construct a temperature block.
- * @param b The temperature block to initialize.
- * @param temperature The temperature measured in millidegrees Celsius.
- */
-void temp_blk_init(struct temp_blk_t *b, const int32_t temperature) { b->temperature = temperature; }
-
-/*
- * Construct a pressure block
- * @param b The pressure block to initialize
- * @param pressure The pressure measured in Pascals
- */
-void pres_blk_init(struct pres_blk_t *b, const int32_t pressure) { b->pressure = pressure; }
-
-/*
- * Construct a acceleration block
- * @param b The acceleration block to initialize
- * @param x_axis Linear acceleration in the x-axis measured in centimetres per second
- * @param y_axis Linear acceleration in the y-axis measured in centimetres per second
- * @param z_axis Linear acceleration in the z-axis measured in centimetres per second
- */
-void accel_blk_init(struct accel_blk_t *b, const int16_t x_axis, const int16_t y_axis, const int16_t z_axis) {
-    b->x = x_axis;
-    b->y = y_axis;
-    b->z = z_axis;
-}
-
-/*
- * Construct a coordinate block
- * @param b The coordinate block to initialize
- * @param lat Latitude of the coordinate, in 0.1 microdegress
- * @param lon Longitude of the coordinate, in 0.1 microdegress
- */
-void coord_blk_init(struct coord_blk_t *b, const int32_t lat, const int32_t lon) {
-    b->latitude = lat;
-    b->longitude = lon;
-}
-
-/*
- * Construct an angular velocity block
- * @param b The angular velocity block to initialize
- * @param x_axis Angular velocity in the x-axis measured in tenths of degrees per second
- * @param y_axis Angular velocity in the y-axis measured in tenths of degrees per second
- * @param z_axis Angular velocity in the z-axis measured in tenths of degrees per second
- */
-void ang_vel_blk_init(struct ang_vel_blk_t *b, const int16_t x_axis, const int16_t y_axis, const int16_t z_axis) {
-    b->x = x_axis;
-    b->y = y_axis;
-    b->z = z_axis;
-}
-
-/*
- * Construct a magnetic field block
- * @param b The magnetic field block to initialize
- * @param x_axis The magnetic field in the x-axis measured in 0.1 microtesla
- * @param y_axis The magnetic field in the y-axis measured in 0.1 microtesla
- * @param z_axis The magnetic field in the z-axis measured in 0.1 microtesla
- */
-void mag_blk_init(struct mag_blk_t *b, const int16_t x_axis, const int16_t y_axis, const int16_t z_axis) {
-    b->x = x_axis;
-    b->y = y_axis;
-    b->z = z_axis;
-}
+/* Initializers of each block body, from BLOCK_BODIES */
 
-/*
- * Construct a voltage block
- * @param b The voltage block to initialize
- * @param id The ID of the channel that this voltage was measured on
- * @param voltage The voltage measured in millivolts
- */
-void volt_blk_init(struct volt_blk_t *b, const uint8_t id, const int16_t voltage) {
-    b->id = id;
-    b->voltage = voltage;
-}
-
-/*
- * Construct a status block
- * @param b The status block to initialize
- * @param status_code The status code to use
- */
-void status_blk_init(struct status_blk_t *b, const uint8_t status_code) { b->status_code = status_code; }
-
-/*
- * Construct an error block
- * @param b The error block to initialize
- * @param proc_id The originating process that created this error
- * @param error_code The error code to use
- */
-void error_blk_init(struct error_blk_t *b, const uint8_t proc_id, const uint8_t error_code) {
-    if (proc_id & 0xE0) {
-        inwarn("The reserved bits of the error message were used");
+#define BLOCK_INIT_ASSIGN(body, type, sign, field, unit, scale, source) b->field = field;
+#define BLOCK_INIT_COPY(body, type, sign, field, count, unit) memcpy(b->field, field, sizeof(b->field));
+#define BLOCK_INIT(name)                                                                                               \
+    void name##_init(struct name##_t *b name##_fields(BLOCK_INIT_PARAM, BLOCK_INIT_ARRAY_PARAM, name)) {               \
+        name##_fields(BLOCK_INIT_ASSIGN, BLOCK_INIT_COPY, name)                                                        \
     }
-    b->originating_process = proc_id;
-    b->error_code = error_code;
-}
 
-int orb_accel_pkt(struct sensor_accel *accel, struct accel_blk_t *blk, uint16_t base_time) {
-    int16_t time_offset;
-    if (pkt_blk_calc_time(us_to_ms(accel->timestamp), base_time, &time_offset)) {
-        inerr("Failed to calculate time offset for Accel block\n");
-        return -1;
+BLOCK_BODIES(BLOCK_INIT)
+
+/* Encoders of each block body written from a single sample, from BLOCK_ENCODERS */
+
+#define BLOCK_ENCODE_FIELD(body, type, sign, field, unit, scale, source) blk->field = (type)scale(sample->source);
+#define BLOCK_ENCODE_ARRAY(body, type, sign, field, count, unit)
+#define BLOCK_ENCODER(function, source, body, label)                                                                   \
+    int function(source *sample, struct body##_t *blk, uint16_t base_time) {                                           \
+        int16_t time_offset;                                                                                           \
+        if (pkt_blk_calc_time(us_to_ms(sample->timestamp), base_time, &time_offset)) {                                 \
+            inerr("Failed to calculate time offset for " label " block\n");                                            \
+            return -1;                                                                                                 \
+        }                                                                                                              \
+        blk->time_offset = time_offset;                                                                                \
+        body##_fields(BLOCK_ENCODE_FIELD, BLOCK_ENCODE_ARRAY, body)                                                    \
+        return 0;                                                                                                      \
     }
 
-    blk->time_offset = time_offset;
-    blk->x = (int16_t)cm_per_sec_squared(accel->x);
-    blk->y = (int16_t)cm_per_sec_squared(accel->y);
-    blk->z = (int16_t)cm_per_sec_squared(accel->z);
-    return 0;
-}
+BLOCK_ENCODERS(BLOCK_ENCODER)
 
-int orb_ang_vel_pkt(struct sensor_gyro *gyro, struct ang_vel_blk_t *blk, uint16_t base_time) {
+int orb_accel_env_pkt(struct decimator_envelope *env, struct accel_env_blk_t *blk, uint16_t base_time) {
     int16_t time_offset;
-    if (pkt_blk_calc_time(us_to_ms(gyro->timestamp), base_time, &time_offset)) {
-        inerr("Failed to calculate time offset for Ang vel block\n");
+    if (pkt_blk_calc_time(us_to_ms(env->timestamp), base_time, &time_offset)) {
+        inerr("Failed to calculate time offset for Accel envelope block\n");
         return -1;
     }
     blk->time_offset = time_offset;
-    blk->x = (int16_t)tenth_degree(gyro->x);
-    blk->y = (int16_t)tenth_degree(gyro->y);
-    blk->z = (int16_t)tenth_degree(gyro->z);
+    for (int i = 0; i < 3; i++) {
+        blk->min[i] = (int16_t)cm_per_sec_squared(env->min[i]);
+        blk->max[i] = (int16_t)cm_per_sec_squared(env->max[i]);
+    }
     return 0;
 }
 
-int orb_mag_pkt(struct sensor_mag *mag, struct mag_blk_t *blk, uint16_t base_time) {
+int orb_ang_vel_env_pkt(struct decimator_envelope *env, struct ang_vel_env_blk_t *blk, uint16_t base_time) {
     int16_t time_offset;
-    if (pkt_blk_calc_time(us_to_ms(mag->timestamp), base_time, &time_offset)) {
-        inerr("Failed to calculate time offset for Mag block\n");
+    if (pkt_blk_calc_time(us_to_ms(env->timestamp), base_time, &time_offset)) {
+        inerr("Failed to calculate time offset for Ang vel envelope block\n");
         return -1;
     }
     blk->time_offset = time_offset;
-    blk->x = (int16_t)tenth_microtesla(mag->x);
-    blk->y = (int16_t)tenth_microtesla(mag->y);
-    blk->z = (int16_t)tenth_microtesla(mag->z);
+    for (int i = 0; i < 3; i++) {
+        blk->min[i] = (int16_t)tenth_degree(env->min[i]);
+        blk->max[i] = (int16_t)tenth_degree(env->max[i]);
+    }
     return 0;
 }
 
-int orb_baro_pkt(struct sensor_baro *baro, struct pres_blk_t *blk, uint16_t base_time) {
-    int16_t time_offset;
-    if (pkt_blk_calc_time(us_to_ms(baro->timestamp), base_time, &time_offset)) {
-        inerr("Failed to calculate time offset for Baro block\n");
-        return -1;
+/* Write the differences between samples on a regular period, stopping at the first that isn't on it or doesn't fit
+ *
+ * @param samples The samples, the first of which is the base sample
+ * @param n The number of samples
+ * @param period The time between samples in tenths of milliseconds
+ * @param deltas Where to write the differences
+ * @param room The most bytes of differences that can be written
+ * @param len Where to store the number of bytes written
+ * @param irregular Where to store if the run stopped at a sample that wasn't on the period
+ * @return The number of samples in the run, including the base sample
+ */
+static int delta_run(const struct axes_blk_t *samples, int n, int32_t period, uint8_t *deltas, size_t room,
+                     size_t *len, int *irregular) {
+    int count = 1;
+
+    *len = 0;
+    *irregular = 0;
+    for (; count < n && count < UINT8_MAX; count++) {
+        uint8_t sample[3 * VARINT_MAX_LEN];
+        size_t sample_len = 0;
+        int32_t late = samples[count].time_offset - (samples[0].time_offset + delta_offset(count, period));
+
+        if (late > 1 || late < -1) {
+            *irregular = 1;
+            break;
+        }
+        for (int a = 0; a < 3; a++) {
+            sample_len += varint_write(sample + sample_len, samples[count].axes[a] - samples[count - 1].axes[a]);
+        }
+        if (*len + sample_len > room) {
+            break;
+        }
+        memcpy(deltas + *len, sample, sample_len);
+        *len += sample_len;
     }
-    blk->time_offset = time_offset;
-    blk->pressure = (uint32_t)pascals(baro->pressure);
-    return 0;
+    return count;
 }
 
-int orb_baro_temp_pkt(struct sensor_baro *baro, struct temp_blk_t *blk, uint16_t base_time) {
-    int16_t time_offset;
-    if (pkt_blk_calc_time(us_to_ms(baro->timestamp), base_time, &time_offset)) {
-        inerr("Failed to calculate time offset for Baro temp block\n");
-        return -1;
+/**
+ * Delta encode a run of regularly spaced three-axis samples into the body of a DATA_ACCEL_DELTA or DATA_ANG_VEL_DELTA
+ * block. The run ends early at a sample that isn't on the period of the ones before it, or when the body would grow
+ * past the space it has.
+ *
+ * @param body Where to write the block body
+ * @param space The most bytes the body can take
+ * @param samples The samples, in time order
+ * @param n The number of samples
+ * @param body_len Where to store the number of bytes written
+ * @return The number of samples encoded, which the block header must count, or 0 if not even one fits
+ */
+int delta_blk_encode(uint8_t *body, size_t space, const struct axes_blk_t *samples, int n, size_t *body_len) {
+    struct delta_blk_t *blk = (struct delta_blk_t *)body;
+    int32_t period = 0;
+    int count = 1;
+    size_t len = 0;
+    int irregular;
+
+    *body_len = 0;
+    if (n <= 0 || space < sizeof(struct delta_blk_t)) {
+        return 0;
     }
-    blk->time_offset = time_offset;
-    blk->temperature = (int32_t)millidegrees(baro->temperature);
-    return 0;
-}
 
-int orb_alt_pkt(struct fusion_altitude *alt, struct alt_blk_t *blk, uint16_t base_time) {
-    int16_t time_offset;
-    if (pkt_blk_calc_time(us_to_ms(alt->timestamp), base_time, &time_offset)) {
-        inerr("Failed to calculate time offset for Alt block\n");
-        return -1;
+    size_t room = space - sizeof(struct delta_blk_t);
+    room = room < UINT8_MAX ? room : UINT8_MAX;
+
+    /* The period is estimated over as many samples as possible so the rounding of any one time offset doesn't skew
+     * it. If the run turns out irregular, it's estimated again over the samples before the one that broke it. */
+
+    for (int m = n; m > 1;) {
+        int32_t span = 10 * (samples[m - 1].time_offset - samples[0].time_offset);
+        period = (span + (m - 1) / 2) / (m - 1);
+        if (period <= 0 || period > UINT16_MAX) {
+            period = 0;
+            count = 1;
+            len = 0;
+            break;
+        }
+
+        count = delta_run(samples, n, period, body + sizeof(struct delta_blk_t), room, &len, &irregular);
+        if (!irregular || count >= m || m == 2) {
+            break;
+        }
+        m = count > 2 ? count : 2;
     }
-    blk->time_offset = time_offset;
-    blk->altitude = (int32_t)millimeters(alt->altitude);
-    return 0;
+
+    blk->time_offset = samples[0].time_offset;
+    blk->period = period;
+    blk->len = len;
+    memcpy(blk->base, samples[0].axes, sizeof(blk->base));
+    *body_len = sizeof(struct delta_blk_t) + len;
+    return count;
 }
 
-int orb_gnss_pkt(struct sensor_gnss *gnss, struct coord_blk_t *blk, uint16_t base_time) {
-    int16_t time_offset;
-    if (pkt_blk_calc_time(us_to_ms(gnss->timestamp), base_time, &time_offset)) {
-        inerr("Failed to calculate time offset for GNSS block\n");
-        return -1;
+/**
+ * Decode the body of a DATA_ACCEL_DELTA or DATA_ANG_VEL_DELTA block. Each sample's time offset is reconstructed from
+ * the block's period.
+ *
+ * @param body The block body
+ * @param space The number of bytes the body can take up, such as the rest of the packet
+ * @param count The number of samples in the block, from its header
+ * @param samples Where to store the samples, with room for `count` of them
+ * @return The number of bytes of the body, or -EINVAL if it's malformed
+ */
+int delta_blk_decode(const uint8_t *body, size_t space, uint8_t count, struct axes_blk_t *samples) {
+    const struct delta_blk_t *blk = (const struct delta_blk_t *)body;
+
+    if (count == 0 || space < sizeof(struct delta_blk_t) || sizeof(struct delta_blk_t) + blk->len > space) {
+        return -EINVAL;
     }
-    blk->time_offset = time_offset;
-    blk->latitude = (int32_t)point_one_microdegrees(gnss->latitude);
-    blk->longitude = (int32_t)point_one_microdegrees(gnss->longitude);
-    return 0;
-}
 
-int orb_error_pkt(struct error_message *error, struct error_blk_t *blk, uint16_t base_time) {
-    int16_t time_offset;
-    if (pkt_blk_calc_time(us_to_ms(error->timestamp), base_time, &time_offset)) {
-        inerr("Failed to calculate time offset for Error block\n");
-        return -1;
+    const uint8_t *in = body + sizeof(struct delta_blk_t);
+    const uint8_t *end = in + blk->len;
+
+    samples[0].time_offset = blk->time_offset;
+    memcpy(samples[0].axes, blk->base, sizeof(samples[0].axes));
+    for (int i = 1; i < count; i++) {
+        samples[i].time_offset = blk->time_offset + delta_offset(i, blk->period);
+        for (int a = 0; a < 3; a++) {
+            int32_t delta;
+            size_t read = varint_read(in, end, &delta);
+            if (read == 0) {
+                return -EINVAL;
+            }
+            in += read;
+            samples[i].axes[a] = samples[i - 1].axes[a] + delta;
+        }
     }
-    blk->time_offset = time_offset;
-    blk->originating_process = (uint8_t)error->proc_id;
-    blk->error_code = (uint8_t)error->error_code;
-    return 0;
-}
 
-int orb_status_pkt(struct status_message *status, struct status_blk_t *blk, uint16_t base_time) {
-    int16_t time_offset;
-    if (pkt_blk_calc_time(us_to_ms(status->timestamp), base_time, &time_offset)) {
-        inerr("Failed to calculate time offset for Status block\n");
-        return -1;
+    if (in != end) {
+        return -EINVAL;
     }
-    blk->time_offset = time_offset;
-    blk->status_code = (uint8_t)status->status_code;
-    return 0;
+    return sizeof(struct delta_blk_t) + blk->len;
 }
@@ -1,9 +1,12 @@
 #ifndef _INSPACE_TELEMETRY_PACKETS_H_
 #define _INSPACE_TELEMETRY_PACKETS_H_
 
+#include "../collection/decimator.h"
 #include "../collection/status-update.h"
 #include "../fusion/fusion.h"
+#include "blocks.h"
 #include <nuttx/uorb.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -13,6 +16,19 @@
 
 #define PACKET_MAX_SIZE 255
 
+/* The bytes a parity packet adds in front of the data packet bytes it covers */
+
+#define PACKET_FEC_OVERHEAD 3
+
+/* The maximum size a data packet can be in bytes. With forward error correction, data packets leave room for a parity
+ * packet covering them to fit in PACKET_MAX_SIZE. */
+
+#if defined(CONFIG_INSPACE_TELEMETRY_FEC)
+#define PACKET_DATA_MAX_SIZE (PACKET_MAX_SIZE - PACKET_FEC_OVERHEAD)
+#else
+#define PACKET_DATA_MAX_SIZE PACKET_MAX_SIZE
+#endif
+
 /* The maximum size a block can be in bytes. */
 
 #define BLOCK_MAX_SIZE 128
@@ -21,21 +37,12 @@
 
 #define TIGHTLY_PACKED __attribute__((packed, aligned(1)))
 
-/* Possible sub-types of data blocks that can be sent. */
+/* Possible sub-types of data blocks that can be sent, one for each entry in BLOCK_TYPES */
+
+#define BLOCK_TYPE_ID(type, id, body, sample, description) type = id,
+
 enum block_type_e {
-    DATA_ALT_SEA = 0x0,     /* Altitude above sea level */
-    DATA_ALT_LAUNCH = 0x1,  /* Altitude above launch level */
-    DATA_TEMP = 0x2,        /* Temperature data */
-    DATA_PRESSURE = 0x3,    /* Pressure data */
-    DATA_ACCEL_REL = 0x4,   /* Relative linear acceleration data */
-    DATA_ANGULAR_VEL = 0x5, /* Angular velocity data */
-    DATA_HUMIDITY = 0x6,    /* Humidity data */
-    DATA_LAT_LONG = 0x7,    /* Latitude and longitude coordinates */
-    DATA_VOLTAGE = 0x8,     /* Voltage in millivolts with a unique ID. */
-    DATA_MAGNETIC = 0x9,    /* Magnetic field data */
-    DATA_STATUS = 0xA,      /* Status information */
-    DATA_ERROR = 0xB,       /* Error information */
-    DATA_RES_ABOVE = 0xC,   /* Types unused above this value */
+    BLOCK_TYPES(BLOCK_TYPE_ID) DATA_RES_ABOVE, /* Types unused above this value */
 };
 
 /* Each radio packet will have a header in this format. */
@@ -69,149 +76,89 @@ uint8_t *block_body(uint8_t *block);
 uint8_t *pkt_init(uint8_t *packet, uint8_t packet_num, uint32_t mission_time);
 uint8_t *pkt_create_blk(uint8_t *packet, uint8_t *block, enum block_type_e type, uint32_t mission_time);
 
-/* A data block containing information about altitude. */
-struct alt_blk_t {
-    /* The offset from the absolute time in the header in milliseconds */
-    int16_t time_offset;
-    /* Altitude in units of millimetres above/below the launch height. */
-    int32_t altitude;
-} TIGHTLY_PACKED;
-
-void alt_blk_init(struct alt_blk_t *b, const int32_t altitude);
-
-/* A data block containing information about temperature. */
-struct temp_blk_t {
-    /* The offset from the absolute time in the header in milliseconds */
-    int16_t time_offset;
-    /* Temperature in millidegrees Celsius. */
-    int32_t temperature;
-} TIGHTLY_PACKED;
-
-void temp_blk_init(struct temp_blk_t *b, const int32_t temperature);
-
-/* A data block containing information about humidity. */
-struct hum_blk_t {
-    /* The offset from the absolute time in the header in milliseconds */
-    int16_t time_offset;
-    /* Relative humidity in ten thousandths of a percent. */
-    uint32_t humidity;
-} TIGHTLY_PACKED;
-
-void hum_blk_init(struct hum_blk_t *b, const uint32_t humidity);
-
-/* A data block containing information about pressure. */
-struct pres_blk_t {
-    /* The offset from the absolute time in the header in milliseconds */
-    int16_t time_offset;
-    /* Pressure measured in Pascals. */
-    uint32_t pressure;
-} TIGHTLY_PACKED;
-
-void pres_blk_init(struct pres_blk_t *b, const int32_t pressure);
-
-/* A data block containing information about angular velocity. */
-struct ang_vel_blk_t {
-    /* The offset from the absolute time in the header in milliseconds */
-    int16_t time_offset;
-    /* Angular velocity in the x-axis measured in tenths of degrees per second.
-     */
-    int16_t x;
-    /* Angular velocity in the y-axis measured in tenths of degrees per second.
-     */
-    int16_t y;
-    /* Angular velocity in the z-axis measured in tenths of degrees per second.
-     */
-    int16_t z;
-} TIGHTLY_PACKED;
-
-void ang_vel_blk_init(struct ang_vel_blk_t *b, const int16_t x_axis, const int16_t y_axis, const int16_t z_axis);
-
-/* A data block containing information about acceleration. */
-struct accel_blk_t {
-    /* The offset from the absolute time in the header in milliseconds */
-    int16_t time_offset;
-    /* Linear acceleration in the x-axis measured in centimetres per second
-     * squared. */
-    int16_t x;
-    /* Linear acceleration in the y-axis measured in centimetres per second
-     * squared. */
-    int16_t y;
-    /* Linear acceleration in the z-axis measured in centimetres per second
-     * squared. */
-    int16_t z;
-} TIGHTLY_PACKED;
-
-void accel_blk_init(struct accel_blk_t *b, const int16_t x_axis, const int16_t y_axis, const int16_t z_axis);
-
-/* A data block containing information about acceleration. */
-struct mag_blk_t {
-    /* The offset from the absolute time in the header in 0.1 microtesla */
-    int16_t time_offset;
-    /* Magnetic field in the x-axis measured in 0.1 microtesla */
-    int16_t x;
-    /* Magnetic field in the y-axis measured in 0.1 microtesla */
-    int16_t y;
-    /* Magnetic field in the z-axis measured in 0.1 microtesla */
-    int16_t z;
-} TIGHTLY_PACKED;
-
-void mag_blk_init(struct mag_blk_t *b, const int16_t x_axis, const int16_t y_axis, const int16_t z_axis);
-
-/* A data block containing latitude and longitude coordinates. */
-struct coord_blk_t {
-    /* The offset from the absolute time in the header in milliseconds */
-    int16_t time_offset;
+/* The body of each block, from BLOCK_BODIES. Every body starts with its time offset. */
+
+#define BLOCK_STRUCT_FIELD(body, type, sign, field, unit, scale, source) type field;
+#define BLOCK_STRUCT_ARRAY(body, type, sign, field, count, unit) type field[count];
+#define BLOCK_STRUCT(name)                                                                                             \
+    struct name##_t {                                                                                                  \
+        int16_t time_offset;                                                                                           \
+        name##_fields(BLOCK_STRUCT_FIELD, BLOCK_STRUCT_ARRAY, name)                                                    \
+    } TIGHTLY_PACKED;
+
+BLOCK_BODIES(BLOCK_STRUCT)
+
+/* Initializers of each block body, which set every field but the time offset, in the order of the body's fields */
+
+#define BLOCK_INIT_PARAM(body, type, sign, field, unit, scale, source) , const type field
+#define BLOCK_INIT_ARRAY_PARAM(body, type, sign, field, count, unit) , const type field[count]
+#define BLOCK_INIT_DECL(name)                                                                                          \
+    void name##_init(struct name##_t *b name##_fields(BLOCK_INIT_PARAM, BLOCK_INIT_ARRAY_PARAM, name));
+
+BLOCK_BODIES(BLOCK_INIT_DECL)
+
+/* Downsampled latitude and longitude, already in the units of a coordinate block so they can be averaged exactly */
+struct coord_sample {
+    /* Timestamp in microseconds */
+    uint64_t timestamp;
     /* Latitude in 0.1 microdegrees/LSB. */
     int32_t latitude;
     /* Longitude in 0.1 microdegrees/LSB. */
     int32_t longitude;
-} TIGHTLY_PACKED;
-
-void coord_blk_init(struct coord_blk_t *b, const int32_t lat, const int32_t lon);
-
-/* A data block containing voltage measurements and an ID for the sensor with
- * the associated voltage. */
-struct volt_blk_t {
-    /* The offset from the absolute time in the header in milliseconds */
-    int16_t time_offset;
-    /* Voltage in millivolts. */
-    int16_t voltage;
-    /* Unique sensor ID. */
-    uint8_t id;
-} TIGHTLY_PACKED;
-
-void volt_blk_init(struct volt_blk_t *b, const uint8_t id, const int16_t voltage);
-
-/* A data block containing information about the rocket's current status */
-struct status_blk_t {
-    /* The offset from the absolute time in the header in milliseconds */
-    int16_t time_offset;
-    /* A status code, one of the values in status_blk_code_e */
-    uint8_t status_code;
-} TIGHTLY_PACKED;
-
-void status_blk_init(struct status_blk_t *b, const uint8_t status_code);
-
-/* A data block containing information about an error that occured */
-struct error_blk_t {
-    /* The offset from the absolute time in the header in milliseconds */
-    int16_t time_offset;
-    /* The originating process, must be a value less than 32, as top 3 bits are reserved */
-    uint8_t originating_process;
-    /* An error code, one of the values in error_blk_code_e */
-    uint8_t error_code;
-} TIGHTLY_PACKED;
-
-void error_blk_init(struct error_blk_t *b, const uint8_t proc_id, const uint8_t error_code);
-
-int orb_accel_pkt(struct sensor_accel *accel, struct accel_blk_t *blk, uint16_t base_time);
-int orb_ang_vel_pkt(struct sensor_gyro *gyro, struct ang_vel_blk_t *blk, uint16_t base_time);
-int orb_mag_pkt(struct sensor_mag *mag, struct mag_blk_t *blk, uint16_t base_time);
-int orb_baro_pkt(struct sensor_baro *baro, struct pres_blk_t *blk, uint16_t base_time);
-int orb_baro_temp_pkt(struct sensor_baro *baro, struct temp_blk_t *blk, uint16_t base_time);
-int orb_alt_pkt(struct fusion_altitude *alt, struct alt_blk_t *blk, uint16_t base_time);
-int orb_gnss_pkt(struct sensor_gnss *gnss, struct coord_blk_t *blk, uint16_t base_time);
-int orb_error_pkt(struct error_message *error, struct error_blk_t *blk, uint16_t base_time);
-int orb_status_pkt(struct status_message *status, struct status_blk_t *blk, uint16_t base_time);
+};
+
+/* Encoders of each block body written from a single sample, from BLOCK_ENCODERS. Each returns 0 on success, or -1 if
+ * the sample's time can't be offset from base_time. */
+
+#define BLOCK_ENCODER_DECL(function, source, body, label)                                                              \
+    int function(source *sample, struct body##_t *blk, uint16_t base_time);
+
+BLOCK_ENCODERS(BLOCK_ENCODER_DECL)
+
+int orb_accel_env_pkt(struct decimator_envelope *env, struct accel_env_blk_t *blk, uint16_t base_time);
+int orb_ang_vel_env_pkt(struct decimator_envelope *env, struct ang_vel_env_blk_t *blk, uint16_t base_time);
+int delta_blk_encode(uint8_t *body, size_t space, const struct axes_blk_t *samples, int n, size_t *body_len);
+int delta_blk_decode(const uint8_t *body, size_t space, uint8_t count, struct axes_blk_t *samples);
+
+/* A field of a block body, for decoding it without knowing its type */
+struct block_field {
+    const char *name; /* The field's name */
+    const char *unit; /* The unit of the field's values, empty if they have none */
+    uint8_t offset;   /* Where the field is in the body */
+    uint8_t size;     /* The size of each of the field's values */
+    uint8_t count;    /* The number of values, more than 1 for arrays */
+    bool is_signed;   /* If the values are signed */
+};
+
+/* The layout of a block body */
+struct block_body_desc {
+    const char *name;                 /* The name of the body's struct */
+    size_t len;                       /* The size of the body */
+    const struct block_field *fields; /* The body's fields, starting with its time offset */
+    uint8_t n_fields;                 /* The number of fields */
+};
+
+/* A block type */
+struct block_desc {
+    const char *name;                     /* The name of the block type */
+    const char *description;              /* What the block holds */
+    const struct block_body_desc *body;   /* The block's body */
+    const struct block_body_desc *sample; /* The body each of the block's samples decodes to */
+};
+
+/* Called with each sample of a decoded packet
+ *
+ * @param arg The argument given to packet_decode
+ * @param type The type of the sample's block
+ * @param body The layout of the sample
+ * @param sample The sample
+ * @return 0 to carry on decoding, anything else to stop and have packet_decode return it
+ */
+typedef int (*block_sample_f)(void *arg, enum block_type_e type, const struct block_body_desc *body,
+                              const void *sample);
+
+const struct block_desc *block_desc(enum block_type_e type);
+int block_field_value(const void *body, const struct block_field *field, int i, int64_t *value);
+int packet_decode(const uint8_t *packet, size_t len, block_sample_f on_sample, void *arg);
 
 #endif // _INSPACE_TELEMETRY_PACKET_H_
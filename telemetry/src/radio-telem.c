@@ -0,0 +1,306 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "radio-telem.h"
+
+/* Set in the middle index when the middle buffer was published and hasn't been acquired */
+
+#define RADIO_TELEM_FRESH 0x4
+
+/* Masks the buffer index out of the middle index */
+
+#define RADIO_TELEM_INDEX 0x3
+
+/* Where a channel's data is in radio_raw_data */
+
+struct radio_channel {
+    uint16_t data_offset;  /* Offset of the channel's array */
+    uint16_t count_offset; /* Offset of the channel's element count */
+    uint16_t size;         /* Size of an element */
+    uint16_t env_offset;   /* Offset of the envelope array counted by the same count, 0 if there isn't one */
+};
+
+/* Describe a channel given the name of its array, and the name of its envelope array */
+
+#define channel_slot(field)                                                                                            \
+    .data_offset = offsetof(radio_raw_data, field), .count_offset = offsetof(radio_raw_data, field##_n),               \
+    .size = sizeof(((radio_raw_data *)0)->field[0])
+
+#ifdef CONFIG_INSPACE_DOWNSAMPLING_ENVELOPE
+#define envelope_slot(field) .env_offset = offsetof(radio_raw_data, field)
+#else
+#define envelope_slot(field) .env_offset = 0
+#endif
+
+static const struct radio_channel radio_channels[] = {
+    [RADIO_GNSS] = {channel_slot(gnss)},
+    [RADIO_ALT] = {channel_slot(alt)},
+    [RADIO_MAG] = {channel_slot(mag)},
+    [RADIO_ACCEL] = {channel_slot(accel), envelope_slot(accel_env)},
+    [RADIO_GYRO] = {channel_slot(gyro), envelope_slot(gyro_env)},
+    [RADIO_BARO] = {channel_slot(baro)},
+};
+
+/* Get the element count of a channel
+ *
+ * @param data The data to get the count from
+ * @param ch The channel to get the count of
+ * @return A pointer to the channel's count
+ */
+static int *channel_count(radio_raw_data *data, enum radio_channel_e ch) {
+    return (int *)((uint8_t *)data + radio_channels[ch].count_offset);
+}
+
+/* Copy data, leaving out any elements of each channel numbered before `from`. The source and destination may be the
+ * same buffer.
+ *
+ * @param dst Where to copy the data to
+ * @param src The data to copy
+ * @param from The sequence number of the first element to keep in each channel
+ */
+static void copy_from(radio_raw_data *dst, radio_raw_data *src, const uint32_t *from) {
+    for (int ch = 0; ch < RADIO_NUM_CHANNELS; ch++) {
+        const struct radio_channel *channel = &radio_channels[ch];
+        int n = *channel_count(src, ch);
+        int32_t skip = (int32_t)(from[ch] - src->first_seq[ch]);
+
+        if (skip < 0) {
+            skip = 0;
+        } else if (skip > n) {
+            skip = n;
+        }
+
+        memmove((uint8_t *)dst + channel->data_offset, (uint8_t *)src + channel->data_offset + skip * channel->size,
+                (n - skip) * channel->size);
+        if (channel->env_offset != 0) {
+            memmove((uint8_t *)dst + channel->env_offset,
+                    (uint8_t *)src + channel->env_offset + skip * sizeof(struct decimator_envelope),
+                    (n - skip) * sizeof(struct decimator_envelope));
+        }
+        *channel_count(dst, ch) = n - skip;
+        dst->first_seq[ch] = src->first_seq[ch] + skip;
+    }
+}
+
+/* Get the sequence numbers after the last element of each channel
+ *
+ * @param data The data to get the sequence numbers of
+ * @param end Where to store one sequence number per channel
+ */
+static void seq_end(radio_raw_data *data, uint32_t *end) {
+    for (int ch = 0; ch < RADIO_NUM_CHANNELS; ch++) {
+        end[ch] = data->first_seq[ch] + *channel_count(data, ch);
+    }
+}
+
+/**
+ * Get the number of elements in a channel
+ *
+ * @param data The data to get the count from
+ * @param ch The channel to get the count of
+ * @return The number of elements
+ */
+int radio_data_count(radio_raw_data *data, enum radio_channel_e ch) { return *channel_count(data, ch); }
+
+/**
+ * Get an element of a channel. Every element starts with its uint64_t timestamp in microseconds.
+ *
+ * @param data The data to get the element from
+ * @param ch The channel to get the element from
+ * @param i The index of the element
+ * @return A pointer to the element
+ */
+void *radio_data_element(radio_raw_data *data, enum radio_channel_e ch, int i) {
+    return (uint8_t *)data + radio_channels[ch].data_offset + i * radio_channels[ch].size;
+}
+
+/**
+ * Get the envelope of an element of a channel
+ *
+ * @param data The data to get the envelope from
+ * @param ch The channel to get the envelope from
+ * @param i The index of the element
+ * @return A pointer to the envelope, or NULL if the channel doesn't track envelopes
+ */
+struct decimator_envelope *radio_data_envelope(radio_raw_data *data, enum radio_channel_e ch, int i) {
+    if (radio_channels[ch].env_offset == 0) {
+        return NULL;
+    }
+    return (struct decimator_envelope *)((uint8_t *)data + radio_channels[ch].env_offset) + i;
+}
+
+/**
+ * Remove the oldest elements of each channel
+ *
+ * @param data The data to remove elements from
+ * @param taken The number of elements to remove from each channel
+ */
+void radio_data_take(radio_raw_data *data, const int *taken) {
+    uint32_t from[RADIO_NUM_CHANNELS];
+    for (int ch = 0; ch < RADIO_NUM_CHANNELS; ch++) {
+        from[ch] = data->first_seq[ch] + taken[ch];
+    }
+    copy_from(data, data, from);
+}
+
+/**
+ * Append the elements of each channel of `src` to `dst`. Where a channel would hold more elements than fit, its oldest
+ * elements are dropped.
+ *
+ * @param dst The data to append to
+ * @param src The data to append
+ * @return The number of elements dropped
+ */
+int radio_data_merge(radio_raw_data *dst, radio_raw_data *src) {
+    uint32_t from[RADIO_NUM_CHANNELS];
+    int dropped = 0;
+
+    /* Make room for the new elements first */
+
+    for (int ch = 0; ch < RADIO_NUM_CHANNELS; ch++) {
+        int over = *channel_count(dst, ch) + *channel_count(src, ch) - RADIO_DATA_LEN;
+        over = over > 0 ? over : 0;
+        from[ch] = dst->first_seq[ch] + over;
+        dropped += over;
+    }
+    copy_from(dst, dst, from);
+
+    for (int ch = 0; ch < RADIO_NUM_CHANNELS; ch++) {
+        const struct radio_channel *channel = &radio_channels[ch];
+        int n = *channel_count(dst, ch);
+        int add = *channel_count(src, ch);
+
+        /* The kept elements are renumbered so they lead straight into the new ones */
+
+        memcpy((uint8_t *)dst + channel->data_offset + n * channel->size, (uint8_t *)src + channel->data_offset,
+               add * channel->size);
+        if (channel->env_offset != 0) {
+            memcpy((uint8_t *)dst + channel->env_offset + n * sizeof(struct decimator_envelope),
+                   (uint8_t *)src + channel->env_offset, add * sizeof(struct decimator_envelope));
+        }
+        *channel_count(dst, ch) = n + add;
+        dst->first_seq[ch] = src->first_seq[ch] - n;
+    }
+    return dropped;
+}
+
+/**
+ * Initialize the radio telemetry buffers, empty and with nothing published
+ *
+ * @param radio_telem The buffers to initialize
+ */
+void radio_telem_init(radio_telem_t *radio_telem) {
+    memset(radio_telem, 0, sizeof(*radio_telem));
+    radio_telem->write = 0;
+    radio_telem->read = 1;
+    atomic_init(&radio_telem->middle, 2);
+    atomic_init(&radio_telem->period_ms, 0);
+}
+
+/**
+ * Get the buffer the producer adds data to. Only to be used by the producer.
+ *
+ * @param radio_telem The radio telemetry buffers
+ * @return The staging buffer
+ */
+radio_raw_data *radio_telem_writable(radio_telem_t *radio_telem) { return &radio_telem->staging; }
+
+/**
+ * Remove data the consumer has acquired from the staging buffer. Only to be used by the producer.
+ *
+ * @param radio_telem The radio telemetry buffers
+ * @return 1 if the consumer has acquired data since the last call, 0 otherwise
+ */
+int radio_telem_reclaim(radio_telem_t *radio_telem) {
+    int taken;
+
+    /* The consumer always acquires the newest publish, so everything in it has been delivered */
+
+    if (radio_telem->published &&
+        !(atomic_load_explicit(&radio_telem->middle, memory_order_acquire) & RADIO_TELEM_FRESH)) {
+        copy_from(&radio_telem->staging, &radio_telem->staging, radio_telem->published_end);
+        radio_telem->published = 0;
+        radio_telem->taken = 1;
+    }
+
+    taken = radio_telem->taken;
+    radio_telem->taken = 0;
+    return taken;
+}
+
+/**
+ * Publish everything in the staging buffer that the consumer hasn't acquired. Only to be used by the producer.
+ *
+ * @param radio_telem The radio telemetry buffers
+ */
+void radio_telem_publish(radio_telem_t *radio_telem) {
+    uint32_t end[RADIO_NUM_CHANNELS];
+    uint_fast8_t old;
+
+    memcpy(&radio_telem->buffs[radio_telem->write], &radio_telem->staging, sizeof(radio_raw_data));
+    seq_end(&radio_telem->staging, end);
+
+    old = atomic_exchange_explicit(&radio_telem->middle, radio_telem->write | RADIO_TELEM_FRESH, memory_order_acq_rel);
+    radio_telem->write = old & RADIO_TELEM_INDEX;
+
+    /* The previous publish may have been acquired since the last reclaim */
+
+    if (radio_telem->published && !(old & RADIO_TELEM_FRESH)) {
+        copy_from(&radio_telem->staging, &radio_telem->staging, radio_telem->published_end);
+        radio_telem->taken = 1;
+    }
+
+    memcpy(radio_telem->published_end, end, sizeof(end));
+    radio_telem->published = 1;
+}
+
+/**
+ * Get the data published since the last acquire. The buffer is owned by the consumer until the next acquire. Only to be
+ * used by the consumer.
+ *
+ * @param radio_telem The radio telemetry buffers
+ * @return A buffer of data that hasn't been acquired before, which is empty if nothing new was published
+ */
+radio_raw_data *radio_telem_acquire(radio_telem_t *radio_telem) {
+    radio_raw_data *data = &radio_telem->buffs[radio_telem->read];
+    uint_fast8_t old;
+
+    /* Nothing new, empty the buffer that was already transmitted */
+
+    if (!(atomic_load_explicit(&radio_telem->middle, memory_order_acquire) & RADIO_TELEM_FRESH)) {
+        for (int ch = 0; ch < RADIO_NUM_CHANNELS; ch++) {
+            *channel_count(data, ch) = 0;
+            data->first_seq[ch] = radio_telem->read_end[ch];
+        }
+        return data;
+    }
+
+    old = atomic_exchange_explicit(&radio_telem->middle, radio_telem->read, memory_order_acq_rel);
+    radio_telem->read = old & RADIO_TELEM_INDEX;
+    data = &radio_telem->buffs[radio_telem->read];
+
+    /* A publish can repeat data from one the consumer already acquired */
+
+    copy_from(data, data, radio_telem->read_end);
+    seq_end(data, radio_telem->read_end);
+    return data;
+}
+
+/**
+ * Tell the producer how often the consumer will acquire data, so it can size its output to fill each acquire. Only to
+ * be used by the consumer.
+ *
+ * @param radio_telem The radio telemetry buffers
+ * @param period_ms The time between acquires in milliseconds
+ */
+void radio_telem_set_period(radio_telem_t *radio_telem, uint32_t period_ms) {
+    atomic_store(&radio_telem->period_ms, period_ms);
+}
+
+/**
+ * Get how often the consumer acquires data
+ *
+ * @param radio_telem The radio telemetry buffers
+ * @return The time between acquires in milliseconds, 0 if the consumer hasn't set it
+ */
+uint32_t radio_telem_period(radio_telem_t *radio_telem) { return atomic_load(&radio_telem->period_ms); }
@@ -3,26 +3,84 @@
 
 #include "fusion/fusion.h"
 #include "packets/packets.h"
-#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+/* The kinds of downsampled data shared with the transmit thread, used to index radio_raw_data.first_seq */
+
+enum radio_channel_e {
+    RADIO_GNSS = 0,  /* gnss */
+    RADIO_ALT = 1,   /* alt */
+    RADIO_MAG = 2,   /* mag */
+    RADIO_ACCEL = 3, /* accel, and accel_env if envelopes are tracked */
+    RADIO_GYRO = 4,  /* gyro, and gyro_env if envelopes are tracked */
+    RADIO_BARO = 5,  /* baro */
+    RADIO_NUM_CHANNELS,
+};
+
+/* The most elements each channel holds, enough for a burst of packets' worth of downsampler outputs */
+
+#define RADIO_DATA_LEN (CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ * CONFIG_INSPACE_TELEMETRY_BURST_MAX)
 
 typedef struct {
-    struct sensor_gnss gnss[CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ];
+    struct coord_sample gnss[RADIO_DATA_LEN];
     int gnss_n;
-    struct fusion_altitude alt[CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ];
+    struct fusion_altitude alt[RADIO_DATA_LEN];
     int alt_n;
-    struct sensor_mag mag[CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ];
+    struct sensor_mag mag[RADIO_DATA_LEN];
     int mag_n;
-    struct sensor_accel accel[CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ];
+    struct sensor_accel accel[RADIO_DATA_LEN];
     int accel_n;
-    struct sensor_gyro gyro[CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ];
+    struct sensor_gyro gyro[RADIO_DATA_LEN];
     int gyro_n;
+    struct sensor_baro baro[RADIO_DATA_LEN];
+    int baro_n;
+#ifdef CONFIG_INSPACE_DOWNSAMPLING_ENVELOPE
+    struct decimator_envelope accel_env[RADIO_DATA_LEN]; /* Counted by accel_n */
+    struct decimator_envelope gyro_env[RADIO_DATA_LEN];  /* Counted by gyro_n */
+#endif
+    uint32_t first_seq[RADIO_NUM_CHANNELS]; /* Sequence number of the first element of each channel */
 } radio_raw_data;
 
+/* Single producer, single consumer triple buffer of radio_raw_data. The downsample thread adds data to its staging
+ * buffer and publishes a copy of it, the transmit thread acquires the latest published copy. Buffers are handed over
+ * by atomically exchanging the index of the middle buffer, so neither thread ever waits for the other.
+ *
+ * The staging buffer keeps everything that hasn't been seen to be acquired, so a publish replacing an unread one loses
+ * nothing. Each channel's elements are numbered so the consumer can drop the ones it has already acquired. All data is
+ * delivered exactly once unless the staging buffer fills up before the consumer acquires it.
+ */
 typedef struct {
-    radio_raw_data *buff;
-    pthread_mutex_t buff_mux;
-    sem_t swapped;
-    radio_raw_data *empty_buff; /* internal to the downsampler thread */
+    radio_raw_data buffs[3];
+    atomic_uint_fast8_t middle;     /* Index of the middle buffer, with RADIO_TELEM_FRESH set if it's unread */
+    atomic_uint_fast32_t period_ms; /* How often the consumer acquires data in milliseconds, 0 until it's set */
+
+    /* Owned by the producer */
+
+    radio_raw_data staging;                     /* Data added since the last publish seen to be acquired */
+    uint8_t write;                              /* Index of the buffer the next publish is copied into */
+    uint8_t published;                          /* If the last publish hasn't been seen to be acquired yet */
+    uint8_t taken;                              /* If an acquire was seen that hasn't been reported yet */
+    uint32_t published_end[RADIO_NUM_CHANNELS]; /* Sequence numbers after the last published elements */
+
+    /* Owned by the consumer */
+
+    uint8_t read;                          /* Index of the buffer being transmitted */
+    uint32_t read_end[RADIO_NUM_CHANNELS]; /* Sequence numbers after the last acquired elements */
 } radio_telem_t;
 
+int radio_data_count(radio_raw_data *data, enum radio_channel_e ch);
+void *radio_data_element(radio_raw_data *data, enum radio_channel_e ch, int i);
+struct decimator_envelope *radio_data_envelope(radio_raw_data *data, enum radio_channel_e ch, int i);
+void radio_data_take(radio_raw_data *data, const int *taken);
+int radio_data_merge(radio_raw_data *dst, radio_raw_data *src);
+
+void radio_telem_init(radio_telem_t *radio_telem);
+radio_raw_data *radio_telem_writable(radio_telem_t *radio_telem);
+int radio_telem_reclaim(radio_telem_t *radio_telem);
+void radio_telem_publish(radio_telem_t *radio_telem);
+radio_raw_data *radio_telem_acquire(radio_telem_t *radio_telem);
+void radio_telem_set_period(radio_telem_t *radio_telem, uint32_t period_ms);
+uint32_t radio_telem_period(radio_telem_t *radio_telem);
+
 #endif
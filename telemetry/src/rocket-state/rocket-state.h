@@ -8,7 +8,8 @@
 #if defined(CONFIG_LPWAN_RN2XX3)
 #include <nuttx/wireless/lpwan/rn2xx3.h>
 #else
-enum rn2xx3_cr_e { SIM_NO_CODE_RATE = 0x0 };
+/* The RN2xx3's coding rates, so a radio configuration means the same without the radio */
+enum rn2xx3_cr_e { RN2XX3_CR_4_5 = 0, RN2XX3_CR_4_6 = 1, RN2XX3_CR_4_7 = 2, RN2XX3_CR_4_8 = 3 };
 #endif
 
 /* Enum representing the current flight state. */
@@ -2,13 +2,15 @@
 "CU InSpace Josh\n2025\n\nGENERAL COMMANDS:\n    \n    help        Displays t" \
 "his help menu.\n    reboot      Reboots the board for changes to take effect" \
 ".\n    load        Loads the current configuration from EEPROM so it can be" \
-"                modified. Overwrites unsaved modifications.\n    save       " \
-" Saves the modified configuration to EEPROM.\n    disk        Shows the conf" \
-"iguration currently saved on disk.\n    current     Shows the currently modi" \
-"fied configuration in RAM.\n\nRADIO PARAMETERS:\n\n    frequency   Sets freq" \
-"uency in Hz.\n    bandwidth   Sets bandwidth in kHz. Can be 125, 250 or 500." \
-"\n    preamble    Sets preamble length.\n    spread      Sets spread factor." \
-"\n    txpwr       Sets transmit power in dBm.\n    sync        Sets sync wor" \
-"d, provided in hexadecimal.\n    crc         Enable/disable cyclic redundanc" \
-"y check. Provide 0 or 1.\n    iqi         Enable/disable IQI. Provide 0 or 1" \
-".\n    coder       Set the coding rate, expressed as a fraction (i.e 4/5).\n"
+"\n                modified. Overwrites unsaved modifications.\n    save     " \
+"   Saves the modified configuration to EEPROM.\n    disk        Shows the co" \
+"nfiguration currently saved on disk.\n    current     Shows the currently mo" \
+"dified configuration in RAM.\n    txstats     Shows the latest measurements " \
+"of the radio downlink and the\n                sensor rates feeding it.\n\nR" \
+"ADIO PARAMETERS:\n\n    frequency   Sets frequency in Hz.\n    bandwidth   S" \
+"ets bandwidth in kHz. Can be 125, 250 or 500.\n    preamble    Sets preamble" \
+" length.\n    spread      Sets spread factor.\n    txpwr       Sets transmit" \
+" power in dBm.\n    sync        Sets sync word, provided in hexadecimal.\n  " \
+"  crc         Enable/disable cyclic redundancy check. Provide 0 or 1.\n    i" \
+"qi         Enable/disable IQI. Provide 0 or 1.\n    coder       Set the codi" \
+"ng rate, expressed as a fraction (i.e 4/5).\n"
@@ -13,8 +13,10 @@
 #include <nuttx/usb/cdcacm.h>
 #include <sys/boardctl.h>
 
+#include "../collection/downsample.h"
 #include "../rocket-state/rocket-state.h"
 #include "../syslogging.h"
+#include "../transmission/transmit-stats.h"
 #include "helptext.h"
 #include "shell.h"
 
@@ -33,6 +35,8 @@
 static int usb_init(void);
 static int read_command(int usbfd, char *buf, size_t n);
 static void print_config(int usbfd, struct config_options const *config);
+static void print_transmit_stats(int usbfd);
+static void print_downsample_rates(int usbfd);
 static char *get_first_arg(char *command);
 
 /* Main shell thread for configuring parameters in the EEPROM and controlling the operation of the flight computer.
@@ -124,6 +128,11 @@ void *shell_main(void *arg) {
                 dprintf(usbfd, "Couldn't write to EEPROM\n");
             }
             dprintf(usbfd, "Configuration saved!\n");
+        } else if (strstr(command_in, "txstats")) {
+            /* Shows the latest measurements of the transmit thread */
+
+            print_transmit_stats(usbfd);
+            print_downsample_rates(usbfd);
         } else if (strstr(command_in, "help")) {
             /* Print out the help text for the shell */
 
@@ -295,6 +304,72 @@ static void print_radio_config(int usbfd, struct radio_options const *config) {
 /* Prints the configuration parameter struct in a user legible way */
 static void print_config(int usbfd, struct config_options const *config) { print_radio_config(usbfd, &config->radio); }
 
+/* Prints a latency histogram on one line, leaving out the empty buckets */
+static void print_histogram(int usbfd, char const *name, uint32_t const *hist) {
+    dprintf(usbfd, "\t%s:", name);
+    for (int i = 0; i < TRANSMIT_HIST_BUCKETS; i++) {
+        if (hist[i] == 0) {
+            continue;
+        }
+        if (i == 0) {
+            dprintf(usbfd, " <1ms: %lu", (unsigned long)hist[i]);
+        } else if (i == TRANSMIT_HIST_BUCKETS - 1) {
+            dprintf(usbfd, " >=%lums: %lu", 1UL << (i - 1), (unsigned long)hist[i]);
+        } else {
+            dprintf(usbfd, " %lu-%lums: %lu", 1UL << (i - 1), (1UL << i) - 1, (unsigned long)hist[i]);
+        }
+    }
+    dprintf(usbfd, "\n");
+}
+
+/* Prints the latest transmit stats published by the transmit thread in a user legible way */
+static void print_transmit_stats(int usbfd) {
+    struct transmit_stats stats;
+    int fd = orb_subscribe(ORB_ID(transmit_stats));
+
+    if (fd < 0) {
+        dprintf(usbfd, "Couldn't subscribe to transmit stats: %d\n", errno);
+        return;
+    }
+    if (orb_copy(ORB_ID(transmit_stats), fd, &stats) < 0) {
+        dprintf(usbfd, "No transmit stats published yet\n");
+        orb_unsubscribe(fd);
+        return;
+    }
+    orb_unsubscribe(fd);
+
+    dprintf(usbfd, "transmit {\n");
+    dprintf(usbfd, "\tPackets sent: %lu (%lu bytes)\n", (unsigned long)stats.packets_sent,
+            (unsigned long)stats.bytes_sent);
+    dprintf(usbfd, "\tThroughput: %lu bytes/s, %lu samples/s\n", (unsigned long)stats.bytes_per_s,
+            (unsigned long)stats.samples_per_s);
+    dprintf(usbfd, "\tQueued: %lu, overwritten: %lu, empty swaps: %lu\n", (unsigned long)stats.queue_depth,
+            (unsigned long)stats.overwrites, (unsigned long)stats.empty_swaps);
+    dprintf(usbfd, "\tRadio switches: %lu, last took %lu us, %lu failed\n", (unsigned long)stats.radio_switches,
+            (unsigned long)stats.switch_us, (unsigned long)stats.switch_fails);
+    print_histogram(usbfd, "Cycle time", stats.cycle_hist);
+    print_histogram(usbfd, "Write time", stats.write_hist);
+    for (int type = 0; type < DATA_RES_ABOVE; type++) {
+        if (stats.drops.time[type] != 0 || stats.drops.size[type] != 0) {
+            dprintf(usbfd, "\tDropped type 0x%X: %lu for time, %lu for size\n", type,
+                    (unsigned long)stats.drops.time[type], (unsigned long)stats.drops.size[type]);
+        }
+    }
+    dprintf(usbfd, "}\n");
+}
+
+/* Prints the input rate the downsampler measured for each sensor, and how far it was from its target outputs */
+static void print_downsample_rates(int usbfd) {
+    struct downsample_rate rates[DOWNSAMPLE_MAX_RATES];
+    int n = downsample_get_rates(rates, DOWNSAMPLE_MAX_RATES);
+
+    dprintf(usbfd, "downsample {\n");
+    for (int i = 0; i < n; i++) {
+        dprintf(usbfd, "\t%s: %.1f Hz, %+.1f outputs\n", rates[i].name, rates[i].input_hz, rates[i].error);
+    }
+    dprintf(usbfd, "}\n");
+}
+
 /* Gets the first argument in the command (based on space separation). */
 static char *get_first_arg(char *command) {
     strtok(command, " ");
@@ -31,9 +31,7 @@ static pthread_t shell_thread;
 static rocket_state_t state; /* The shared rocket state. */
 static struct config_options config;
 
-/* Radio telemetry double-buffer storage */
-static radio_raw_data radio_buf1;
-static radio_raw_data radio_buf2;
+/* Radio telemetry triple-buffer storage */
 static radio_telem_t radio_telem;
 
 int main(int argc, char **argv) {
@@ -79,14 +77,7 @@ int main(int argc, char **argv) {
         state_set_flightsubstate(&state, SUBSTATE_UNKNOWN);
     }
 
-    radio_telem.buff = &radio_buf1;
-    radio_telem.empty_buff = &radio_buf2;
-
-    memset(&radio_buf1, 0, sizeof(radio_buf1));
-    memset(&radio_buf2, 0, sizeof(radio_buf2));
-
-    pthread_mutex_init(&(radio_telem.buff_mux), NULL);
-    sem_init(&radio_telem.swapped, 0, 0);
+    radio_telem_init(&radio_telem);
 
     /* Start all threads */
     struct fusion_args fusion_thread_args = {.state = &state};
@@ -107,6 +98,7 @@ int main(int argc, char **argv) {
     struct transmit_args transmit_thread_args = {
         .config = config.radio,
         .radio_telem = &radio_telem,
+        .state = &state,
     };
     err = pthread_create(&transmit_thread, NULL, transmit_main, &transmit_thread_args);
     if (err) {
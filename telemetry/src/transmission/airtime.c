@@ -0,0 +1,115 @@
+#include <errno.h>
+
+#include "../syslogging.h"
+#include "airtime.h"
+#include "transmit.h"
+
+/* The range of spread factors a LoRa modem supports */
+
+#define LORA_MIN_SPREAD 7
+#define LORA_MAX_SPREAD 12
+
+/* Symbols longer than this use low data rate optimization, which the RN2xx3 turns on by itself */
+
+#define LORA_LDRO_SYMBOL_NS 16000000ULL
+
+/* Extra time on air allowed per packet for the radio's own latency, as a percentage of its airtime */
+
+#ifdef CONFIG_INSPACE_TELEMETRY_ADAPTIVE_PERIOD
+#define AIRTIME_MARGIN CONFIG_INSPACE_TELEMETRY_AIRTIME_MARGIN
+#else
+#define AIRTIME_MARGIN 20
+#endif
+
+/* Get the number of parity bits per 4 data bits of a coding rate
+ *
+ * @param cr The coding rate
+ * @return 1 to 4 for 4/5 to 4/8
+ */
+static uint8_t lora_cr_parity(enum rn2xx3_cr_e cr) {
+    switch (cr) {
+    case RN2XX3_CR_4_6:
+        return 2;
+    case RN2XX3_CR_4_7:
+        return 3;
+    case RN2XX3_CR_4_8:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+/**
+ * Calculate how long a LoRa frame spends on air, following the Semtech SX127x time-on-air formula for an explicit
+ * header frame
+ *
+ * @param radio The radio's configuration
+ * @param payload_len The number of bytes in the frame's payload
+ * @param airtime_us Where to store the time on air in microseconds
+ * @return 0 on success, or -EINVAL if the configuration isn't one a LoRa modem can send with
+ */
+int lora_airtime_us(struct radio_options const *radio, size_t payload_len, uint32_t *airtime_us) {
+    if (radio->spread < LORA_MIN_SPREAD || radio->spread > LORA_MAX_SPREAD || radio->bw == 0) {
+        return -EINVAL;
+    }
+
+    uint64_t symbol_ns = (1000000ULL << radio->spread) / radio->bw;
+    int ldro = symbol_ns >= LORA_LDRO_SYMBOL_NS;
+    int32_t bits = 8 * (int32_t)payload_len - 4 * radio->spread + 28 + (radio->crc ? 16 : 0);
+    int32_t per_block = 4 * (radio->spread - 2 * ldro);
+    uint32_t symbols = 8;
+
+    if (bits > 0) {
+        symbols += (bits + per_block - 1) / per_block * (lora_cr_parity(radio->cr) + 4);
+    }
+
+    /* The preamble is followed by 4.25 symbols of sync word and start of frame delimiter */
+
+    uint64_t airtime_ns = symbol_ns * (4 * radio->preamble + 17) / 4 + symbol_ns * symbols;
+    *airtime_us = (airtime_ns + 999) / 1000;
+    return 0;
+}
+
+/**
+ * Get the transmit period that leaves room on air for packets of a size, plus a margin for the radio's own latency
+ *
+ * @param radio The radio's configuration
+ * @param packet_size The size of the packets that will be sent
+ * @return The transmit period in milliseconds, or TRANSMIT_PERIOD_MS if the period isn't adaptive or the airtime of
+ * the configuration can't be calculated
+ */
+uint32_t airtime_period_ms(struct radio_options const *radio, size_t packet_size) {
+#ifdef CONFIG_INSPACE_TELEMETRY_ADAPTIVE_PERIOD
+    uint32_t airtime_us;
+
+    if (lora_airtime_us(radio, packet_size, &airtime_us) < 0) {
+        inwarn("Can't calculate airtime with spread factor %u and bandwidth %lu kHz, transmitting every %d ms\n",
+               radio->spread, (unsigned long)radio->bw, TRANSMIT_PERIOD_MS);
+        return TRANSMIT_PERIOD_MS;
+    }
+
+    uint32_t period_ms = ((uint64_t)airtime_us * (100 + AIRTIME_MARGIN) + 99999) / 100000;
+    return period_ms > CONFIG_INSPACE_TELEMETRY_MIN_PERIOD_MS ? period_ms : CONFIG_INSPACE_TELEMETRY_MIN_PERIOD_MS;
+#else
+    return TRANSMIT_PERIOD_MS;
+#endif
+}
+
+/**
+ * Check if another packet fits on air in a transmit period, after the packets already sent in it
+ *
+ * @param radio The radio's configuration
+ * @param used_us The airtime of the packets already sent in the period, in microseconds
+ * @param packet_size The size of the next packet
+ * @param period_ms The transmit period in milliseconds
+ * @return 1 if the packet fits in the rest of the period with its margin, 0 if it doesn't or the airtime of the
+ * configuration can't be calculated
+ */
+int airtime_fits(struct radio_options const *radio, uint32_t used_us, size_t packet_size, uint32_t period_ms) {
+    uint32_t airtime_us;
+
+    if (lora_airtime_us(radio, packet_size, &airtime_us) < 0) {
+        return 0;
+    }
+    return ((uint64_t)used_us + airtime_us) * (100 + AIRTIME_MARGIN) <= (uint64_t)period_ms * 100000;
+}
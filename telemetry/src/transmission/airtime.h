@@ -0,0 +1,13 @@
+#ifndef _INSPACE_AIRTIME_H_
+#define _INSPACE_AIRTIME_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../rocket-state/rocket-state.h"
+
+int lora_airtime_us(struct radio_options const *radio, size_t payload_len, uint32_t *airtime_us);
+uint32_t airtime_period_ms(struct radio_options const *radio, size_t packet_size);
+int airtime_fits(struct radio_options const *radio, uint32_t used_us, size_t packet_size, uint32_t period_ms);
+
+#endif // _INSPACE_AIRTIME_H_
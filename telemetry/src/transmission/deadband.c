@@ -0,0 +1,150 @@
+#include <errno.h>
+#include <float.h>
+#include <string.h>
+
+#include "../syslogging.h"
+#include "deadband.h"
+
+/* The timestamp of a sample, every compressed channel's samples start with one */
+
+#define sample_timestamp(sample) (*(const uint64_t *)(sample))
+
+/* Get a compressed field of a sample
+ *
+ * @param desc The descriptor of the sample's channel
+ * @param sample The sample
+ * @param axis The index of the field
+ * @return The field's value
+ */
+static double field(const struct deadband_desc *desc, const void *sample, int axis) {
+    const uint8_t *f = (const uint8_t *)sample + desc->axis_offsets[axis];
+    return desc->type == DEADBAND_INT32 ? (double)*(const int32_t *)f : (double)*(const float *)f;
+}
+
+/* Start a new line at a sample that was just kept
+ *
+ * @param db The compressor
+ * @param sample The kept sample
+ */
+static void deadband_start(struct deadband *db, const void *sample) {
+    db->start_us = sample_timestamp(sample);
+    for (int a = 0; a < db->desc->n_axes; a++) {
+        db->start[a] = field(db->desc, sample, a);
+        db->slope_lo[a] = -DBL_MAX;
+        db->slope_hi[a] = DBL_MAX;
+    }
+    db->started = 1;
+    db->holding = 0;
+    db->kept++;
+}
+
+/* Check if a sample can end the current line, with every sample dropped since its start within band of the line
+ *
+ * @param db The compressor
+ * @param sample The sample that would end the line
+ * @return 1 if it can, 0 otherwise
+ */
+static int deadband_fits(struct deadband *db, const void *sample) {
+    uint64_t dt = sample_timestamp(sample) - db->start_us;
+
+    if (dt > db->heartbeat_us) {
+        return 0;
+    }
+
+    for (int a = 0; a < db->desc->n_axes; a++) {
+        double slope = (field(db->desc, sample, a) - db->start[a]) / dt;
+        if (slope < db->slope_lo[a] || slope > db->slope_hi[a]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Hold back a sample that can end the current line, narrowing the slopes so the line stays within band of it if it's
+ * dropped later
+ *
+ * @param db The compressor
+ * @param sample The sample to hold
+ */
+static void deadband_hold(struct deadband *db, const void *sample) {
+    double dt = sample_timestamp(sample) - db->start_us;
+
+    for (int a = 0; a < db->desc->n_axes; a++) {
+        double value = field(db->desc, sample, a) - db->start[a];
+        double lo = (value - db->desc->band[a]) / dt;
+        double hi = (value + db->desc->band[a]) / dt;
+        db->slope_lo[a] = lo > db->slope_lo[a] ? lo : db->slope_lo[a];
+        db->slope_hi[a] = hi < db->slope_hi[a] ? hi : db->slope_hi[a];
+    }
+    memcpy(db->held, sample, db->desc->size);
+    db->holding = 1;
+}
+
+/**
+ * Initialize a compressor
+ *
+ * @param db The compressor to initialize
+ * @param desc The descriptor of the channel to compress, which must outlive the compressor
+ * @param heartbeat_ms The longest time between kept samples while samples keep arriving
+ * @return 0 on success, or -EINVAL if the channel's samples can't be compressed
+ */
+int deadband_init(struct deadband *db, const struct deadband_desc *desc, uint32_t heartbeat_ms) {
+    if (desc->size > DEADBAND_MAX_SAMPLE || desc->n_axes > DEADBAND_MAX_AXES) {
+        inerr("Can't compress samples of %u bytes with %u fields\n", desc->size, desc->n_axes);
+        return -EINVAL;
+    }
+
+    memset(db, 0, sizeof(*db));
+    db->desc = desc;
+    db->heartbeat_us = (uint64_t)heartbeat_ms * 1000;
+    return 0;
+}
+
+/**
+ * Compress an array of samples in place, leaving only those the ground needs to reconstruct the rest. A sample held
+ * back from the previous call may be written in place of one from this call, so the array never grows.
+ *
+ * @param db The compressor of the samples' channel
+ * @param samples The samples, in timestamp order
+ * @param n The number of samples
+ * @return The number of samples left at the start of the array
+ */
+int deadband_filter(struct deadband *db, void *samples, int n) {
+    uint8_t *buf = samples;
+    uint64_t sample[DEADBAND_MAX_SAMPLE / sizeof(uint64_t)];
+    size_t size = db->desc->size;
+    int kept = 0;
+
+    for (int i = 0; i < n; i++) {
+        memcpy(sample, buf + i * size, size);
+
+        /* The first sample starts the first line */
+
+        if (!db->started) {
+            memcpy(buf + kept++ * size, sample, size);
+            deadband_start(db, sample);
+            continue;
+        }
+
+        /* Samples that don't come after the last one can't be placed on a line */
+
+        if (sample_timestamp(sample) <= (db->holding ? sample_timestamp(db->held) : db->start_us)) {
+            db->dropped++;
+            continue;
+        }
+
+        /* The held sample is dropped if this one can end the line instead, otherwise the line ends at the held sample
+         * and this one is the first candidate for the next line */
+
+        if (db->holding) {
+            if (deadband_fits(db, sample)) {
+                db->dropped++;
+            } else {
+                memcpy(buf + kept++ * size, db->held, size);
+                deadband_start(db, db->held);
+            }
+        }
+        deadband_hold(db, sample);
+    }
+    return kept;
+}
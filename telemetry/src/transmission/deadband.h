@@ -0,0 +1,54 @@
+#ifndef _INSPACE_DEADBAND_H_
+#define _INSPACE_DEADBAND_H_
+
+#include <stdint.h>
+
+/* The most fields of a sample that can be compressed */
+
+#define DEADBAND_MAX_AXES 3
+
+/* The largest sample that can be compressed, in bytes */
+
+#define DEADBAND_MAX_SAMPLE 64
+
+/* Types of the compressed fields */
+
+enum deadband_field_e {
+    DEADBAND_FLOAT = 0, /* float */
+    DEADBAND_INT32 = 1, /* int32_t */
+};
+
+/* Where the compressed fields of a channel's samples are, and how far the ground's reconstruction of each may be off */
+struct deadband_desc {
+    uint16_t size;                            /* Size of a sample, which starts with a uint64_t timestamp in us */
+    uint8_t n_axes;                           /* The number of compressed fields */
+    uint8_t type;                             /* The type of every compressed field, from deadband_field_e */
+    uint16_t axis_offsets[DEADBAND_MAX_AXES]; /* Offset of each compressed field in a sample */
+    float band[DEADBAND_MAX_AXES];            /* Largest error allowed in each field, in the field's units */
+};
+
+/* Drops samples of a slowly changing channel that lie within an error band of the straight line between the samples
+ * that are kept. The ground reconstructs dropped samples by interpolating between the kept ones they fall between.
+ *
+ * The last sample that could still end the current line is held back until a later sample can't, so a kept sample
+ * reaches the ground one sample late. A sample is always kept once the last kept one is a heartbeat old, so the ground
+ * can tell a steady channel from a dead one.
+ */
+struct deadband {
+    const struct deadband_desc *desc;
+    uint64_t heartbeat_us;              /* Longest time between kept samples while samples keep arriving */
+    uint64_t start_us;                  /* Timestamp of the last kept sample, where the current line starts */
+    double start[DEADBAND_MAX_AXES];    /* Fields of the last kept sample */
+    double slope_lo[DEADBAND_MAX_AXES]; /* Lowest slope of a line from the start within band of every dropped sample */
+    double slope_hi[DEADBAND_MAX_AXES]; /* Highest slope of a line from the start within band of every dropped sample */
+    uint8_t started;                    /* If a sample has been kept */
+    uint8_t holding;                    /* If a sample is held back */
+    uint64_t held[DEADBAND_MAX_SAMPLE / sizeof(uint64_t)]; /* The sample held back, in words so it stays aligned */
+    uint32_t kept;                      /* Samples kept since initialization */
+    uint32_t dropped;                   /* Samples dropped since initialization */
+};
+
+int deadband_init(struct deadband *db, const struct deadband_desc *desc, uint32_t heartbeat_ms);
+int deadband_filter(struct deadband *db, void *samples, int n);
+
+#endif // _INSPACE_DEADBAND_H_
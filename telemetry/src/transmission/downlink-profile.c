@@ -0,0 +1,146 @@
+#include "downlink-profile.h"
+
+/* Outputs of each channel downlinked every transmit period in each part of the flight. Each profile fills most of a
+ * packet without envelopes, leaving room for a status and an error block. IMU channels use counts that divide each
+ * other so their resampling grids stay aligned, and are scaled up when they're delta encoded. */
+
+#ifdef CONFIG_INSPACE_TELEMETRY_DOWNLINK_PROFILES
+static const uint8_t downlink_profiles[ODR_NUM_PROFILES][RADIO_NUM_CHANNELS] = {
+    /* On the pad, position and a slow view of everything else */
+
+    [ODR_PROFILE_IDLE] =
+        {
+            [RADIO_GNSS] = 8,
+            [RADIO_ALT] = 4,
+            [RADIO_MAG] = 2,
+            [RADIO_ACCEL] = 4,
+            [RADIO_GYRO] = 2,
+            [RADIO_BARO] = 2,
+        },
+
+    /* Powered flight and coast, where the motion happens */
+
+    [ODR_PROFILE_ASCENT] =
+        {
+            [RADIO_GNSS] = 1,
+            [RADIO_ALT] = 10,
+            [RADIO_MAG] = 1,
+            [RADIO_ACCEL] = 10,
+            [RADIO_GYRO] = 5,
+            [RADIO_BARO] = 1,
+        },
+
+    /* Under parachute, the descent rate and where it's drifting */
+
+    [ODR_PROFILE_DESCENT] =
+        {
+            [RADIO_GNSS] = 6,
+            [RADIO_ALT] = 10,
+            [RADIO_MAG] = 2,
+            [RADIO_ACCEL] = 2,
+            [RADIO_GYRO] = 2,
+            [RADIO_BARO] = 2,
+        },
+
+    /* On the ground, where to find it */
+
+    [ODR_PROFILE_LANDED] =
+        {
+            [RADIO_GNSS] = 10,
+            [RADIO_ALT] = 2,
+            [RADIO_MAG] = 1,
+            [RADIO_ACCEL] = 2,
+            [RADIO_GYRO] = 1,
+            [RADIO_BARO] = 2,
+        },
+};
+#endif
+
+#ifdef CONFIG_INSPACE_TELEMETRY_DELTA_BLOCKS
+/* Delta blocks fit more than twice as many slowly changing samples, so the IMU channels get twice the outputs */
+
+#define DELTA_IMU_SCALE 2
+
+/* The expected size of a delta encoded sample after a block's first, with each axis changing by less than 64 units */
+
+#define DELTA_SAMPLE_BYTES 3
+
+#define delta_channel(channel) ((channel) == RADIO_ACCEL || (channel) == RADIO_GYRO)
+#endif
+
+/* Packet bytes taken by each sample of a channel, not counting block headers */
+
+static const uint8_t downlink_sample_bytes[RADIO_NUM_CHANNELS] = {
+    [RADIO_GNSS] = sizeof(struct coord_blk_t),
+    [RADIO_ALT] = sizeof(struct alt_blk_t),
+    [RADIO_MAG] = sizeof(struct mag_blk_t),
+#ifdef CONFIG_INSPACE_DOWNSAMPLING_ENVELOPE
+    [RADIO_ACCEL] = sizeof(struct accel_blk_t) + sizeof(struct accel_env_blk_t),
+    [RADIO_GYRO] = sizeof(struct ang_vel_blk_t) + sizeof(struct ang_vel_env_blk_t),
+#else
+    [RADIO_ACCEL] = sizeof(struct accel_blk_t),
+    [RADIO_GYRO] = sizeof(struct ang_vel_blk_t),
+#endif
+    [RADIO_BARO] = sizeof(struct pres_blk_t) + sizeof(struct temp_blk_t),
+};
+
+/* The number of blocks each channel's samples are split across */
+
+static const uint8_t downlink_blocks[RADIO_NUM_CHANNELS] = {
+    [RADIO_GNSS] = 1,
+    [RADIO_ALT] = 1,
+    [RADIO_MAG] = 1,
+#ifdef CONFIG_INSPACE_DOWNSAMPLING_ENVELOPE
+    [RADIO_ACCEL] = 2,
+    [RADIO_GYRO] = 2,
+#else
+    [RADIO_ACCEL] = 1,
+    [RADIO_GYRO] = 1,
+#endif
+    [RADIO_BARO] = 2,
+};
+
+/**
+ * Get the number of outputs of a channel downlinked every transmit period in a part of the flight
+ *
+ * @param channel The channel
+ * @param profile The profile of the part of the flight
+ * @return The number of outputs, at most the downsampling target
+ */
+uint8_t downlink_outputs(enum radio_channel_e channel, enum odr_profile_e profile) {
+#ifdef CONFIG_INSPACE_TELEMETRY_DOWNLINK_PROFILES
+    uint16_t outputs = downlink_profiles[profile][channel];
+#ifdef CONFIG_INSPACE_TELEMETRY_DELTA_BLOCKS
+    if (delta_channel(channel)) {
+        outputs *= DELTA_IMU_SCALE;
+    }
+#endif
+    return outputs < CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ ? outputs : CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ;
+#else
+    return CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ;
+#endif
+}
+
+/**
+ * Get the size of the data blocks of a packet holding a transmit period of outputs in a part of the flight
+ *
+ * @param profile The profile of the part of the flight
+ * @return The size in bytes, including block headers
+ */
+size_t downlink_bytes(enum odr_profile_e profile) {
+    size_t bytes = 0;
+    for (int ch = 0; ch < RADIO_NUM_CHANNELS; ch++) {
+        uint8_t outputs = downlink_outputs(ch, profile);
+        if (outputs == 0) {
+            continue;
+        }
+#ifdef CONFIG_INSPACE_TELEMETRY_DELTA_BLOCKS
+        if (delta_channel(ch)) {
+            bytes += sizeof(blk_hdr_t) + sizeof(struct delta_blk_t) + (outputs - 1) * DELTA_SAMPLE_BYTES;
+            continue;
+        }
+#endif
+        bytes += outputs * downlink_sample_bytes[ch] + downlink_blocks[ch] * sizeof(blk_hdr_t);
+    }
+    return bytes;
+}
@@ -0,0 +1,13 @@
+#ifndef _INSPACE_DOWNLINK_PROFILE_H_
+#define _INSPACE_DOWNLINK_PROFILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../collection/odr-schedule.h"
+#include "../radio-telem.h"
+
+uint8_t downlink_outputs(enum radio_channel_e channel, enum odr_profile_e profile);
+size_t downlink_bytes(enum odr_profile_e profile);
+
+#endif // _INSPACE_DOWNLINK_PROFILE_H_
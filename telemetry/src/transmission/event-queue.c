@@ -0,0 +1,170 @@
+#include <string.h>
+
+#include "../syslogging.h"
+#include "event-queue.h"
+
+/* Whether a status is worth repeating, so it survives a lost packet
+ *
+ * @param code The status code
+ * @return True for flight state changes, false for periodic updates
+ */
+static bool status_critical(enum status_code_e code) {
+    return code >= STATUS_TELEMETRY_CHANGED_IDLE && code <= STATUS_TELEMETRY_CHANGED_LANDED;
+}
+
+/* Whether an event is worth repeating, so it survives a lost packet
+ *
+ * @param ev The event
+ * @return True for errors and flight state changes
+ */
+static bool event_critical(const struct downlink_event *ev) {
+    return ev->type == DATA_ERROR || status_critical(ev->status.status_code);
+}
+
+/* Get the timestamp of an event
+ *
+ * @param ev The event
+ * @return The time the event was published in microseconds
+ */
+static uint64_t event_timestamp(const struct downlink_event *ev) {
+    return ev->type == DATA_STATUS ? ev->status.timestamp : ev->error.timestamp;
+}
+
+/* Remove an event from the queue, keeping the rest in order
+ *
+ * @param q The queue
+ * @param i The index of the event to remove
+ */
+static void event_remove(struct event_queue *q, unsigned i) {
+    memmove(&q->events[i], &q->events[i + 1], (q->len - i - 1) * sizeof(q->events[0]));
+    q->len--;
+}
+
+/* Make room for a new event at the back of the queue. When it's full, the oldest event already sent once goes first,
+ * then the oldest one that isn't critical, then the oldest.
+ *
+ * @param q The queue
+ * @param critical If the new event is critical
+ * @return Where to write the new event
+ */
+static struct downlink_event *event_slot(struct event_queue *q, bool critical) {
+    if (q->len == EVENT_QUEUE_LEN) {
+        unsigned victim = 0;
+        unsigned i;
+
+        for (i = 0; i < q->len && !q->events[i].sent; i++)
+            ;
+        if (i == q->len) {
+            for (i = 0; i < q->len && event_critical(&q->events[i]); i++)
+                ;
+        }
+        if (i < q->len) {
+            victim = i;
+        }
+
+        inwarn("Event queue full, dropping a %s event\n", q->events[victim].type == DATA_STATUS ? "status" : "error");
+        q->drops->size[q->events[victim].type]++;
+        event_remove(q, victim);
+    }
+
+    struct downlink_event *ev = &q->events[q->len++];
+    ev->repeats = critical ? EVENT_CRITICAL_REPEATS : 1;
+    ev->sent = false;
+    return ev;
+}
+
+/**
+ * Start an empty event queue
+ *
+ * @param q The queue to initialize
+ * @param drops Where to count the events that are dropped
+ */
+void event_queue_init(struct event_queue *q, struct block_drops *drops) {
+    q->len = 0;
+    q->drops = drops;
+}
+
+/**
+ * Queue a status message to be sent
+ *
+ * @param q The queue
+ * @param status The status message
+ */
+void event_queue_push_status(struct event_queue *q, const struct status_message *status) {
+    struct downlink_event *slot = event_slot(q, status_critical(status->status_code));
+    slot->type = DATA_STATUS;
+    slot->status = *status;
+}
+
+/**
+ * Queue an error message to be sent
+ *
+ * @param q The queue
+ * @param error The error message
+ */
+void event_queue_push_error(struct event_queue *q, const struct error_message *error) {
+    struct downlink_event *slot = event_slot(q, true);
+    slot->type = DATA_ERROR;
+    slot->error = *error;
+}
+
+/**
+ * Pack the queued events into a packet, errors first, so events of one type share a block. Events are removed once
+ * they've been sent in as many packets as they need, or if they're too old to be offset from the packet's timestamp.
+ * Events that don't fit stay queued for the next packet.
+ *
+ * @param q The queue
+ * @param pk The packer of the packet to add the events to
+ * @return The number of events packed
+ */
+int event_queue_pack(struct event_queue *q, struct packer *pk) {
+    static const uint8_t order[] = {DATA_ERROR, DATA_STATUS};
+    int packed = 0;
+
+    for (unsigned t = 0; t < sizeof(order) / sizeof(order[0]); t++) {
+        for (unsigned i = 0; i < q->len; i++) {
+            struct downlink_event *ev = &q->events[i];
+            void *blk;
+            int err;
+
+            if (ev->type != order[t]) {
+                continue;
+            }
+
+            blk = packer_add(pk, ev->type, event_timestamp(ev) / 1000);
+
+            if (blk == NULL) {
+                if (packer_space(pk) < sizeof(blk_hdr_t) + blk_body_len(ev->type)) {
+                    continue; /* No room, try again in the next packet */
+                }
+                err = 1; /* Room for the block, but its time can't be offset from the packet's */
+            } else if (ev->type == DATA_STATUS) {
+                err = orb_status_pkt(&ev->status, blk, packer_base_time(pk));
+            } else {
+                err = orb_error_pkt(&ev->error, blk, packer_base_time(pk));
+            }
+
+            if (err) {
+                inwarn("Dropping a %s event too old to send\n", ev->type == DATA_STATUS ? "status" : "error");
+                if (blk != NULL) {
+                    packer_undo(pk);
+                }
+                q->drops->time[ev->type]++;
+                ev->repeats = 0;
+                continue;
+            }
+
+            ev->sent = true;
+            ev->repeats--;
+            packed++;
+        }
+    }
+
+    for (unsigned i = q->len; i > 0; i--) {
+        if (q->events[i - 1].repeats == 0) {
+            event_remove(q, i - 1);
+        }
+    }
+
+    return packed;
+}
@@ -0,0 +1,45 @@
+#ifndef _INSPACE_EVENT_QUEUE_H_
+#define _INSPACE_EVENT_QUEUE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../collection/status-update.h"
+#include "../packets/packer.h"
+#include "transmit-stats.h"
+
+/* The most status and error events waiting to be sent */
+
+#define EVENT_QUEUE_LEN CONFIG_INSPACE_TELEMETRY_EVENT_QUEUE_LEN
+
+/* The number of consecutive packets a critical event is sent in */
+
+#define EVENT_CRITICAL_REPEATS CONFIG_INSPACE_TELEMETRY_EVENT_REPEATS
+
+/* A status or error message waiting to be sent */
+
+struct downlink_event {
+    uint8_t type;    /* DATA_STATUS or DATA_ERROR */
+    uint8_t repeats; /* The number of packets the event still has to be sent in */
+    bool sent;       /* If the event has been sent in at least one packet */
+    union {
+        struct status_message status;
+        struct error_message error;
+    };
+};
+
+/* Every status and error event published since the last packet, oldest first. Events stay queued until they've been
+ * sent in as many packets as they need, so none are lost when several are published in one transmit period.
+ */
+struct event_queue {
+    struct downlink_event events[EVENT_QUEUE_LEN];
+    unsigned len;              /* The number of queued events */
+    struct block_drops *drops; /* Where to count events dropped because the queue was full or they were too old */
+};
+
+void event_queue_init(struct event_queue *q, struct block_drops *drops);
+void event_queue_push_status(struct event_queue *q, const struct status_message *status);
+void event_queue_push_error(struct event_queue *q, const struct error_message *error);
+int event_queue_pack(struct event_queue *q, struct packer *pk);
+
+#endif // _INSPACE_EVENT_QUEUE_H_
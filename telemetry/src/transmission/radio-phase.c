@@ -0,0 +1,130 @@
+#include "radio-phase.h"
+
+#ifdef CONFIG_INSPACE_TELEMETRY_RADIO_PHASES
+/* The number of packets announcing a switch before the first one sent on the new settings */
+
+#define RADIO_SWITCH_NOTICE CONFIG_INSPACE_TELEMETRY_RADIO_SWITCH_NOTICE
+
+/* The LoRa settings of each part of the flight that differ from the configured ones */
+
+struct radio_phase_settings {
+    uint8_t spread; /* Spread factor */
+    uint32_t bw;    /* Bandwidth, kHz */
+};
+
+/* Low spread factors and wide bandwidth for the high rate parts of the flight, close to the ground station. High
+ * spread factors from apogee on, when the rocket is furthest away and lands out of sight. */
+
+static const struct radio_phase_settings radio_phases[ODR_NUM_PROFILES] = {
+    [ODR_PROFILE_IDLE] = {CONFIG_INSPACE_TELEMETRY_RADIO_RATE_SPREAD, CONFIG_INSPACE_TELEMETRY_RADIO_RATE_BW},
+    [ODR_PROFILE_ASCENT] = {CONFIG_INSPACE_TELEMETRY_RADIO_RATE_SPREAD, CONFIG_INSPACE_TELEMETRY_RADIO_RATE_BW},
+    [ODR_PROFILE_DESCENT] = {CONFIG_INSPACE_TELEMETRY_RADIO_RANGE_SPREAD, CONFIG_INSPACE_TELEMETRY_RADIO_RANGE_BW},
+    [ODR_PROFILE_LANDED] = {CONFIG_INSPACE_TELEMETRY_RADIO_RANGE_SPREAD, CONFIG_INSPACE_TELEMETRY_RADIO_RANGE_BW},
+};
+#else
+#define RADIO_SWITCH_NOTICE 1
+#endif
+
+/**
+ * Get the radio settings of a part of the flight
+ *
+ * @param base The configured radio settings
+ * @param profile The profile of the part of the flight
+ * @param out Where to store the settings, which are the configured ones with the profile's spread factor and
+ * bandwidth, or just the configured ones if the settings don't follow the flight
+ */
+void radio_phase_options(struct radio_options const *base, enum odr_profile_e profile, struct radio_options *out) {
+    *out = *base;
+#ifdef CONFIG_INSPACE_TELEMETRY_RADIO_PHASES
+    out->spread = radio_phases[profile].spread;
+    out->bw = radio_phases[profile].bw;
+#endif
+}
+
+/**
+ * Initialize the radio phases with no switch pending
+ *
+ * @param rp The radio phases
+ * @param base The radio settings the radio was configured with
+ */
+void radio_phase_init(struct radio_phase *rp, struct radio_options const *base) {
+    rp->config = *base;
+    rp->next = *base;
+    rp->first_packet = 0;
+    rp->announcing = false;
+    rp->reached = false;
+    atomic_init(&rp->pending, false);
+}
+
+/**
+ * Plan a switch to the settings of a part of the flight, if they differ from the current ones and no other switch is
+ * under way. The switch is announced in the next RADIO_SWITCH_NOTICE packets.
+ *
+ * @param rp The radio phases
+ * @param profile The profile of the current part of the flight
+ * @param packet_num The number of the next packet to be built
+ * @return True if a switch was planned
+ */
+bool radio_phase_plan(struct radio_phase *rp, enum odr_profile_e profile, uint8_t packet_num) {
+    struct radio_options target;
+
+    if (rp->announcing || atomic_load(&rp->pending)) {
+        return false;
+    }
+
+    radio_phase_options(&rp->config, profile, &target);
+    if (target.spread == rp->config.spread && target.bw == rp->config.bw) {
+        return false;
+    }
+
+    rp->next = target;
+    rp->first_packet = packet_num + RADIO_SWITCH_NOTICE;
+    rp->announcing = true;
+    atomic_store(&rp->pending, true);
+    return true;
+}
+
+/**
+ * Move on to the next packet to be built, which goes out on the next settings if it's the first packet of a switch
+ *
+ * @param rp The radio phases
+ * @param packet_num The number of the next packet to be built
+ * @return True if the packets built from now on go out on the next settings
+ */
+bool radio_phase_advance(struct radio_phase *rp, uint8_t packet_num) {
+    if (!rp->announcing || packet_num != rp->first_packet) {
+        return false;
+    }
+    rp->config = rp->next;
+    rp->announcing = false;
+    return true;
+}
+
+/**
+ * Check if the radio has to switch before sending a packet. It switches before the first packet numbered at or after
+ * the announced one, since packets can be overwritten before they're sent. Until the switch is marked done, every
+ * packet after that is due too, so a failed switch is retried however long it takes.
+ *
+ * @param rp The radio phases
+ * @param packet_num The number of the packet about to be sent
+ * @return True if the radio has to switch to the next settings first
+ */
+bool radio_phase_due(struct radio_phase *rp, uint8_t packet_num) {
+    if (!atomic_load(&rp->pending)) {
+        return false;
+    }
+    if (!rp->reached) {
+        rp->reached = (int8_t)(packet_num - rp->first_packet) >= 0;
+    }
+    return rp->reached;
+}
+
+/**
+ * Mark the pending switch as carried out, so the next can be planned
+ *
+ * @param rp The radio phases
+ */
+void radio_phase_done(struct radio_phase *rp) {
+    rp->reached = false;
+    atomic_store(&rp->pending, false);
+}
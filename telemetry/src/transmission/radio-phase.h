@@ -0,0 +1,31 @@
+#ifndef _INSPACE_RADIO_PHASE_H_
+#define _INSPACE_RADIO_PHASE_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../collection/odr-schedule.h"
+#include "../rocket-state/rocket-state.h"
+
+/* Switches the radio between settings for throughput and for range as the flight goes on. Each switch is announced
+ * in the packets before it, which name the first packet sent on the new settings, so the ground can follow without
+ * a handshake. The transmit thread plans switches and numbers packets, the radio stage carries them out. */
+
+struct radio_phase {
+    struct radio_options config; /* The settings the packets being built go out on, owned by the transmit thread */
+    struct radio_options next;   /* The settings being switched to, fixed while a switch is pending */
+    uint8_t first_packet;        /* The number of the first packet sent on the next settings */
+    bool announcing;             /* If packets before the switch are still being built */
+    atomic_bool pending;         /* If the radio stage has yet to switch */
+    bool reached;                /* If the radio stage has reached the first packet of the switch, owned by it */
+};
+
+void radio_phase_options(struct radio_options const *base, enum odr_profile_e profile, struct radio_options *out);
+void radio_phase_init(struct radio_phase *rp, struct radio_options const *base);
+bool radio_phase_plan(struct radio_phase *rp, enum odr_profile_e profile, uint8_t packet_num);
+bool radio_phase_advance(struct radio_phase *rp, uint8_t packet_num);
+bool radio_phase_due(struct radio_phase *rp, uint8_t packet_num);
+void radio_phase_done(struct radio_phase *rp);
+
+#endif // _INSPACE_RADIO_PHASE_H_
@@ -0,0 +1,129 @@
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../packets/packets.h"
+#include "../syslogging.h"
+#include "airtime.h"
+#include "sim-radio.h"
+
+/* Get the next number from a xorshift generator, which is fast and repeatable from a seed
+ *
+ * @param state The generator's state, never 0
+ * @return A pseudo-random number
+ */
+static uint32_t sim_random(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/* Flip bits of a frame at random
+ *
+ * @param sim The simulated radio
+ * @param frame The frame
+ * @param len The length of the frame
+ * @return The number of bits flipped
+ */
+static int sim_flip_bits(struct sim_radio *sim, uint8_t *frame, size_t len) {
+    int flipped = 0;
+
+    if (sim->ber_ppm == 0) {
+        return 0;
+    }
+    for (size_t bit = 0; bit < 8 * len; bit++) {
+        if (sim_random(&sim->rng) % 1000000 < sim->ber_ppm) {
+            frame[bit / 8] ^= 1 << (bit % 8);
+            flipped++;
+        }
+    }
+    return flipped;
+}
+
+/**
+ * Set up a simulated radio, discarding frames a previous run stored
+ *
+ * @param sim The simulated radio to initialize
+ * @param config The radio's configuration, which must outlive the simulated radio
+ * @param fd The file to append received frames to
+ * @param loss_permille The chance of losing a frame, in thousandths
+ * @param ber_ppm The chance of flipping each bit of a frame, in millionths
+ * @param seed The seed of the random losses and bit errors
+ * @return 0 on success, or a negative error code if the configuration can't be sent with or the file can't be cleared
+ */
+int sim_radio_init(struct sim_radio *sim, struct radio_options const *config, int fd, uint16_t loss_permille,
+                   uint32_t ber_ppm, uint32_t seed) {
+    uint32_t airtime_us;
+
+    if (lora_airtime_us(config, 1, &airtime_us) < 0) {
+        inerr("Simulated radio can't send with SF%u at %lu kHz\n", config->spread, (unsigned long)config->bw);
+        return -EINVAL;
+    }
+    if (ftruncate(fd, 0) < 0) {
+        return -errno;
+    }
+
+    sim->config = config;
+    sim->fd = fd;
+    sim->loss_permille = loss_permille;
+    sim->ber_ppm = ber_ppm;
+    sim->rng = seed != 0 ? seed : 1;
+    sim->sent = 0;
+    sim->lost = 0;
+    sim->corrupted = 0;
+    return 0;
+}
+
+/**
+ * Send a frame over the simulated radio, blocking for as long as it's on air
+ *
+ * @param sim The simulated radio
+ * @param frame The frame to send
+ * @param len The length of the frame, at most PACKET_MAX_SIZE
+ * @return The number of bytes sent, whether or not they arrived, or a negative error code
+ */
+ssize_t sim_radio_write(struct sim_radio *sim, const uint8_t *frame, size_t len) {
+    uint8_t received[1 + PACKET_MAX_SIZE];
+    uint32_t airtime_us;
+    int err;
+
+    if (len == 0 || len > PACKET_MAX_SIZE) {
+        return -EINVAL;
+    }
+
+    err = lora_airtime_us(sim->config, len, &airtime_us);
+    if (err < 0) {
+        return err;
+    }
+    struct timespec airtime = {.tv_sec = airtime_us / 1000000, .tv_nsec = (airtime_us % 1000000) * 1000};
+    nanosleep(&airtime, NULL);
+    sim->sent++;
+
+    if (sim_random(&sim->rng) % 1000 < sim->loss_permille) {
+        indebug("Simulated radio lost a frame of %zu bytes\n", len);
+        sim->lost++;
+        return len;
+    }
+
+    received[0] = len;
+    memcpy(&received[1], frame, len);
+    if (sim_flip_bits(sim, &received[1], len) > 0) {
+        if (sim->config->crc) {
+            indebug("Simulated radio dropped a frame of %zu bytes that failed its CRC\n", len);
+            sim->lost++;
+            return len;
+        }
+        sim->corrupted++;
+    }
+
+    if (write(sim->fd, received, 1 + len) < 0) {
+        err = errno;
+        inerr("Couldn't store a received frame: %d\n", err);
+        return -err;
+    }
+    return len;
+}
@@ -0,0 +1,29 @@
+#ifndef _INSPACE_SIM_RADIO_H_
+#define _INSPACE_SIM_RADIO_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "../rocket-state/rocket-state.h"
+
+/* Stands in for the RN2483 on the simulator. A write blocks for the frame's LoRa time on air, then the frame is lost or
+ * has bits flipped at random, the way it would be on its way to the ground station. Frames that arrive are appended to
+ * a file, each after a byte holding its length.
+ */
+struct sim_radio {
+    struct radio_options const *config; /* The radio's configuration, for each frame's time on air */
+    int fd;                             /* The file received frames are appended to */
+    uint16_t loss_permille;             /* The chance of losing a frame outright, in thousandths */
+    uint32_t ber_ppm;                   /* The chance of flipping each bit of a frame, in millionths */
+    uint32_t rng;                       /* State of the random number generator */
+    uint32_t sent;                      /* Frames written */
+    uint32_t lost;                      /* Frames lost on air, or dropped by the ground's CRC check */
+    uint32_t corrupted;                 /* Frames received with bit errors, when the CRC is off */
+};
+
+int sim_radio_init(struct sim_radio *sim, struct radio_options const *config, int fd, uint16_t loss_permille,
+                   uint32_t ber_ppm, uint32_t seed);
+ssize_t sim_radio_write(struct sim_radio *sim, const uint8_t *frame, size_t len);
+
+#endif // _INSPACE_SIM_RADIO_H_
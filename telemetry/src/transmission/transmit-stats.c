@@ -0,0 +1,26 @@
+#include <uORB/uORB.h>
+
+#include "transmit-stats.h"
+
+/* uORB metadata definitions */
+#if defined(CONFIG_DEBUG_UORB)
+static const char transmit_stats_format[] = "transmit stats - timestamp:%" PRIu64;
+ORB_DEFINE(transmit_stats, struct transmit_stats, transmit_stats_format);
+#else
+ORB_DEFINE(transmit_stats, struct transmit_stats, 0);
+#endif
+
+/**
+ * Get the latency histogram bucket a time falls in
+ *
+ * @param ms The time in milliseconds
+ * @return The index of the bucket, 0 for under 1 ms up to TRANSMIT_HIST_BUCKETS - 1 for the longest times
+ */
+int transmit_hist_bucket(uint32_t ms) {
+    int bucket = 0;
+    while (ms > 0 && bucket < TRANSMIT_HIST_BUCKETS - 1) {
+        ms >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
@@ -0,0 +1,49 @@
+#ifndef _INSPACE_TRANSMIT_STATS_H_
+#define _INSPACE_TRANSMIT_STATS_H_
+
+#include <stdint.h>
+#include <uORB/uORB.h>
+
+#include "../packets/packets.h"
+
+/* The number of buckets in a latency histogram. Bucket 0 counts times under 1 ms, bucket i counts times from 2^(i-1) up
+ * to 2^i ms, and the last bucket counts everything longer. */
+
+#define TRANSMIT_HIST_BUCKETS 15
+
+/* How often the transmit thread publishes its stats in milliseconds */
+
+#define TRANSMIT_STATS_PERIOD_MS 1000
+
+/* Blocks the transmit thread couldn't send, by block type */
+
+struct block_drops {
+    uint32_t time[DATA_RES_ABOVE]; /* Dropped because their time couldn't be offset from their packet's timestamp */
+    uint32_t size[DATA_RES_ABOVE]; /* Dropped because there was no room left for them */
+};
+
+/* Measurements of the transmit thread since it started, unless noted otherwise */
+
+struct transmit_stats {
+    uint64_t timestamp;
+    uint32_t cycle_hist[TRANSMIT_HIST_BUCKETS]; /* How long building each packet took */
+    uint32_t write_hist[TRANSMIT_HIST_BUCKETS]; /* How long sending each packet took, including time on air */
+    uint32_t bytes_per_s;                       /* Packet bytes sent per second over the last stats period */
+    uint32_t samples_per_s;                     /* Samples packed per second over the last stats period */
+    uint32_t packets_sent;                      /* Packets sent, including parity packets */
+    uint32_t bytes_sent;                        /* Packet bytes sent */
+    uint32_t samples_packed;                    /* Sensor samples written into packets, not counting drops */
+    uint32_t empty_swaps;                       /* Cycles where the downsampler had no new samples */
+    uint32_t queue_depth;                       /* Built packets waiting to be sent, when the stats were published */
+    uint32_t overwrites;                        /* Built packets replaced by newer ones before they were sent */
+    uint32_t radio_switches;                    /* Times the radio switched settings for a part of the flight */
+    uint32_t switch_us;                         /* How long the last radio switch took, in microseconds */
+    uint32_t switch_fails;                      /* Times switching the radio's settings failed and was retried */
+    struct block_drops drops;
+};
+
+ORB_DECLARE(transmit_stats);
+
+int transmit_hist_bucket(uint32_t ms);
+
+#endif // _INSPACE_TRANSMIT_STATS_H_
@@ -4,6 +4,8 @@
 #include <poll.h>
 #include <pthread.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+#include <stddef.h>
 #include <string.h>
 #include <sys/ioctl.h>
 #include <time.h>
@@ -15,8 +17,18 @@
 #endif
 
 #include "../collection/status-update.h"
+#include "../packets/buffering.h"
+#include "../packets/fec.h"
+#include "../packets/packer.h"
 #include "../packets/packets.h"
 #include "../syslogging.h"
+#include "airtime.h"
+#include "deadband.h"
+#include "downlink-profile.h"
+#include "event-queue.h"
+#include "radio-phase.h"
+#include "sim-radio.h"
+#include "transmit-stats.h"
 #include "transmit.h"
 
 /* If there was an error in configuration, display which line and return the
@@ -29,18 +41,216 @@
         return err;                                                                                                    \
     }
 
+/* The most block types a channel's samples are sent in */
+
+#define DOWNLINK_MAX_TYPES 2
+
+#ifdef CONFIG_INSPACE_TELEMETRY_FEC
+/* The number of data packets each parity packet covers */
+
+#define FEC_GROUP CONFIG_INSPACE_TELEMETRY_FEC_GROUP
+
+/* The packets a burst leaves free: the one the radio stage is sending, and one for a parity packet */
+
+#define BURST_SPARE 2
+#else
+/* The packets a burst leaves free: the one the radio stage is sending */
+
+#define BURST_SPARE 1
+#endif
+
 /* Cast an error to a void pointer */
 
 #define err_to_ptr(err) ((void *)((err)))
-#define TRANSMIT_PERIOD_MS 700
 
 enum status_topics_e {
     STATUS_TOPIC = 0,
     ERROR_TOPIC = 1,
 };
 
+#ifdef CONFIG_INSPACE_TELEMETRY_DEADBAND
+/* Compressed fields of the slowly changing channels, with their error bands */
+
+static const struct deadband_desc gnss_deadband_desc = {
+    .size = sizeof(struct coord_sample),
+    .n_axes = 2,
+    .type = DEADBAND_INT32,
+    .axis_offsets = {offsetof(struct coord_sample, latitude), offsetof(struct coord_sample, longitude)},
+    .band = {CONFIG_INSPACE_TELEMETRY_DEADBAND_GNSS, CONFIG_INSPACE_TELEMETRY_DEADBAND_GNSS},
+};
+
+static const struct deadband_desc mag_deadband_desc = {
+    .size = sizeof(struct sensor_mag),
+    .n_axes = 3,
+    .type = DEADBAND_FLOAT,
+    .axis_offsets = {offsetof(struct sensor_mag, x), offsetof(struct sensor_mag, y), offsetof(struct sensor_mag, z)},
+    .band = {CONFIG_INSPACE_TELEMETRY_DEADBAND_MAG / 10.0f, CONFIG_INSPACE_TELEMETRY_DEADBAND_MAG / 10.0f,
+             CONFIG_INSPACE_TELEMETRY_DEADBAND_MAG / 10.0f},
+};
+
+static struct deadband gnss_deadband;
+static struct deadband mag_deadband;
+#endif
+
+/* Writes one of a channel's samples into a block body
+ *
+ * @param sample The sample
+ * @param env The sample's envelope, NULL if the channel doesn't track envelopes
+ * @param blk The block body to write
+ * @param base_time The timestamp of the packet header
+ * @return 0 on success, non-zero if the sample can't be sent in the packet
+ */
+typedef int (*downlink_encode_f)(void *sample, struct decimator_envelope *env, void *blk, uint16_t base_time);
+
+/* How a channel's samples are packed */
+
+struct downlink_channel {
+    enum radio_channel_e channel;                 /* The channel to pack */
+    uint8_t n_types;                              /* The number of block types each sample is sent in */
+    enum block_type_e types[DOWNLINK_MAX_TYPES];  /* The block types each sample is sent in */
+    downlink_encode_f encode[DOWNLINK_MAX_TYPES]; /* Writes a sample into a block of each type */
+    int budget;                                   /* The most bytes of a packet the channel can use */
+};
+
+static int encode_alt(void *sample, struct decimator_envelope *env, void *blk, uint16_t base_time) {
+    return orb_alt_pkt(sample, blk, base_time);
+}
+
+static int encode_coord(void *sample, struct decimator_envelope *env, void *blk, uint16_t base_time) {
+    return coord_pkt(sample, blk, base_time);
+}
+
+static int encode_accel(void *sample, struct decimator_envelope *env, void *blk, uint16_t base_time) {
+    return orb_accel_pkt(sample, blk, base_time);
+}
+
+static int encode_ang_vel(void *sample, struct decimator_envelope *env, void *blk, uint16_t base_time) {
+    return orb_ang_vel_pkt(sample, blk, base_time);
+}
+
+static int encode_mag(void *sample, struct decimator_envelope *env, void *blk, uint16_t base_time) {
+    return orb_mag_pkt(sample, blk, base_time);
+}
+
+static int encode_pres(void *sample, struct decimator_envelope *env, void *blk, uint16_t base_time) {
+    return orb_baro_pkt(sample, blk, base_time);
+}
+
+static int encode_temp(void *sample, struct decimator_envelope *env, void *blk, uint16_t base_time) {
+    return orb_baro_temp_pkt(sample, blk, base_time);
+}
+
+#if defined(CONFIG_INSPACE_TELEMETRY_DELTA_BLOCKS)
+/* The IMU channels go in delta blocks, whose samples are written like the fixed size blocks and then delta encoded */
+
+#define ACCEL_BLOCKS 1, {DATA_ACCEL_DELTA}, {encode_accel}
+#define GYRO_BLOCKS 1, {DATA_ANG_VEL_DELTA}, {encode_ang_vel}
+#elif defined(CONFIG_INSPACE_DOWNSAMPLING_ENVELOPE)
+static int encode_accel_env(void *sample, struct decimator_envelope *env, void *blk, uint16_t base_time) {
+    return orb_accel_env_pkt(env, blk, base_time);
+}
+
+static int encode_ang_vel_env(void *sample, struct decimator_envelope *env, void *blk, uint16_t base_time) {
+    return orb_ang_vel_env_pkt(env, blk, base_time);
+}
+
+#define ACCEL_BLOCKS 2, {DATA_ACCEL_REL, DATA_ACCEL_ENV}, {encode_accel, encode_accel_env}
+#define GYRO_BLOCKS 2, {DATA_ANGULAR_VEL, DATA_ANG_VEL_ENV}, {encode_ang_vel, encode_ang_vel_env}
+#else
+#define ACCEL_BLOCKS 1, {DATA_ACCEL_REL}, {encode_accel}
+#define GYRO_BLOCKS 1, {DATA_ANGULAR_VEL}, {encode_ang_vel}
+#endif
+
+/* Channels in the order they get room in a packet, after status and error blocks */
+
+static const struct downlink_channel downlink_channels[] = {
+    {RADIO_ALT, 1, {DATA_ALT_SEA}, {encode_alt}, PACKET_MAX_SIZE},
+    {RADIO_GNSS, 1, {DATA_LAT_LONG}, {encode_coord}, PACKET_MAX_SIZE},
+    {RADIO_ACCEL, ACCEL_BLOCKS, PACKET_MAX_SIZE},
+    {RADIO_GYRO, GYRO_BLOCKS, PACKET_MAX_SIZE},
+    {RADIO_MAG, 1, {DATA_MAGNETIC}, {encode_mag}, PACKET_MAX_SIZE},
+    {RADIO_BARO, 2, {DATA_PRESSURE, DATA_TEMP}, {encode_pres, encode_temp}, CONFIG_INSPACE_TELEMETRY_BARO_BUDGET},
+};
+
+#define NUM_DOWNLINK_CHANNELS (sizeof(downlink_channels) / sizeof(downlink_channels[0]))
+
+/* If a block type is delta encoded, taking a whole run of samples at once */
+
+#define delta_type(type) ((type) == DATA_ACCEL_DELTA || (type) == DATA_ANG_VEL_DELTA)
+
+/* If a block type is an envelope, stamped with its own time rather than its sample's */
+
+#define envelope_type(type) ((type) == DATA_ACCEL_ENV || (type) == DATA_ANG_VEL_ENV)
+
+/* Samples acquired from the downsampler that haven't been packed yet, oldest first */
+
+static radio_raw_data backlog;
+
+/* Packets built by the transmit thread, waiting for the radio stage to send them */
+
+static packet_buffer_t packets;
+
+/* Status and error events waiting to be sent */
+
+static struct event_queue events;
+
+/* The radio settings of each part of the flight, and the switch between them under way */
+
+static struct radio_phase phase;
+
+#ifdef CONFIG_INSPACE_TELEMETRY_SIM_RADIO
+/* Stands in for the radio, storing the packets that would reach the ground in the radio device file */
+
+static struct sim_radio sim;
+#endif
+
+#ifdef CONFIG_INSPACE_TELEMETRY_FEC
+/* Parity over the data packets sent so far in the current group */
+
+static struct fec_encoder fec;
+#endif
+
+/* The radio stage's share of the transmit thread's arguments */
+
+struct radio_stage_args {
+    int radio;                          /* The radio device */
+    struct radio_options const *config; /* The radio's configuration when the stage starts */
+};
+
+/* Measurements of the radio stage, which the transmit thread publishes along with its own */
+
+static atomic_uint write_hist[TRANSMIT_HIST_BUCKETS]; /* How long sending each packet took */
+static atomic_uint packets_sent;                      /* The number of packets the radio stage has sent */
+static atomic_uint bytes_sent;                        /* The number of packet bytes the radio stage has sent */
+static atomic_uint radio_switches;                    /* The number of times the radio stage switched settings */
+static atomic_uint switch_us;                         /* How long the last switch took in microseconds */
+static atomic_uint switch_fails;                      /* The number of times switching the radio's settings failed */
+
+/* Measurements of the transmit thread, published every TRANSMIT_STATS_PERIOD_MS */
+
+static struct transmit_stats stats;
+
 static int transmit(int radio, uint8_t *packet, size_t packet_size);
+static void *radio_stage_main(void *arg);
+static uint32_t elapsed_us_since(struct timespec const *start);
+static uint32_t elapsed_ms_since(struct timespec const *start);
+static void sleep_remaining(struct timespec const *start, uint32_t period_ms);
+static void publish_stats(int *fd, uint32_t elapsed_ms);
+static size_t build_packet(uint8_t *packet, uint32_t seq_num, enum odr_profile_e profile);
+static bool backlog_waiting(void);
+static uint32_t packet_airtime_us(struct radio_options const *config, size_t packet_size);
+static int downlink_count(int available, enum radio_channel_e channel, enum odr_profile_e profile);
+static int downlink_cost(const struct downlink_channel *dc, int n);
+static int downlink_fit(struct packer *pk, const struct downlink_channel *dc, int n, int space, int *bytes);
+static int pack_channel(struct packer *pk, const struct downlink_channel *dc, int n);
+static int pack_delta(struct packer *pk, const struct downlink_channel *dc, int n, int space, bool write, int *bytes,
+                      int *packed);
 static int configure_radio(int fd, struct radio_options const *config);
+static int reconfigure_radio(int fd, struct radio_options const *config);
+static void switch_radio(int radio, struct radio_options *config);
+#ifdef CONFIG_INSPACE_TELEMETRY_FEC
+static size_t queue_parity(const uint8_t *packet, size_t len);
+#endif
 
 /* Main thread for data transmission over radio. */
 void *transmit_main(void *arg) {
@@ -49,6 +259,11 @@ void *transmit_main(void *arg) {
     struct transmit_args *unpacked_args = (struct transmit_args *)arg;
     radio_telem_t *radio_telem = unpacked_args->radio_telem;
     uint32_t seq_num = 0;
+    uint32_t period_ms = 0; /* The transmit period, sized to the airtime of a packet in the current profile */
+    pthread_t radio_thread;
+    struct radio_stage_args radio_args;
+    int stats_fd = -1;
+    struct timespec stats_start;
 
     ORB_DECLARE(status_message);
     ORB_DECLARE(error_message);
@@ -77,6 +292,36 @@ void *transmit_main(void *arg) {
         goto err_cleanup;
     }
 
+#ifdef CONFIG_INSPACE_TELEMETRY_DEADBAND
+    if (deadband_init(&gnss_deadband, &gnss_deadband_desc, CONFIG_INSPACE_TELEMETRY_DEADBAND_HEARTBEAT_MS) < 0 ||
+        deadband_init(&mag_deadband, &mag_deadband_desc, CONFIG_INSPACE_TELEMETRY_DEADBAND_HEARTBEAT_MS) < 0) {
+        err = EINVAL;
+        goto err_cleanup;
+    }
+#endif
+
+    /* Packets are sent by their own stage, so the time the radio takes doesn't hold up building the next one */
+
+    err = -packet_buffer_init(&packets);
+    if (err) {
+        inerr("Couldn't initialize the packet buffer: %d\n", err);
+        goto err_cleanup;
+    }
+
+    radio_phase_init(&phase, &unpacked_args->config);
+    radio_args.radio = radio;
+    radio_args.config = &unpacked_args->config;
+    err = pthread_create(&radio_thread, NULL, radio_stage_main, &radio_args);
+    if (err) {
+        inerr("Couldn't start the radio stage: %d\n", err);
+        goto err_cleanup;
+    }
+
+    event_queue_init(&events, &stats.drops);
+#ifdef CONFIG_INSPACE_TELEMETRY_FEC
+    fec_encoder_init(&fec, FEC_GROUP);
+#endif
+
     for (int i = 0; i < sizeof(status_fds) / sizeof(status_fds[0]); i++) {
         status_fds[i].fd = orb_subscribe(status_metas[i]);
         if (status_fds[i].fd < 0) {
@@ -87,207 +332,162 @@ void *transmit_main(void *arg) {
 
     /* Transmit forever, regardless of rocket flight state. */
 
+    clock_gettime(CLOCK_MONOTONIC, &stats_start);
     for (;;) {
         struct timespec cycle_start;
         clock_gettime(CLOCK_MONOTONIC, &cycle_start);
 
-        pthread_mutex_lock(&radio_telem->buff_mux);
-        radio_raw_data *temp = radio_telem->buff;
-        radio_telem->buff = radio_telem->empty_buff;
-        radio_telem->empty_buff = temp;
-        radio_telem->empty_buff->accel_n = 0;
-        radio_telem->empty_buff->gyro_n = 0;
-        radio_telem->empty_buff->mag_n = 0;
-        radio_telem->empty_buff->gnss_n = 0;
-        radio_telem->empty_buff->alt_n = 0;
-        pthread_mutex_unlock(&radio_telem->buff_mux);
-        sem_post(&radio_telem->swapped);
-
-        /* create a new packet buffer */
-        uint8_t packet_buffer[PACKET_MAX_SIZE];
-        uint8_t *packet_ptr = packet_buffer;
-
-        /* use mission time as current time for now, this does not account for reboots */
-        struct timespec current_time;
-        clock_gettime(CLOCK_REALTIME, &current_time);
-        uint32_t mission_time_ms = current_time.tv_sec * 1000 + current_time.tv_nsec / 1000000;
-        pkt_hdr_t *header = (pkt_hdr_t *)packet_ptr;
-        packet_ptr = pkt_init(packet_ptr, seq_num++, mission_time_ms);
+        /* Take everything downsampled since the last cycle, after anything that didn't fit in the last packet */
+
+        radio_raw_data *buff = radio_telem_acquire(radio_telem);
+        enum flight_state_e flight_state;
+        enum flight_substate_e flight_substate;
+
+#ifdef CONFIG_INSPACE_TELEMETRY_DEADBAND
+        /* Leave out the slow channels' samples the ground can interpolate, making room for the others */
+
+        buff->gnss_n = deadband_filter(&gnss_deadband, buff->gnss, buff->gnss_n);
+        buff->mag_n = deadband_filter(&mag_deadband, buff->mag, buff->mag_n);
+        indebug("Deadband kept %lu of %lu GNSS and %lu of %lu mag samples\n", (unsigned long)gnss_deadband.kept,
+                (unsigned long)(gnss_deadband.kept + gnss_deadband.dropped), (unsigned long)mag_deadband.kept,
+                (unsigned long)(mag_deadband.kept + mag_deadband.dropped));
+#endif
+
+        int incoming[RADIO_NUM_CHANNELS];
+        int new_samples = 0;
+        for (int ch = 0; ch < RADIO_NUM_CHANNELS; ch++) {
+            new_samples += radio_data_count(buff, ch);
+            incoming[ch] = radio_data_count(&backlog, ch) + radio_data_count(buff, ch);
+        }
+        if (new_samples == 0) {
+            stats.empty_swaps++;
+        }
+
+        int dropped = radio_data_merge(&backlog, buff);
+        if (dropped > 0) {
+            inwarn("Dropped %d samples that waited too long to be sent\n", dropped);
+            for (int i = 0; i < NUM_DOWNLINK_CHANNELS; i++) {
+                const struct downlink_channel *dc = &downlink_channels[i];
+                stats.drops.size[dc->types[0]] += incoming[dc->channel] - radio_data_count(&backlog, dc->channel);
+            }
+        }
+
+        /* Every event published since the last cycle is queued, and critical ones stay queued for a few packets in case
+         * one is lost */
 
         err = poll(status_fds, sizeof(status_fds) / sizeof(status_fds[0]), 0);
         if (err < 0) {
             inwarn("Status poll failed: %d\n", errno);
+            sleep_remaining(&cycle_start, period_ms);
             continue;
         }
 
-        if (status_fds[STATUS_TOPIC].revents & POLLIN) {
-            struct status_message latest_status;
-            err = orb_copy(ORB_ID(status_message), status_fds[STATUS_TOPIC].fd, &latest_status);
-            if (err < 0) {
-                inwarn("Failed to read status message: %d\n", errno);
-            } else {
-                struct status_blk_t status_blk;
-                err = orb_status_pkt(&latest_status, &status_blk, header->timestamp);
-                if (err == 0) {
-                    blk_hdr_t status_hdr = {.type = DATA_STATUS, .count = 1};
-                    header->type_count++;
-                    memcpy(packet_ptr, &status_hdr, sizeof(status_hdr));
-                    packet_ptr += sizeof(status_hdr);
-                    memcpy(packet_ptr, &status_blk, sizeof(status_blk));
-                    packet_ptr += sizeof(status_blk);
-                } else {
-                    inerr("Failed to append status block: %d\n", EINVAL);
-                }
+        if (status_fds[ERROR_TOPIC].revents & POLLIN) {
+            struct error_message errors[STATUS_QUEUE_LEN];
+            ssize_t len = orb_copy_multi(status_fds[ERROR_TOPIC].fd, errors, sizeof(errors));
+            if (len < 0) {
+                inwarn("Failed to read error messages: %d\n", errno);
+            }
+            for (int i = 0; i < len / (ssize_t)sizeof(errors[0]); i++) {
+                event_queue_push_error(&events, &errors[i]);
             }
         }
-        status_fds[STATUS_TOPIC].revents = 0;
+        status_fds[ERROR_TOPIC].revents = 0;
 
-        if (status_fds[ERROR_TOPIC].revents & POLLIN) {
-            struct error_message latest_error;
-            err = orb_copy(ORB_ID(error_message), status_fds[ERROR_TOPIC].fd, &latest_error);
-            if (err < 0) {
-                inwarn("Failed to read error message: %d\n", errno);
-            } else {
-                struct error_blk_t error_blk;
-                err = orb_error_pkt(&latest_error, &error_blk, header->timestamp);
-                if (err == 0) {
-                    blk_hdr_t error_hdr = {.type = DATA_ERROR, .count = 1};
-                    header->type_count++;
-                    memcpy(packet_ptr, &error_hdr, sizeof(error_hdr));
-                    packet_ptr += sizeof(error_hdr);
-                    memcpy(packet_ptr, &error_blk, sizeof(error_blk));
-                    packet_ptr += sizeof(error_blk);
-                } else {
-                    inerr("Failed to append error block: %d\n", EINVAL);
-                }
+        if (status_fds[STATUS_TOPIC].revents & POLLIN) {
+            struct status_message statuses[STATUS_QUEUE_LEN];
+            ssize_t len = orb_copy_multi(status_fds[STATUS_TOPIC].fd, statuses, sizeof(statuses));
+            if (len < 0) {
+                inwarn("Failed to read status messages: %d\n", errno);
+            }
+            for (int i = 0; i < len / (ssize_t)sizeof(statuses[0]); i++) {
+                event_queue_push_status(&events, &statuses[i]);
             }
         }
-        status_fds[ERROR_TOPIC].revents = 0;
+        status_fds[STATUS_TOPIC].revents = 0;
 
-        if (radio_telem->buff->gnss_n > 0) {
-            header->type_count++;
-            blk_hdr_t blk_hdr = {
-                .type = DATA_LAT_LONG,
-                .count = radio_telem->buff->gnss_n,
-            };
-            memcpy(packet_ptr, &blk_hdr, sizeof(blk_hdr));
-            packet_ptr += sizeof(blk_hdr);
-            for (int i = 0; i < radio_telem->buff->gnss_n; i++) {
-                struct coord_blk_t coord_blk;
-                if (orb_gnss_pkt(&radio_telem->buff->gnss[i], &coord_blk, header->timestamp)) {
-                    inerr("Failed to create GNSS block %d\n", i);
-                    continue;
-                }
+        state_get_flightstate(unpacked_args->state, &flight_state);
+        state_get_flightsubstate(unpacked_args->state, &flight_substate);
+        enum odr_profile_e profile = odr_profile(flight_state, flight_substate);
 
-                memcpy(packet_ptr, &coord_blk, sizeof(struct coord_blk_t));
-                packet_ptr += sizeof(struct coord_blk_t);
-            }
+        /* Each part of the flight can have its own radio settings. A switch is announced in the packets before it, and
+         * they're built for the settings they go out on. */
+
+        if (radio_phase_plan(&phase, profile, seq_num)) {
+            ininfo("Switching the radio to SF%u at %lu kHz from packet #%u\n", phase.next.spread,
+                   (unsigned long)phase.next.bw, phase.first_packet);
         }
 
-        if (radio_telem->buff->alt_n > 0) {
-            header->type_count++;
-            blk_hdr_t blk_hdr = {
-                .type = DATA_ALT_SEA,
-                .count = radio_telem->buff->alt_n,
-            };
-            memcpy(packet_ptr, &blk_hdr, sizeof(blk_hdr));
-            packet_ptr += sizeof(blk_hdr);
-            for (int i = 0; i < radio_telem->buff->alt_n; i++) {
-                struct alt_blk_t alt_blk;
-                if (orb_alt_pkt(&radio_telem->buff->alt[i], &alt_blk, header->timestamp)) {
-                    inerr("Failed to create Alt block %d\n", i);
-                    continue;
-                }
-                memcpy(packet_ptr, &alt_blk, sizeof(struct alt_blk_t));
-                packet_ptr += sizeof(struct alt_blk_t);
-            }
+        /* The period leaves room on air for a packet of the profile's share, and the downsampler spreads its outputs
+         * over it, so faster radio settings send more samples per second */
+
+        size_t profile_size = sizeof(pkt_hdr_t) + downlink_bytes(profile);
+        uint32_t profile_period_ms =
+            airtime_period_ms(&phase.config, profile_size < PACKET_DATA_MAX_SIZE ? profile_size : PACKET_DATA_MAX_SIZE);
+#ifdef CONFIG_INSPACE_TELEMETRY_FEC
+        /* Each data packet's period also carries its share of the airtime of the parity packet after its group */
+
+        profile_period_ms = profile_period_ms * (FEC_GROUP + 1) / FEC_GROUP;
+#endif
+        if (profile_period_ms != period_ms) {
+            period_ms = profile_period_ms;
+            ininfo("Transmitting every %lu ms\n", (unsigned long)period_ms);
+            radio_telem_set_period(radio_telem, period_ms);
         }
 
-        if (radio_telem->buff->mag_n > 0) {
-            header->type_count++;
-            blk_hdr_t blk_hdr = {
-                .type = DATA_MAGNETIC,
-                .count = radio_telem->buff->mag_n,
-            };
-            memcpy(packet_ptr, &blk_hdr, sizeof(blk_hdr));
-            packet_ptr += sizeof(blk_hdr);
-            for (int i = 0; i < radio_telem->buff->mag_n; i++) {
-                struct mag_blk_t mag_blk;
-                if (orb_mag_pkt(&radio_telem->buff->mag[i], &mag_blk, header->timestamp)) {
-                    inerr("Failed to create Mag block %d\n", i);
-                    continue;
-                }
-                memcpy(packet_ptr, &mag_blk, sizeof(struct mag_blk_t));
-                packet_ptr += sizeof(struct mag_blk_t);
+        /* The first packet is built into an empty one, or the newest one the radio stage hasn't got to if they're all
+         * full. More follow it while samples are left over, the period has airtime for another full packet, and there
+         * are packets to spare, so a burst never overwrites its own packets. */
+
+        uint32_t burst_us = 0;
+        int burst = 0;
+        while (burst < CONFIG_INSPACE_TELEMETRY_BURST_MAX) {
+            if (burst > 0 && (!backlog_waiting() ||
+                              packet_buffer_depth(&packets) + BURST_SPARE >= PACKET_QUEUE_NUM_BUFFERS ||
+                              !airtime_fits(&phase.config, burst_us, PACKET_DATA_MAX_SIZE, period_ms))) {
+                break;
             }
-        }
 
-        if (radio_telem->buff->accel_n > 0) {
-            header->type_count++;
-            blk_hdr_t blk_hdr = {
-                .type = DATA_ACCEL_REL,
-                .count = radio_telem->buff->accel_n,
-            };
-            memcpy(packet_ptr, &blk_hdr, sizeof(blk_hdr));
-            packet_ptr += sizeof(blk_hdr);
-            for (int i = 0; i < radio_telem->buff->accel_n; i++) {
-                struct accel_blk_t accel_blk;
-                if (orb_accel_pkt(&radio_telem->buff->accel[i], &accel_blk, header->timestamp)) {
-                    inerr("Failed to create Accel block %d\n", i);
-                    continue;
-                }
-                memcpy(packet_ptr, &accel_blk, sizeof(struct accel_blk_t));
-                packet_ptr += sizeof(struct accel_blk_t);
+            packet_node_t *node = packet_buffer_get_empty(&packets);
+            if (node == NULL) {
+                inwarn("No packet to build into\n");
+                break;
             }
-        }
 
-        if (radio_telem->buff->gyro_n > 0) {
-            header->type_count++;
-            blk_hdr_t blk_hdr = {
-                .type = DATA_ANGULAR_VEL,
-                .count = radio_telem->buff->gyro_n,
-            };
-            memcpy(packet_ptr, &blk_hdr, sizeof(blk_hdr));
-            packet_ptr += sizeof(blk_hdr);
-            for (int i = 0; i < radio_telem->buff->gyro_n; i++) {
-                struct ang_vel_blk_t ang_vel_blk;
-                if (orb_ang_vel_pkt(&radio_telem->buff->gyro[i], &ang_vel_blk, header->timestamp)) {
-                    inerr("Failed to create Ang vel block %d\n", i);
-                    continue;
-                }
-                memcpy(packet_ptr, &ang_vel_blk, sizeof(struct ang_vel_blk_t));
-                packet_ptr += sizeof(struct ang_vel_blk_t);
+            size_t packet_size = build_packet(node->packet, seq_num, profile);
+            node->end = node->packet + packet_size;
+            if (packet_size <= sizeof(pkt_hdr_t)) {
+                packet_buffer_put_empty(&packets, node);
+                break;
             }
-        }
 
-        size_t packet_size = packet_ptr - packet_buffer;
-        if (packet_size > PACKET_MAX_SIZE) {
-            inerr("Packet size is too large: %zu\n", packet_size);
-        } else if (packet_size > sizeof(pkt_hdr_t)) {
-            ininfo("Transmitting packet #%u of size %zu bytes. Accel: %d, Gyro: %d, Mag: %d, GNSS: %d, Alt: %d\n",
-                   header->packet_num, packet_size, radio_telem->buff->accel_n, radio_telem->buff->gyro_n,
-                   radio_telem->buff->mag_n, radio_telem->buff->gnss_n, radio_telem->buff->alt_n);
-            err = transmit(radio, packet_buffer, packet_size);
-            if (err < 0) {
-                inerr("Error transmitting packet: %d\n", -err);
+            /* Packets are numbered as they're queued, so a burst and each parity group run on consecutively */
+
+            seq_num++;
+            packet_buffer_put_full(&packets, node);
+            burst_us += packet_airtime_us(&phase.config, packet_size);
+#ifdef CONFIG_INSPACE_TELEMETRY_FEC
+            burst_us += packet_airtime_us(&phase.config, queue_parity(node->packet, packet_size));
+#endif
+            if (radio_phase_advance(&phase, seq_num)) {
+                ininfo("Building packets for SF%u at %lu kHz\n", phase.config.spread, (unsigned long)phase.config.bw);
             }
+            burst++;
         }
 
-        /* for the sake of making the dynamic rate adjustment work, we need at least one static thing as an anchor, imo
-         * the choice should be transmission time */
-        struct timespec cycle_end;
-        clock_gettime(CLOCK_MONOTONIC, &cycle_end);
-        long elapsed_ms =
-            (cycle_end.tv_sec - cycle_start.tv_sec) * 1000 + (cycle_end.tv_nsec - cycle_start.tv_nsec) / 1000000;
-        ininfo("Transmission cycle time: %ld ms\n", elapsed_ms);
-        long remaining_ms = TRANSMIT_PERIOD_MS - elapsed_ms;
-        if (remaining_ms > 0) {
-            struct timespec sleep_time = {
-                .tv_sec = remaining_ms / 1000,
-                .tv_nsec = (remaining_ms % 1000) * 1000000,
-            };
-            nanosleep(&sleep_time, NULL);
+        /* Building runs on the transmit period, which the downsampler also sizes its output to */
+
+        uint32_t cycle_ms = elapsed_ms_since(&cycle_start);
+        stats.cycle_hist[transmit_hist_bucket(cycle_ms)]++;
+        ininfo("Transmission cycle time: %lu ms, %d packets built, %zu queued, %u overwritten\n",
+               (unsigned long)cycle_ms, burst, packet_buffer_depth(&packets), packet_buffer_overwrites(&packets));
+
+        uint32_t stats_ms = elapsed_ms_since(&stats_start);
+        if (stats_ms >= TRANSMIT_STATS_PERIOD_MS) {
+            publish_stats(&stats_fd, stats_ms);
+            clock_gettime(CLOCK_MONOTONIC, &stats_start);
         }
+        sleep_remaining(&cycle_start, period_ms);
     }
 
 err_cleanup:
@@ -298,6 +498,471 @@ err_cleanup:
     pthread_exit(err_to_ptr(err));
 }
 
+/* Build a packet from the events waiting to be sent and the oldest samples in the backlog. The samples packed or
+ * dropped are taken out of the backlog, and the rest carry over to the next packet.
+ *
+ * @param packet Where to build the packet
+ * @param seq_num The packet's number
+ * @param profile The downlink profile of the current part of the flight
+ * @return The size of the packet in bytes, just the header's if there was nothing to send
+ */
+static size_t build_packet(uint8_t *packet, uint32_t seq_num, enum odr_profile_e profile) {
+    struct packer pk;
+
+    /* use mission time as current time for now, this does not account for reboots */
+    struct timespec current_time;
+    clock_gettime(CLOCK_REALTIME, &current_time);
+    uint32_t mission_time_ms = current_time.tv_sec * 1000 + current_time.tv_nsec / 1000000;
+    packer_init(&pk, packet, seq_num, mission_time_ms);
+
+    /* A radio switch is announced before anything else, so every packet before it tells the ground */
+
+    if (phase.announcing) {
+        struct radio_switch_blk_t *blk = packer_add(&pk, DATA_RADIO_SWITCH, mission_time_ms);
+        if (blk == NULL) {
+            inerr("Failed to announce the radio switch\n");
+            stats.drops.size[DATA_RADIO_SWITCH]++;
+        } else {
+            radio_switch_blk_init(blk, phase.first_packet, phase.next.spread, phase.next.bw);
+        }
+    }
+
+    /* Errors and status go next, so they're never crowded out by sensor data */
+
+    int n_events = event_queue_pack(&events, &pk);
+    if (n_events > 0 || events.len > 0) {
+        indebug("Packed %d events, %u still queued\n", n_events, events.len);
+    }
+
+    /* Each channel first gets its share of the packet for the current part of the flight, in priority order.
+     * Whatever room is left goes to the samples still waiting, in the same order, so a backlog drains. */
+
+    int space = packer_space(&pk);
+    int planned[NUM_DOWNLINK_CHANNELS] = {0};
+    int used[NUM_DOWNLINK_CHANNELS] = {0};
+    int taken[RADIO_NUM_CHANNELS] = {0};
+
+    for (int i = 0; i < NUM_DOWNLINK_CHANNELS; i++) {
+        const struct downlink_channel *dc = &downlink_channels[i];
+        int share = downlink_count(radio_data_count(&backlog, dc->channel), dc->channel, profile);
+        planned[i] = downlink_fit(&pk, dc, share, space, &used[i]);
+        space -= used[i];
+    }
+
+    for (int i = 0; i < NUM_DOWNLINK_CHANNELS; i++) {
+        const struct downlink_channel *dc = &downlink_channels[i];
+        int bytes;
+        planned[i] = downlink_fit(&pk, dc, radio_data_count(&backlog, dc->channel), space + used[i], &bytes);
+        space -= bytes - used[i];
+        used[i] = bytes;
+    }
+
+    /* The oldest samples are packed, the rest carry over to the next packet. Delta blocks can split differently than
+     * planned once the samples after them are left out, so they get any room the channels after them don't need and
+     * only take what they pack. */
+
+    int reserved = packer_space(&pk) - space;
+    for (int i = 0; i < NUM_DOWNLINK_CHANNELS; i++) {
+        const struct downlink_channel *dc = &downlink_channels[i];
+        int bytes;
+        int packed;
+
+        reserved -= used[i];
+        if (delta_type(dc->types[0])) {
+            int room = packer_space(&pk) - reserved;
+            room = dc->budget < room ? dc->budget : room;
+            planned[i] = pack_delta(&pk, dc, planned[i], room, true, &bytes, &packed);
+        } else {
+            packed = pack_channel(&pk, dc, planned[i]);
+        }
+        taken[dc->channel] = planned[i];
+        stats.samples_packed += packed;
+    }
+
+    int available[RADIO_NUM_CHANNELS];
+    for (int ch = 0; ch < RADIO_NUM_CHANNELS; ch++) {
+        available[ch] = radio_data_count(&backlog, ch);
+    }
+    radio_data_take(&backlog, taken);
+
+    size_t packet_size = packer_size(&pk);
+    if (packet_size > sizeof(pkt_hdr_t)) {
+        ininfo("Built packet #%u of size %zu bytes. Accel: %d/%d, Gyro: %d/%d, Mag: %d/%d, GNSS: %d/%d, "
+               "Alt: %d/%d, Baro: %d/%d\n",
+               ((pkt_hdr_t *)packet)->packet_num, packet_size, taken[RADIO_ACCEL], available[RADIO_ACCEL],
+               taken[RADIO_GYRO], available[RADIO_GYRO], taken[RADIO_MAG], available[RADIO_MAG], taken[RADIO_GNSS],
+               available[RADIO_GNSS], taken[RADIO_ALT], available[RADIO_ALT], taken[RADIO_BARO],
+               available[RADIO_BARO]);
+    }
+    return packet_size;
+}
+
+/* Checks if the backlog has samples waiting to be sent
+ *
+ * @return True if any channel has samples left
+ */
+static bool backlog_waiting(void) {
+    for (int ch = 0; ch < RADIO_NUM_CHANNELS; ch++) {
+        if (radio_data_count(&backlog, ch) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Get the time a packet takes on air
+ *
+ * @param config The radio's configuration
+ * @param packet_size The size of the packet, 0 for no packet
+ * @return The airtime in microseconds, 0 if there's no packet or it can't be calculated
+ */
+static uint32_t packet_airtime_us(struct radio_options const *config, size_t packet_size) {
+    uint32_t airtime_us = 0;
+
+    if (packet_size > 0 && lora_airtime_us(config, packet_size, &airtime_us) < 0) {
+        return 0;
+    }
+    return airtime_us;
+}
+
+/* Get the number of a channel's samples to put in a packet
+ *
+ * @param available The number of samples the channel has
+ * @param channel The channel
+ * @param profile The downlink profile of the current part of the flight
+ * @return The number of samples to pack
+ */
+static int downlink_count(int available, enum radio_channel_e channel, enum odr_profile_e profile) {
+    int outputs = downlink_outputs(channel, profile);
+    return available < outputs ? available : outputs;
+}
+
+/* Get the bytes a channel's samples take in a packet, besides block headers
+ *
+ * @param dc The channel
+ * @return The size of every block body one sample is sent in
+ */
+static int downlink_sample_bytes(const struct downlink_channel *dc) {
+    int bytes = 0;
+    for (int t = 0; t < dc->n_types; t++) {
+        bytes += blk_body_len(dc->types[t]);
+    }
+    return bytes;
+}
+
+/* Get the bytes of a packet a channel's samples take in fixed size blocks
+ *
+ * @param dc The channel
+ * @param n The number of samples
+ * @return The number of bytes the samples take, including their block headers
+ */
+static int downlink_cost(const struct downlink_channel *dc, int n) {
+    if (n <= 0) {
+        return 0;
+    }
+    return dc->n_types * (int)sizeof(blk_hdr_t) + n * downlink_sample_bytes(dc);
+}
+
+/* Get the number of a channel's oldest samples that fit in a packet
+ *
+ * @param pk The packer of the packet
+ * @param dc The channel
+ * @param n The most samples to fit
+ * @param space The room in the packet in bytes
+ * @param bytes Where to store the number of bytes the samples that fit take
+ * @return The number of samples that fit in the room and the channel's budget
+ */
+static int downlink_fit(struct packer *pk, const struct downlink_channel *dc, int n, int space, int *bytes) {
+    space = dc->budget < space ? dc->budget : space;
+
+    if (delta_type(dc->types[0])) {
+        return pack_delta(pk, dc, n, space, false, bytes, NULL);
+    }
+
+    int fit = (space - dc->n_types * (int)sizeof(blk_hdr_t)) / downlink_sample_bytes(dc);
+    fit = fit > 0 ? fit : 0;
+    n = n < fit ? n : fit;
+    *bytes = downlink_cost(dc, n);
+    return n;
+}
+
+/* Pack the oldest samples of a channel waiting to be sent, one block per block type. Each block header counts the
+ * samples actually written into it, since a sample that can't be encoded is taken back out.
+ *
+ * @param pk The packer of the packet to add the samples to
+ * @param dc The channel
+ * @param n The number of samples to pack, which must fit in the packet
+ * @return The number of samples written into at least one block, leaving out those dropped from every block
+ */
+static int pack_channel(struct packer *pk, const struct downlink_channel *dc, int n) {
+    bool written[RADIO_DATA_LEN] = {false};
+    int packed = 0;
+
+    for (int t = 0; t < dc->n_types; t++) {
+        for (int i = 0; i < n; i++) {
+            void *sample = radio_data_element(&backlog, dc->channel, i);
+            struct decimator_envelope *env = radio_data_envelope(&backlog, dc->channel, i);
+            uint64_t timestamp = envelope_type(dc->types[t]) ? env->timestamp : *(uint64_t *)sample;
+            void *blk = packer_add(pk, dc->types[t], timestamp / 1000);
+
+            if (blk == NULL || dc->encode[t](sample, env, blk, packer_base_time(pk))) {
+                inerr("Failed to create block %d of type %d\n", i, dc->types[t]);
+                if (blk != NULL) {
+                    packer_undo(pk);
+                    stats.drops.time[dc->types[t]]++;
+                } else if (packer_space(pk) < sizeof(blk_hdr_t) + blk_body_len(dc->types[t])) {
+                    stats.drops.size[dc->types[t]]++;
+                } else {
+                    stats.drops.time[dc->types[t]]++;
+                }
+            } else if (!written[i]) {
+                written[i] = true;
+                packed++;
+            }
+        }
+    }
+    return packed;
+}
+
+/* Pack the oldest samples of a channel sent in delta blocks, starting a new block wherever a run of samples on a
+ * regular period ends. Samples whose time can't be offset from the packet header are dropped.
+ *
+ * @param pk The packer of the packet to add the samples to
+ * @param dc The channel
+ * @param n The most samples to pack
+ * @param space The most bytes of the packet the samples can take
+ * @param write If the blocks are added to the packet, otherwise only their size is measured
+ * @param bytes Where to store the number of bytes the blocks take
+ * @param packed Where to store the number of samples written into the blocks, or NULL
+ * @return The number of samples packed or dropped, which are taken from the backlog
+ */
+static int pack_delta(struct packer *pk, const struct downlink_channel *dc, int n, int space, bool write, int *bytes,
+                      int *packed) {
+    struct axes_blk_t axes[RADIO_DATA_LEN];
+    uint8_t body[PACKET_MAX_SIZE];
+    int written = 0;
+    int i = 0;
+
+    *bytes = 0;
+    while (i < n) {
+        int run = 0;
+        size_t body_len;
+
+        while (i + run < n && dc->encode[0](radio_data_element(&backlog, dc->channel, i + run), NULL, &axes[run],
+                                            packer_base_time(pk)) == 0) {
+            run++;
+        }
+        if (run == 0) {
+            if (write) {
+                inerr("Failed to create block %d of type %d\n", i, dc->types[0]);
+                stats.drops.time[dc->types[0]]++;
+            }
+            i++;
+            continue;
+        }
+
+        int room = space - *bytes - (int)sizeof(blk_hdr_t);
+        int count = room > 0 ? delta_blk_encode(body, room, axes, run, &body_len) : 0;
+        if (count == 0) {
+            break;
+        }
+        if (write && packer_add_block(pk, dc->types[0], count, body, body_len) < 0) {
+            break;
+        }
+        *bytes += sizeof(blk_hdr_t) + body_len;
+        i += count;
+        written += count;
+    }
+    if (packed != NULL) {
+        *packed = written;
+    }
+    return i;
+}
+
+/* Sends the packets the transmit thread builds, so a slow radio write never delays sampling the backlog
+ *
+ * @param arg The radio and its configuration, as a struct radio_stage_args
+ * @return Never returns
+ */
+static void *radio_stage_main(void *arg) {
+    struct radio_stage_args *args = arg;
+    struct radio_options config = *args->config;
+
+    for (;;) {
+        packet_node_t *node = packet_buffer_get_full(&packets);
+        size_t packet_size = node->end - node->packet;
+        uint32_t airtime_us = 0;
+        struct timespec write_start;
+
+        if (radio_phase_due(&phase, ((pkt_hdr_t *)node->packet)->packet_num)) {
+            switch_radio(args->radio, &config);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &write_start);
+        int err = transmit(args->radio, node->packet, packet_size);
+        if (err < 0) {
+            inerr("Error transmitting packet: %d\n", -err);
+        } else {
+            atomic_fetch_add(&packets_sent, 1);
+            atomic_fetch_add(&bytes_sent, err);
+        }
+
+        /* A write can return before the packet is off air, and the next one mustn't queue behind it */
+
+        if (lora_airtime_us(&config, packet_size, &airtime_us) == 0) {
+            indebug("Packet #%u is on air for %lu us\n", ((pkt_hdr_t *)node->packet)->packet_num,
+                    (unsigned long)airtime_us);
+            sleep_remaining(&write_start, airtime_us / 1000);
+        }
+        atomic_fetch_add(&write_hist[transmit_hist_bucket(elapsed_ms_since(&write_start))], 1);
+
+        packet_buffer_put_empty(&packets, node);
+    }
+
+    return NULL;
+}
+
+/* Switches the radio to the settings announced for the next part of the flight, before the first packet sent on them.
+ * The ground and the transmit thread move to the new settings at the announced packet either way, so a failed switch
+ * is left pending and retried before the next packet, reapplying every setting in case only some of them were.
+ *
+ * @param radio The radio device
+ * @param config The radio stage's copy of the radio's configuration, updated to the new settings if the switch works
+ */
+static void switch_radio(int radio, struct radio_options *config) {
+    struct radio_options previous = *config;
+    struct timespec start;
+
+    *config = phase.next;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int err = reconfigure_radio(radio, config);
+    uint32_t took_us = elapsed_us_since(&start);
+
+    if (err) {
+        inerr("Couldn't switch the radio to SF%u at %lu kHz: %d\n", config->spread, (unsigned long)config->bw, err);
+        atomic_fetch_add(&switch_fails, 1);
+        *config = previous;
+        return;
+    }
+
+    atomic_fetch_add(&radio_switches, 1);
+    atomic_store(&switch_us, took_us);
+    ininfo("RADIO: Switched to SF%u at %lu kHz in %lu us\n", config->spread, (unsigned long)config->bw,
+           (unsigned long)took_us);
+    radio_phase_done(&phase);
+}
+
+#ifdef CONFIG_INSPACE_TELEMETRY_FEC
+/* Add a data packet to the current parity group, and queue the group's parity packet behind it once the group is
+ * complete. Parity only goes into an empty packet, never over a queued one, which could be the data packet it covers.
+ * The group goes without parity when the buffer is full.
+ *
+ * @param packet The data packet, already queued to be sent
+ * @param len The length of the data packet
+ * @return The length of the parity packet queued, 0 if none was
+ */
+static size_t queue_parity(const uint8_t *packet, size_t len) {
+    int parity_len = fec_encoder_add(&fec, packet, len);
+    packet_node_t *node;
+
+    if (parity_len < 0) {
+        inerr("Couldn't cover packet #%u with parity: %d\n", ((pkt_hdr_t *)packet)->packet_num, -parity_len);
+        return 0;
+    }
+    if (parity_len == 0) {
+        return 0;
+    }
+
+    node = packet_buffer_get_unused(&packets);
+    if (node == NULL) {
+        inwarn("No empty packet to put parity in, skipping parity for packets #%u to #%u\n",
+               ((pkt_hdr_t *)fec.parity)->packet_num, (uint8_t)(((pkt_hdr_t *)fec.parity)->packet_num + FEC_GROUP - 1));
+        return 0;
+    }
+    memcpy(node->packet, fec.parity, parity_len);
+    node->end = node->packet + parity_len;
+    packet_buffer_put_full(&packets, node);
+    indebug("Queued parity for packets #%u to #%u\n", ((pkt_hdr_t *)fec.parity)->packet_num,
+            (uint8_t)(((pkt_hdr_t *)fec.parity)->packet_num + FEC_GROUP - 1));
+    return parity_len;
+}
+#endif
+
+/* Measures the time since a point on the monotonic clock
+ *
+ * @param start The point to measure from
+ * @return The number of microseconds since start
+ */
+static uint32_t elapsed_us_since(struct timespec const *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000000 + (now.tv_nsec - start->tv_nsec) / 1000;
+}
+
+/* Measures the time since a point on the monotonic clock
+ *
+ * @param start The point to measure from
+ * @return The number of milliseconds since start
+ */
+static uint32_t elapsed_ms_since(struct timespec const *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+/* Sleeps until a period has passed since a point on the monotonic clock
+ *
+ * @param start The start of the period
+ * @param period_ms The length of the period in milliseconds
+ */
+static void sleep_remaining(struct timespec const *start, uint32_t period_ms) {
+    long remaining_ms = (long)period_ms - (long)elapsed_ms_since(start);
+    if (remaining_ms > 0) {
+        struct timespec sleep_time = {
+            .tv_sec = remaining_ms / 1000,
+            .tv_nsec = (remaining_ms % 1000) * 1000000,
+        };
+        nanosleep(&sleep_time, NULL);
+    }
+}
+
+/* Publish the transmit thread's stats, along with the radio stage's
+ *
+ * @param fd The transmit stats topic, -1 if it hasn't been advertised yet
+ * @param elapsed_ms The time since the stats were last published
+ */
+static void publish_stats(int *fd, uint32_t elapsed_ms) {
+    static uint32_t last_bytes;
+    static uint32_t last_samples;
+
+    for (int i = 0; i < TRANSMIT_HIST_BUCKETS; i++) {
+        stats.write_hist[i] = atomic_load(&write_hist[i]);
+    }
+    stats.packets_sent = atomic_load(&packets_sent);
+    stats.bytes_sent = atomic_load(&bytes_sent);
+    stats.bytes_per_s = (uint64_t)(stats.bytes_sent - last_bytes) * 1000 / elapsed_ms;
+    stats.samples_per_s = (uint64_t)(stats.samples_packed - last_samples) * 1000 / elapsed_ms;
+    stats.queue_depth = packet_buffer_depth(&packets);
+    stats.overwrites = packet_buffer_overwrites(&packets);
+    stats.radio_switches = atomic_load(&radio_switches);
+    stats.switch_us = atomic_load(&switch_us);
+    stats.switch_fails = atomic_load(&switch_fails);
+    stats.timestamp = orb_absolute_time();
+    last_bytes = stats.bytes_sent;
+    last_samples = stats.samples_packed;
+
+    /* Persistent, so the shell can read the latest stats as soon as it subscribes */
+
+    if (*fd < 0) {
+        *fd = orb_advertise_multi_queue_persist(ORB_ID(transmit_stats), &stats, NULL, 1);
+        if (*fd < 0) {
+            inwarn("Couldn't advertise transmit stats: %d\n", errno);
+        }
+    } else if (orb_publish(ORB_ID(transmit_stats), *fd, &stats) < 0) {
+        inwarn("Couldn't publish transmit stats: %d\n", errno);
+    }
+}
+
 /* Transmits a packet over the radio with a fake delay
  *
  * @param radio The radio to transmit to
@@ -306,6 +971,13 @@ err_cleanup:
  * @return The number of bytes written or a negative error code
  */
 static int transmit(int radio, uint8_t *packet, size_t packet_size) {
+#ifdef CONFIG_INSPACE_TELEMETRY_SIM_RADIO
+    int written = sim_radio_write(&sim, packet, packet_size);
+    if (written < 0) {
+        inerr("Error transmitting: %d\n", -written);
+        return written;
+    }
+#else
     int written = write(radio, packet, packet_size);
     int err = 0;
     if (written == -1) {
@@ -313,6 +985,7 @@ static int transmit(int radio, uint8_t *packet, size_t packet_size) {
         inerr("Error transmitting: %d\n", err);
         return -err;
     }
+#endif
     indebug("Completed transmission of packet #%u of %zu bytes.\n", ((pkt_hdr_t *)packet)->packet_num, packet_size);
     return written;
 }
@@ -349,6 +1022,36 @@ static int configure_radio(int fd, struct radio_options const *config) {
     err = ioctl(fd, WLIOC_SETPRLEN, config->preamble);
     config_error(err);
     ininfo("RADIO: Set preamble to %d\n", config->preamble);
+#elif defined(CONFIG_INSPACE_TELEMETRY_SIM_RADIO)
+    err = -sim_radio_init(&sim, config, fd, CONFIG_INSPACE_TELEMETRY_SIM_RADIO_LOSS,
+                          CONFIG_INSPACE_TELEMETRY_SIM_RADIO_BER, CONFIG_INSPACE_TELEMETRY_SIM_RADIO_SEED);
+    if (err) {
+        inerr("Error configuring simulated radio: %d\n", err);
+        return err;
+    }
+    ininfo("RADIO: Simulating SF%u at %lu kHz, %u/1000 packets lost\n", config->spread, (unsigned long)config->bw,
+           CONFIG_INSPACE_TELEMETRY_SIM_RADIO_LOSS);
+#endif /* defined(CONFIG_LPWAN_RN2XX3) */
+
+    return err;
+}
+
+/* Switches the radio's spread factor and bandwidth, leaving the rest of its configuration as it is
+ *
+ * @param fd The radio device
+ * @param config The radio's new configuration, which the simulated radio keeps using
+ * @return 0 on success, or the error that stopped the switch
+ */
+static int reconfigure_radio(int fd, struct radio_options const *config) {
+    int err = 0;
+
+#if defined(CONFIG_LPWAN_RN2XX3)
+    err = ioctl(fd, WLIOC_SETSPREAD, config->spread);
+    config_error(err);
+    err = ioctl(fd, WLIOC_SETBANDWIDTH, config->bw);
+    config_error(err);
+#elif defined(CONFIG_INSPACE_TELEMETRY_SIM_RADIO)
+    sim.config = config;
 #endif /* defined(CONFIG_LPWAN_RN2XX3) */
 
     return err;
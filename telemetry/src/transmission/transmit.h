@@ -3,9 +3,14 @@
 
 #include "../radio-telem.h"
 
+/* How often a packet is transmitted in milliseconds, unless the period is set from the radio's airtime */
+
+#define TRANSMIT_PERIOD_MS 700
+
 struct transmit_args {
     struct radio_options config;
     radio_telem_t *radio_telem;
+    rocket_state_t *state;
 };
 
 void *transmit_main(void *arg);
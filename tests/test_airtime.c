@@ -0,0 +1,77 @@
+#include <errno.h>
+#include <nuttx/config.h>
+#include <testing/unity.h>
+
+#include "../telemetry/src/transmission/airtime.h"
+#include "../telemetry/src/transmission/transmit.h"
+
+/* A radio configuration with a spread factor and bandwidth, and the RN2xx3's defaults otherwise */
+
+#define lora_config(sf, khz) {.bw = (khz), .spread = (sf), .preamble = 8, .crc = true}
+
+/* Tests */
+
+static void test_airtime__matches_semtech_formula(void) {
+    struct radio_options fast = lora_config(7, 125);
+    struct radio_options slow = lora_config(12, 125);
+    uint32_t airtime_us;
+
+    TEST_ASSERT_EQUAL(0, lora_airtime_us(&fast, 255, &airtime_us));
+    TEST_ASSERT_EQUAL_MESSAGE(399616, airtime_us, "Wrong airtime of a full packet at SF7, 125 kHz");
+
+    /* Low data rate optimization is on for symbols this long */
+
+    TEST_ASSERT_EQUAL(0, lora_airtime_us(&slow, 20, &airtime_us));
+    TEST_ASSERT_EQUAL_MESSAGE(1318912, airtime_us, "Wrong airtime of a short packet at SF12, 125 kHz");
+}
+
+static void test_airtime__invalid_config(void) {
+    struct radio_options unset = {0};
+    uint32_t airtime_us;
+
+    TEST_ASSERT_EQUAL_MESSAGE(-EINVAL, lora_airtime_us(&unset, 255, &airtime_us), "An unset radio has no airtime");
+    TEST_ASSERT_EQUAL_MESSAGE(TRANSMIT_PERIOD_MS, airtime_period_ms(&unset, 255), "Should fall back to the default");
+}
+
+static void test_airtime__period_follows_config(void) {
+#ifdef CONFIG_INSPACE_TELEMETRY_ADAPTIVE_PERIOD
+    struct radio_options wide = lora_config(7, 500);
+    struct radio_options fast = lora_config(7, 125);
+    struct radio_options slow = lora_config(9, 125);
+    uint32_t airtime_us;
+
+    TEST_ASSERT_LESS_THAN_MESSAGE(airtime_period_ms(&fast, 255), airtime_period_ms(&wide, 255),
+                                  "A wider bandwidth should transmit more often");
+    TEST_ASSERT_LESS_THAN_MESSAGE(airtime_period_ms(&slow, 255), airtime_period_ms(&fast, 255),
+                                  "A lower spread factor should transmit more often");
+    TEST_ASSERT_LESS_THAN_MESSAGE(airtime_period_ms(&fast, 255), airtime_period_ms(&fast, 100),
+                                  "Smaller packets should transmit more often");
+
+    lora_airtime_us(&slow, 255, &airtime_us);
+    TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(airtime_us / 1000, airtime_period_ms(&slow, 255),
+                                         "The period is shorter than the airtime");
+    TEST_ASSERT_EQUAL_MESSAGE(CONFIG_INSPACE_TELEMETRY_MIN_PERIOD_MS, airtime_period_ms(&wide, 20),
+                              "The period should never be below the minimum");
+#endif
+}
+
+static void test_airtime__burst_fits_period(void) {
+    struct radio_options wide = lora_config(7, 500);
+    uint32_t airtime_us;
+
+    TEST_ASSERT_EQUAL(0, lora_airtime_us(&wide, 255, &airtime_us));
+
+    /* A full packet at SF7, 500 kHz is on air for about 100 ms, so a 700 ms period has room for a few */
+
+    TEST_ASSERT_TRUE_MESSAGE(airtime_fits(&wide, 0, 255, 700), "A single packet should fit");
+    TEST_ASSERT_TRUE_MESSAGE(airtime_fits(&wide, 4 * airtime_us, 255, 700), "A fifth packet should fit");
+    TEST_ASSERT_FALSE_MESSAGE(airtime_fits(&wide, 5 * airtime_us, 255, 700), "A sixth packet would overrun");
+    TEST_ASSERT_FALSE_MESSAGE(airtime_fits(&wide, 0, 255, airtime_us / 1000), "The margin should leave no room");
+}
+
+void test_airtime(void) {
+    RUN_TEST(test_airtime__matches_semtech_formula);
+    RUN_TEST(test_airtime__invalid_config);
+    RUN_TEST(test_airtime__period_follows_config);
+    RUN_TEST(test_airtime__burst_fits_period);
+}
@@ -0,0 +1,190 @@
+#include <errno.h>
+#include <nuttx/config.h>
+#include <string.h>
+#include <testing/unity.h>
+
+#include "../telemetry/src/packets/packer.h"
+
+/* A mission time whose samples can all be offset from the packet header's timestamp */
+
+#define MISSION_TIME_MS 60000
+
+/* The most samples a test packet decodes to */
+
+#define MAX_DECODED 16
+
+/* A sample passed to the decoder's callback */
+
+struct decoded_sample {
+    enum block_type_e type;
+    const struct block_body_desc *body;
+    uint8_t data[BLOCK_MAX_SIZE];
+};
+
+/* The samples a packet decoded to */
+
+struct decoded_packet {
+    int n;
+    struct decoded_sample samples[MAX_DECODED];
+};
+
+static uint8_t packet[PACKET_MAX_SIZE];
+static struct decoded_packet decoded;
+
+/* Helpers */
+
+/* Record each decoded sample */
+static int record_sample(void *arg, enum block_type_e type, const struct block_body_desc *body, const void *sample) {
+    struct decoded_packet *out = arg;
+
+    TEST_ASSERT_TRUE_MESSAGE(out->n < MAX_DECODED, "Decoded too many samples");
+    out->samples[out->n].type = type;
+    out->samples[out->n].body = body;
+    memcpy(out->samples[out->n].data, sample, body->len);
+    out->n++;
+    return 0;
+}
+
+/* Stop decoding at the first sample */
+static int stop_decoding(void *arg, enum block_type_e type, const struct block_body_desc *body, const void *sample) {
+    (void)arg;
+    (void)type;
+    (void)body;
+    (void)sample;
+    return 1;
+}
+
+/* Read value i of a decoded sample's field by name */
+static int64_t field_value(const struct decoded_sample *sample, const char *name, int i) {
+    int64_t value;
+
+    for (int f = 0; f < sample->body->n_fields; f++) {
+        if (strcmp(sample->body->fields[f].name, name) == 0) {
+            TEST_ASSERT_EQUAL_MESSAGE(0, block_field_value(sample->data, &sample->body->fields[f], i, &value),
+                                      "Couldn't read field value");
+            return value;
+        }
+    }
+    TEST_FAIL_MESSAGE("Field not found");
+    return 0;
+}
+
+/* Tests */
+
+static void test_blocks__table_matches_structs(void) {
+    TEST_ASSERT_EQUAL_MESSAGE(sizeof(struct alt_blk_t), block_desc(DATA_ALT_SEA)->body->len, "Wrong altitude size");
+    TEST_ASSERT_EQUAL_MESSAGE(sizeof(struct coord_blk_t), block_desc(DATA_LAT_LONG)->body->len, "Wrong coord size");
+    TEST_ASSERT_EQUAL_MESSAGE(sizeof(struct delta_blk_t), block_desc(DATA_ACCEL_DELTA)->body->len,
+                              "Wrong delta size");
+    TEST_ASSERT_EQUAL_MESSAGE(sizeof(struct accel_blk_t), block_desc(DATA_ACCEL_DELTA)->sample->len,
+                              "Delta samples should decode to acceleration blocks");
+
+    for (int type = 0; type < DATA_RES_ABOVE; type++) {
+        const struct block_desc *desc = block_desc(type);
+        size_t len = 0;
+
+        TEST_ASSERT_NOT_NULL_MESSAGE(desc, "Block type has no description");
+        TEST_ASSERT_EQUAL_MESSAGE(desc->body->len, blk_body_len(type), "Size lookup disagrees with the table");
+        for (int f = 0; f < desc->body->n_fields; f++) {
+            len += desc->body->fields[f].size * desc->body->fields[f].count;
+        }
+        TEST_ASSERT_EQUAL_MESSAGE(desc->body->len, len, "Fields don't add up to the body size");
+    }
+
+    TEST_ASSERT_NULL_MESSAGE(block_desc(DATA_RES_ABOVE), "Reserved type has a description");
+}
+
+static void test_blocks__field_values(void) {
+    struct ang_vel_env_blk_t env = {.time_offset = -5, .min = {-300, 0, 1}, .max = {2, 3, 300}};
+    const struct block_body_desc *body = block_desc(DATA_ANG_VEL_ENV)->body;
+    int64_t value;
+
+    TEST_ASSERT_EQUAL_STRING("min", body->fields[1].name);
+    TEST_ASSERT_EQUAL_MESSAGE(0, block_field_value(&env, &body->fields[0], 0, &value), "Couldn't read time offset");
+    TEST_ASSERT_EQUAL_MESSAGE(-5, value, "Signed value read wrong");
+    TEST_ASSERT_EQUAL_MESSAGE(0, block_field_value(&env, &body->fields[1], 0, &value), "Couldn't read array value");
+    TEST_ASSERT_EQUAL_MESSAGE(-300, value, "Array value read wrong");
+    TEST_ASSERT_EQUAL_MESSAGE(0, block_field_value(&env, &body->fields[2], 2, &value), "Couldn't read array value");
+    TEST_ASSERT_EQUAL_MESSAGE(300, value, "Array value read wrong");
+    TEST_ASSERT_EQUAL_MESSAGE(-ERANGE, block_field_value(&env, &body->fields[2], 3, &value),
+                              "Read past the end of an array");
+}
+
+static void test_blocks__round_trip(void) {
+    struct packer pk;
+    struct axes_blk_t run[4];
+    uint8_t body[BLOCK_MAX_SIZE];
+    size_t body_len;
+    struct accel_blk_t *accel;
+    struct status_blk_t *status;
+
+    packer_init(&pk, packet, 3, MISSION_TIME_MS);
+    accel = packer_add(&pk, DATA_ACCEL_REL, MISSION_TIME_MS);
+    TEST_ASSERT_NOT_NULL(accel);
+    accel_blk_init(accel, 100, -200, 981);
+    status = packer_add(&pk, DATA_STATUS, MISSION_TIME_MS);
+    TEST_ASSERT_NOT_NULL(status);
+    status_blk_init(status, 2);
+
+    for (int i = 0; i < 4; i++) {
+        run[i].time_offset = -40 + i * 10;
+        run[i].axes[0] = 10 * i;
+        run[i].axes[1] = -10 * i;
+        run[i].axes[2] = 981;
+    }
+    TEST_ASSERT_EQUAL(4, delta_blk_encode(body, sizeof(body), run, 4, &body_len));
+    TEST_ASSERT_EQUAL(0, packer_add_block(&pk, DATA_ANG_VEL_DELTA, 4, body, body_len));
+
+    memset(&decoded, 0, sizeof(decoded));
+    TEST_ASSERT_EQUAL_MESSAGE(0, packet_decode(packet, packer_size(&pk), record_sample, &decoded),
+                              "Packet didn't decode");
+    TEST_ASSERT_EQUAL_MESSAGE(6, decoded.n, "Wrong number of samples");
+
+    TEST_ASSERT_EQUAL_MESSAGE(DATA_ACCEL_REL, decoded.samples[0].type, "Wrong first block type");
+    TEST_ASSERT_EQUAL_MESSAGE(100, field_value(&decoded.samples[0], "x", 0), "Wrong acceleration");
+    TEST_ASSERT_EQUAL_MESSAGE(-200, field_value(&decoded.samples[0], "y", 0), "Wrong acceleration");
+    TEST_ASSERT_EQUAL_MESSAGE(981, field_value(&decoded.samples[0], "z", 0), "Wrong acceleration");
+
+    TEST_ASSERT_EQUAL_MESSAGE(DATA_STATUS, decoded.samples[1].type, "Wrong second block type");
+    TEST_ASSERT_EQUAL_MESSAGE(2, field_value(&decoded.samples[1], "status_code", 0), "Wrong status");
+
+    for (int i = 0; i < 4; i++) {
+        struct decoded_sample *sample = &decoded.samples[2 + i];
+        TEST_ASSERT_EQUAL_MESSAGE(DATA_ANG_VEL_DELTA, sample->type, "Wrong delta block type");
+        TEST_ASSERT_EQUAL_PTR_MESSAGE(block_desc(DATA_ANGULAR_VEL)->body, sample->body,
+                                      "Delta samples should decode to angular velocity");
+        TEST_ASSERT_INT_WITHIN_MESSAGE(1, run[i].time_offset, field_value(sample, "time_offset", 0),
+                                       "Wrong delta sample time");
+        TEST_ASSERT_EQUAL_MESSAGE(run[i].axes[0], field_value(sample, "x", 0), "Wrong delta sample");
+        TEST_ASSERT_EQUAL_MESSAGE(run[i].axes[1], field_value(sample, "y", 0), "Wrong delta sample");
+        TEST_ASSERT_EQUAL_MESSAGE(run[i].axes[2], field_value(sample, "z", 0), "Wrong delta sample");
+    }
+}
+
+static void test_blocks__malformed(void) {
+    struct packer pk;
+    size_t len;
+
+    packer_init(&pk, packet, 0, MISSION_TIME_MS);
+    TEST_ASSERT_NOT_NULL(packer_add(&pk, DATA_LAT_LONG, MISSION_TIME_MS));
+    len = packer_size(&pk);
+
+    memset(&decoded, 0, sizeof(decoded));
+    TEST_ASSERT_EQUAL_MESSAGE(-EINVAL, packet_decode(packet, len - 1, record_sample, &decoded),
+                              "Truncated packet was decoded");
+    TEST_ASSERT_EQUAL_MESSAGE(-EINVAL, packet_decode(packet, len + 1, record_sample, &decoded),
+                              "Extra bytes weren't noticed");
+    TEST_ASSERT_EQUAL_MESSAGE(1, packet_decode(packet, len, stop_decoding, NULL),
+                              "Callback's return wasn't passed on");
+
+    ((blk_hdr_t *)(packet + sizeof(pkt_hdr_t)))->type = DATA_RES_ABOVE;
+    TEST_ASSERT_EQUAL_MESSAGE(-EINVAL, packet_decode(packet, len, record_sample, &decoded),
+                              "Unknown block type was decoded");
+}
+
+void test_blocks(void) {
+    RUN_TEST(test_blocks__table_matches_structs);
+    RUN_TEST(test_blocks__field_values);
+    RUN_TEST(test_blocks__round_trip);
+    RUN_TEST(test_blocks__malformed);
+}
@@ -0,0 +1,60 @@
+#include <nuttx/config.h>
+#include <testing/unity.h>
+
+#include "../telemetry/src/packets/buffering.h"
+
+static packet_buffer_t buffer;
+
+/* Tests */
+
+static void test_buffering__depth_counts_full(void) {
+    TEST_ASSERT_EQUAL(0, packet_buffer_init(&buffer));
+    TEST_ASSERT_EQUAL_MESSAGE(0, packet_buffer_depth(&buffer), "A new buffer has full packets");
+
+    packet_node_t *node = packet_buffer_get_empty(&buffer);
+    TEST_ASSERT_NOT_NULL(node);
+    packet_buffer_put_full(&buffer, node);
+    TEST_ASSERT_EQUAL_MESSAGE(1, packet_buffer_depth(&buffer), "The full packet wasn't queued");
+
+    packet_buffer_put_empty(&buffer, packet_buffer_get_full(&buffer));
+    TEST_ASSERT_EQUAL_MESSAGE(0, packet_buffer_depth(&buffer), "The sent packet is still queued");
+    TEST_ASSERT_EQUAL(0, packet_buffer_overwrites(&buffer));
+}
+
+static void test_buffering__overwrite_newest(void) {
+    packet_node_t *nodes[PACKET_QUEUE_NUM_BUFFERS];
+
+    TEST_ASSERT_EQUAL(0, packet_buffer_init(&buffer));
+    for (int i = 0; i < PACKET_QUEUE_NUM_BUFFERS; i++) {
+        nodes[i] = packet_buffer_get_empty(&buffer);
+        packet_buffer_put_full(&buffer, nodes[i]);
+    }
+
+    /* With nothing empty, the newest packet is built over so the oldest still goes out first */
+
+    TEST_ASSERT_EQUAL_PTR(nodes[PACKET_QUEUE_NUM_BUFFERS - 1], packet_buffer_get_empty(&buffer));
+    TEST_ASSERT_EQUAL_MESSAGE(1, packet_buffer_overwrites(&buffer), "The overwrite wasn't counted");
+    TEST_ASSERT_EQUAL(PACKET_QUEUE_NUM_BUFFERS - 1, packet_buffer_depth(&buffer));
+    TEST_ASSERT_EQUAL_PTR(nodes[0], packet_buffer_get_full(&buffer));
+}
+
+static void test_buffering__unused_never_overwrites(void) {
+    packet_node_t *nodes[PACKET_QUEUE_NUM_BUFFERS];
+
+    TEST_ASSERT_EQUAL(0, packet_buffer_init(&buffer));
+    for (int i = 0; i < PACKET_QUEUE_NUM_BUFFERS; i++) {
+        nodes[i] = packet_buffer_get_unused(&buffer);
+        TEST_ASSERT_NOT_NULL_MESSAGE(nodes[i], "An empty packet wasn't handed out");
+        packet_buffer_put_full(&buffer, nodes[i]);
+    }
+
+    TEST_ASSERT_NULL_MESSAGE(packet_buffer_get_unused(&buffer), "A full packet was handed out to be overwritten");
+    TEST_ASSERT_EQUAL(0, packet_buffer_overwrites(&buffer));
+    TEST_ASSERT_EQUAL(PACKET_QUEUE_NUM_BUFFERS, packet_buffer_depth(&buffer));
+}
+
+void test_buffering(void) {
+    RUN_TEST(test_buffering__depth_counts_full);
+    RUN_TEST(test_buffering__overwrite_newest);
+    RUN_TEST(test_buffering__unused_never_overwrites);
+}
@@ -0,0 +1,186 @@
+#include <math.h>
+#include <nuttx/config.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <testing/unity.h>
+
+#include "../telemetry/src/transmission/deadband.h"
+
+/* Number of samples in the simulated channel, and how many are handed over at once like a transmit cycle */
+
+#define SIM_SAMPLES 2000
+#define SIM_CYCLE 10
+
+/* Error band and heartbeat used by the tests */
+
+#define BAND 0.5f
+#define HEARTBEAT_MS 2000
+
+/* Spacing of the simulated samples in microseconds */
+
+#define SAMPLE_US 100000
+
+/* A sample of the simulated channel */
+
+struct sim_sample {
+    uint64_t timestamp;
+    float value;
+    int32_t fixed;
+};
+
+static const struct deadband_desc float_desc = {
+    .size = sizeof(struct sim_sample),
+    .n_axes = 1,
+    .type = DEADBAND_FLOAT,
+    .axis_offsets = {offsetof(struct sim_sample, value)},
+    .band = {BAND},
+};
+
+static const struct deadband_desc fixed_desc = {
+    .size = sizeof(struct sim_sample),
+    .n_axes = 1,
+    .type = DEADBAND_INT32,
+    .axis_offsets = {offsetof(struct sim_sample, fixed)},
+    .band = {20},
+};
+
+static struct sim_sample original[SIM_SAMPLES];
+static struct sim_sample sent[SIM_SAMPLES];
+
+/* Helpers */
+
+/* Simulates a channel that sits still with noise, ramps, steps and then drifts slowly */
+static float sim_value(int i) {
+    float noise = 0.2f * (2.0f * rand() / RAND_MAX - 1.0f);
+    if (i < 500) {
+        return 10.0f + noise;
+    } else if (i < 800) {
+        return 10.0f + 0.3f * (i - 500) + noise;
+    } else if (i < 1200) {
+        return 200.0f + 5.0f * sinf(i * 0.05f) + noise;
+    }
+    return 120.0f - 0.01f * (i - 1200) + noise;
+}
+
+/* Compresses the original samples a cycle at a time like the transmit thread, returning how many were sent */
+static int sim_compress(struct deadband *db) {
+    int n_sent = 0;
+    struct sim_sample cycle[SIM_CYCLE];
+
+    for (int i = 0; i < SIM_SAMPLES; i += SIM_CYCLE) {
+        memcpy(cycle, &original[i], sizeof(cycle));
+        int kept = deadband_filter(db, cycle, SIM_CYCLE);
+        TEST_ASSERT_TRUE_MESSAGE(kept <= SIM_CYCLE, "Compression grew the array");
+        memcpy(&sent[n_sent], cycle, kept * sizeof(cycle[0]));
+        n_sent += kept;
+    }
+    return n_sent;
+}
+
+/* Reconstructs a sample by interpolating between the sent samples around it */
+static double reconstruct(int n_sent, uint64_t timestamp, int fixed) {
+    for (int k = 1; k < n_sent; k++) {
+        if (sent[k].timestamp >= timestamp) {
+            double a = fixed ? (double)sent[k - 1].fixed : sent[k - 1].value;
+            double b = fixed ? (double)sent[k].fixed : sent[k].value;
+            double frac = (double)(timestamp - sent[k - 1].timestamp) / (sent[k].timestamp - sent[k - 1].timestamp);
+            return a + frac * (b - a);
+        }
+    }
+    return NAN;
+}
+
+/* Tests */
+
+static void test_deadband__reconstruction_within_band(void) {
+    struct deadband db;
+    double max_error = 0.0;
+    int checked = 0;
+
+    srand(11);
+    for (int i = 0; i < SIM_SAMPLES; i++) {
+        original[i] = (struct sim_sample){.timestamp = 1000000 + (uint64_t)i * SAMPLE_US, .value = sim_value(i)};
+    }
+
+    TEST_ASSERT_EQUAL_MESSAGE(0, deadband_init(&db, &float_desc, HEARTBEAT_MS), "Failed to initialize");
+    int n_sent = sim_compress(&db);
+
+    /* Everything up to the last sent sample can be reconstructed, the rest is still held back */
+
+    for (int i = 0; i < SIM_SAMPLES && original[i].timestamp <= sent[n_sent - 1].timestamp; i++) {
+        double error = fabs(reconstruct(n_sent, original[i].timestamp, 0) - original[i].value);
+        max_error = error > max_error ? error : max_error;
+        checked++;
+    }
+
+    TEST_ASSERT_GREATER_THAN_MESSAGE(SIM_SAMPLES - HEARTBEAT_MS * 1000 / SAMPLE_US - 1, checked,
+                                     "Held back longer than a heartbeat");
+    TEST_ASSERT_TRUE_MESSAGE(max_error <= BAND + 1e-4, "Reconstruction error outside the band");
+    TEST_ASSERT_LESS_THAN_MESSAGE(SIM_SAMPLES / 3, n_sent, "Slow channel wasn't compressed");
+    TEST_ASSERT_EQUAL_MESSAGE(n_sent, db.kept, "Kept count doesn't match the samples sent");
+}
+
+static void test_deadband__heartbeat(void) {
+    struct deadband db;
+
+    for (int i = 0; i < SIM_SAMPLES; i++) {
+        original[i] = (struct sim_sample){.timestamp = (uint64_t)i * SAMPLE_US, .value = 3.0f};
+    }
+
+    deadband_init(&db, &float_desc, HEARTBEAT_MS);
+    int n_sent = sim_compress(&db);
+
+    for (int k = 1; k < n_sent; k++) {
+        TEST_ASSERT_TRUE_MESSAGE(sent[k].timestamp - sent[k - 1].timestamp <= HEARTBEAT_MS * 1000 + SAMPLE_US,
+                                 "Steady channel went quiet for longer than a heartbeat");
+    }
+    TEST_ASSERT_GREATER_THAN_MESSAGE(SIM_SAMPLES * SAMPLE_US / 1000 / HEARTBEAT_MS - 2, n_sent,
+                                     "Steady channel wasn't sent every heartbeat");
+}
+
+static void test_deadband__fixed_point_coordinates(void) {
+    struct deadband db;
+    double max_error = 0.0;
+
+    /* A receiver near 45 degrees north drifting a few metres, too precise for single precision floats */
+
+    srand(5);
+    for (int i = 0; i < SIM_SAMPLES; i++) {
+        original[i] = (struct sim_sample){.timestamp = (uint64_t)(i + 1) * SAMPLE_US,
+                                          .fixed = 450000000 + i / 4 + rand() % 15};
+    }
+
+    deadband_init(&db, &fixed_desc, HEARTBEAT_MS);
+    int n_sent = sim_compress(&db);
+    for (int i = 0; i < SIM_SAMPLES && original[i].timestamp <= sent[n_sent - 1].timestamp; i++) {
+        double error = fabs(reconstruct(n_sent, original[i].timestamp, 1) - original[i].fixed);
+        max_error = error > max_error ? error : max_error;
+    }
+
+    TEST_ASSERT_TRUE_MESSAGE(max_error <= 20.0, "Reconstruction error outside the band");
+    TEST_ASSERT_LESS_THAN_MESSAGE(SIM_SAMPLES / 2, n_sent, "Coordinates weren't compressed");
+}
+
+static void test_deadband__out_of_order_dropped(void) {
+    struct deadband db;
+    struct sim_sample samples[] = {
+        {.timestamp = 1000, .value = 1.0f},
+        {.timestamp = 2000, .value = 1.0f},
+        {.timestamp = 1500, .value = 50.0f},
+        {.timestamp = 3000, .value = 1.0f},
+    };
+
+    deadband_init(&db, &float_desc, HEARTBEAT_MS);
+    int kept = deadband_filter(&db, samples, 4);
+    TEST_ASSERT_EQUAL_MESSAGE(1, kept, "Only the first sample should be sent so far");
+    TEST_ASSERT_EQUAL_MESSAGE(1000, samples[0].timestamp, "First sample wasn't sent");
+    TEST_ASSERT_EQUAL_MESSAGE(2, db.dropped, "Out of order sample wasn't dropped");
+}
+
+void test_deadband(void) {
+    RUN_TEST(test_deadband__reconstruction_within_band);
+    RUN_TEST(test_deadband__heartbeat);
+    RUN_TEST(test_deadband__fixed_point_coordinates);
+    RUN_TEST(test_deadband__out_of_order_dropped);
+}
@@ -0,0 +1,528 @@
+#include <math.h>
+#include <nuttx/config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <testing/unity.h>
+#include <time.h>
+
+#include "../telemetry/src/collection/decimator.h"
+
+/* Window size, length in windows and batch size of the reference comparisons, the batch doesn't divide the window */
+
+#define REF_WINDOW 50
+#define REF_WINDOWS 8
+#define REF_BATCH 7
+#define REF_SAMPLES (REF_WINDOW * REF_WINDOWS)
+
+/* Units per m/s^2 the fixed point comparison converts samples to, those of an acceleration block */
+
+#define REF_FIXED_SCALE 100.0f
+
+/* Times the benchmarks run through the reference data, so each times enough samples to measure while keeping the data
+ * small enough for the target. Samples are passed to the decimator in batches like those from orb_copy_multi. */
+
+#define BENCH_ROUNDS 250
+#define BENCH_BATCH 32
+
+/* Window size and length in windows of the coordinate test, 10Hz GNSS downsampled to 1Hz */
+
+#define COORD_WINDOW 10
+#define COORD_WINDOWS 200
+
+/* Window size, length in windows and batch size of the aliasing test signal */
+
+#define ALIAS_WINDOW 20
+#define ALIAS_WINDOWS 40
+#define ALIAS_BATCH 32
+
+/* Helpers */
+
+/* Feeds columns of samples to a decimator in batches, collecting an output for every full window
+ *
+ * @return The number of outputs collected
+ */
+static size_t run_decimator(struct decimator *dec, float *const samples[], size_t n, size_t batch,
+                            float outputs[][DECIMATOR_MAX_AXES]) {
+    const float *cols[DECIMATOR_MAX_AXES];
+    size_t n_outputs = 0;
+
+    for (size_t i = 0; i < n; i += batch) {
+        size_t batch_n = n - i < batch ? n - i : batch;
+        size_t consumed = 0;
+        while (consumed < batch_n) {
+            for (int a = 0; a < dec->n_axes; a++) {
+                cols[a] = samples[a] + i + consumed;
+            }
+            consumed += decimator_add_block(dec, cols, batch_n - consumed);
+            if (decimator_full(dec)) {
+                decimator_result(dec, outputs[n_outputs++]);
+            }
+        }
+    }
+    return n_outputs;
+}
+
+/* Feeds columns of integer samples to a fixed point decimator in batches, collecting an output for every full window
+ *
+ * @return The number of outputs collected
+ */
+static size_t run_decimator_fixed(struct decimator *dec, int32_t *const samples[], size_t n, size_t batch,
+                                  int32_t outputs[][DECIMATOR_MAX_AXES]) {
+    const int32_t *cols[DECIMATOR_MAX_AXES];
+    size_t n_outputs = 0;
+
+    for (size_t i = 0; i < n; i += batch) {
+        size_t batch_n = n - i < batch ? n - i : batch;
+        size_t consumed = 0;
+        while (consumed < batch_n) {
+            for (int a = 0; a < dec->n_axes; a++) {
+                cols[a] = samples[a] + i + consumed;
+            }
+            consumed += decimator_add_block_fixed(dec, cols, batch_n - consumed);
+            if (decimator_full(dec)) {
+                decimator_result_fixed(dec, outputs[n_outputs++]);
+            }
+        }
+    }
+    return n_outputs;
+}
+
+/* Simulated accelerometer data for the reference comparisons, in m/s^2 */
+
+static float ref_samples[DECIMATOR_MAX_AXES][REF_SAMPLES];
+
+/* Fills ref_samples with noise around 1 g on the z axis */
+static void make_accel_samples(void) {
+    srand(1234);
+    for (int a = 0; a < DECIMATOR_MAX_AXES; a++) {
+        for (int i = 0; i < REF_SAMPLES; i++) {
+            ref_samples[a][i] = (a == 2 ? 9.80665f : 0.0f) + 20.0f * ((float)rand() / RAND_MAX - 0.5f);
+        }
+    }
+}
+
+/* The time between two clock readings in nanoseconds */
+static double elapsed_ns(struct timespec *start, struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+/* Tests */
+
+static void test_decimator_mean__averages_each_axis(void) {
+    struct decimator dec;
+    float x[] = {1.0f, 2.0f, 3.0f, 4.0f};
+    float y[] = {-1.0f, -2.0f, -3.0f, -4.0f};
+    float z[] = {10.0f, 10.0f, 10.0f, 10.0f};
+    const float *cols[] = {x, y, z};
+    float out[3];
+
+    decimator_init(&dec, DECIMATOR_MEAN, 3, 4);
+    TEST_ASSERT_EQUAL_MESSAGE(4, decimator_add_block(&dec, cols, 4), "Should consume the whole window");
+    TEST_ASSERT_TRUE_MESSAGE(decimator_full(&dec), "Window should be full");
+
+    decimator_result(&dec, out);
+    TEST_ASSERT_EQUAL_FLOAT_MESSAGE(2.5f, out[0], "Wrong mean for x");
+    TEST_ASSERT_EQUAL_FLOAT_MESSAGE(-2.5f, out[1], "Wrong mean for y");
+    TEST_ASSERT_EQUAL_FLOAT_MESSAGE(10.0f, out[2], "Wrong mean for z");
+    TEST_ASSERT_FALSE_MESSAGE(decimator_full(&dec), "Window should be empty after getting the result");
+}
+
+static void test_decimator_block__stops_at_window_end(void) {
+    struct decimator dec;
+    float x[] = {1.0f, 3.0f, 5.0f, 100.0f, 100.0f};
+    const float *cols[] = {x};
+    float out;
+
+    decimator_init(&dec, DECIMATOR_MEAN, 1, 3);
+    TEST_ASSERT_EQUAL_MESSAGE(3, decimator_add_block(&dec, cols, 5), "Should only consume up to the window end");
+
+    decimator_result(&dec, &out);
+    TEST_ASSERT_EQUAL_FLOAT_MESSAGE(3.0f, out, "Samples past the window end were included");
+}
+
+static void test_decimator_block__window_spans_blocks(void) {
+    struct decimator dec;
+    float first[] = {2.0f, 4.0f};
+    float second[] = {6.0f, 8.0f};
+    const float *first_cols[] = {first};
+    const float *second_cols[] = {second};
+    float out;
+
+    decimator_init(&dec, DECIMATOR_MEAN, 1, 4);
+    decimator_add_block(&dec, first_cols, 2);
+    TEST_ASSERT_FALSE_MESSAGE(decimator_full(&dec), "Window should not be full after half the samples");
+    decimator_add_block(&dec, second_cols, 2);
+    TEST_ASSERT_TRUE_MESSAGE(decimator_full(&dec), "Window should be full");
+
+    decimator_result(&dec, &out);
+    TEST_ASSERT_EQUAL_FLOAT_MESSAGE(5.0f, out, "Wrong mean across blocks");
+}
+
+static void test_decimator_set_target__shrinks_current_window(void) {
+    struct decimator dec;
+    float x[] = {1.0f, 2.0f, 3.0f};
+    const float *cols[] = {x};
+    float out;
+
+    decimator_init(&dec, DECIMATOR_MEAN, 1, 10);
+    decimator_add_block(&dec, cols, 3);
+    decimator_set_target(&dec, 2);
+    TEST_ASSERT_TRUE_MESSAGE(decimator_full(&dec), "Window should be full after shrinking the target");
+
+    decimator_result(&dec, &out);
+    TEST_ASSERT_EQUAL_FLOAT_MESSAGE(2.0f, out, "Mean should use all samples in the window");
+}
+
+static void test_decimator_welford__matches_mean(void) {
+    struct decimator mean;
+    struct decimator welford;
+    float x[] = {0.5f, -3.25f, 7.0f, 1.0f, 2.0f, 9.5f, -1.0f};
+    const float *cols[] = {x};
+    float mean_out;
+    float welford_out;
+
+    decimator_init(&mean, DECIMATOR_MEAN, 1, 7);
+    decimator_init(&welford, DECIMATOR_WELFORD, 1, 7);
+    decimator_add_block(&mean, cols, 7);
+    decimator_add_block(&welford, cols, 7);
+    decimator_result(&mean, &mean_out);
+    decimator_result(&welford, &welford_out);
+
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(1e-5f, welford_out, mean_out, "Welford and summed means differ");
+}
+
+static void test_decimator_fixed__rounds_to_nearest(void) {
+    struct decimator dec;
+    int32_t x[] = {1, 2, 2, 1, 2, 2};
+    int32_t y[] = {-1, -2, -2, -1, -2, -2};
+    int32_t z[] = {4, 4, 4, 4, 4, 5};
+    const int32_t *cols[] = {x, y, z};
+    int32_t out[3];
+
+    decimator_init(&dec, DECIMATOR_FIXED, 3, 2);
+    decimator_add_block_fixed(&dec, cols, 2);
+    decimator_result_fixed(&dec, out);
+    TEST_ASSERT_EQUAL_MESSAGE(2, out[0], "Halves should round away from zero");
+    TEST_ASSERT_EQUAL_MESSAGE(-2, out[1], "Negative halves should round away from zero");
+    TEST_ASSERT_EQUAL_MESSAGE(4, out[2], "Wrong mean");
+
+    decimator_set_target(&dec, 4);
+    cols[0] = &x[2];
+    cols[1] = &y[2];
+    cols[2] = &z[2];
+    TEST_ASSERT_EQUAL_MESSAGE(4, decimator_add_block_fixed(&dec, cols, 4), "Should consume the whole window");
+    decimator_result_fixed(&dec, out);
+    TEST_ASSERT_EQUAL_MESSAGE(2, out[0], "1.75 should round to 2");
+    TEST_ASSERT_EQUAL_MESSAGE(-2, out[1], "-1.75 should round to -2");
+    TEST_ASSERT_EQUAL_MESSAGE(4, out[2], "4.25 should round to 4");
+}
+
+/* Averages noisy coordinates in the units of a coordinate block, comparing the fixed point path with averaging the
+ * uORB floats and converting afterwards, like the downsampler used to. Both start from float coordinates, so the
+ * reference is the exact mean of what the float path was given. */
+static void test_decimator_fixed__exact_coordinates(void) {
+    static float degrees[2][COORD_WINDOW * COORD_WINDOWS];
+    static int32_t units[2][COORD_WINDOW * COORD_WINDOWS];
+    static int32_t fixed_out[COORD_WINDOWS][DECIMATOR_MAX_AXES];
+    static float float_out[COORD_WINDOWS][DECIMATOR_MAX_AXES];
+    float *const float_cols[] = {degrees[0], degrees[1]};
+    int32_t *const fixed_cols[] = {units[0], units[1]};
+    const double origin[] = {49.2606, -123.2460};
+    struct decimator dec;
+    int64_t fixed_worst = 0;
+    int64_t float_worst = 0;
+
+    srand(4321);
+    for (int a = 0; a < 2; a++) {
+        for (int i = 0; i < COORD_WINDOW * COORD_WINDOWS; i++) {
+            degrees[a][i] = origin[a] + 2e-5 * ((double)rand() / RAND_MAX - 0.5);
+            units[a][i] = lround(degrees[a][i] * 1e7);
+        }
+    }
+
+    decimator_init(&dec, DECIMATOR_FIXED, 2, COORD_WINDOW);
+    TEST_ASSERT_EQUAL(COORD_WINDOWS,
+                      run_decimator_fixed(&dec, fixed_cols, COORD_WINDOW * COORD_WINDOWS, 7, fixed_out));
+    decimator_init(&dec, DECIMATOR_MEAN, 2, COORD_WINDOW);
+    TEST_ASSERT_EQUAL(COORD_WINDOWS, run_decimator(&dec, float_cols, COORD_WINDOW * COORD_WINDOWS, 7, float_out));
+
+    for (int w = 0; w < COORD_WINDOWS; w++) {
+        for (int a = 0; a < 2; a++) {
+            int64_t sum = 0;
+            for (int k = 0; k < COORD_WINDOW; k++) {
+                sum += units[a][w * COORD_WINDOW + k];
+            }
+            int64_t reference = llround((double)sum / COORD_WINDOW);
+            int64_t fixed_error = llabs(fixed_out[w][a] - reference);
+            int64_t float_error = llabs((int32_t)(1E7f * float_out[w][a]) - reference);
+            fixed_worst = fixed_error > fixed_worst ? fixed_error : fixed_worst;
+            float_worst = float_error > float_worst ? float_error : float_worst;
+        }
+    }
+
+    TEST_ASSERT_EQUAL_MESSAGE(0, fixed_worst, "Fixed point coordinate means aren't exact");
+    TEST_ASSERT_GREATER_THAN_MESSAGE(fixed_worst, float_worst, "Float means should lose coordinate resolution");
+}
+
+static void test_decimator_cic__passes_dc(void) {
+    struct decimator dec;
+    float x[8];
+    float y[8];
+    const float *cols[] = {x, y};
+    float out[2];
+
+    for (int i = 0; i < 8; i++) {
+        x[i] = 9.80665f;
+        y[i] = -1.5f;
+    }
+
+    /* The gain lane normalizes the first outputs too, while the filter's history is still empty */
+
+    decimator_init(&dec, DECIMATOR_CIC, 2, 4);
+    for (int w = 0; w < 2; w++) {
+        decimator_add_block(&dec, cols, 4);
+        TEST_ASSERT_TRUE_MESSAGE(decimator_full(&dec), "Window should be full");
+        decimator_result(&dec, out);
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(1e-4f, 9.80665f, out[0], "Constant input changed on x");
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(1e-4f, -1.5f, out[1], "Constant input changed on y");
+    }
+
+    /* A different window size should not change the DC gain */
+
+    decimator_set_target(&dec, 7);
+    decimator_add_block(&dec, cols, 7);
+    decimator_result(&dec, out);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(1e-4f, 9.80665f, out[0], "DC gain changed with the window size");
+}
+
+static void test_decimator_cic__limits_window(void) {
+    struct decimator dec;
+
+    decimator_init(&dec, DECIMATOR_CIC, 1, DECIMATOR_CIC_MAX_WINDOW + 1);
+    TEST_ASSERT_EQUAL_MESSAGE(DECIMATOR_CIC_MAX_WINDOW, dec.target_n, "Window could overflow the CIC registers");
+}
+
+static void test_decimator_envelope__tracks_range_of_window(void) {
+    struct decimator dec;
+    struct decimator_envelope env;
+    float x[] = {1.0f, -4.0f, 2.0f, 3.0f, 50.0f, 0.0f};
+    float y[] = {-1.0f, -1.0f, -1.0f, -1.0f, -1.0f, -1.0f};
+    const float *cols[] = {x, y};
+    float out[2];
+
+    decimator_init(&dec, DECIMATOR_MEAN, 2, 4);
+    decimator_set_envelope(&dec, 1);
+    decimator_add_block(&dec, cols, 2);
+    decimator_add_block(&dec, (const float *[]){x + 2, y + 2}, 2);
+    decimator_get_envelope(&dec, &env);
+    decimator_result(&dec, out);
+
+    TEST_ASSERT_EQUAL_FLOAT_MESSAGE(-4.0f, env.min[0], "Wrong minimum for x");
+    TEST_ASSERT_EQUAL_FLOAT_MESSAGE(3.0f, env.max[0], "Wrong maximum for x");
+    TEST_ASSERT_EQUAL_FLOAT_MESSAGE(-1.0f, env.min[1], "Wrong minimum for y");
+    TEST_ASSERT_EQUAL_FLOAT_MESSAGE(-1.0f, env.max[1], "Wrong maximum for y");
+    TEST_ASSERT_EQUAL_FLOAT_MESSAGE(0.5f, out[0], "Tracking the envelope changed the mean");
+
+    /* A shock in the next window shouldn't be bounded by the previous one */
+
+    decimator_add_block(&dec, (const float *[]){x + 4, y + 4}, 2);
+    decimator_get_envelope(&dec, &env);
+    TEST_ASSERT_EQUAL_FLOAT_MESSAGE(0.0f, env.min[0], "Minimum carried over from the last window");
+    TEST_ASSERT_EQUAL_FLOAT_MESSAGE(50.0f, env.max[0], "Peak was lost");
+}
+
+/* Feeds a tone at one and a half times the output rate, which a boxcar mean only attenuates to its first sidelobe, and
+ * checks the CIC output doesn't contain the alias */
+static void test_decimator_cic__attenuates_aliases(void) {
+    static float x[ALIAS_WINDOW * ALIAS_WINDOWS];
+    float *const cols[] = {x};
+    float outputs[ALIAS_WINDOWS][DECIMATOR_MAX_AXES];
+    enum decimator_mode_e modes[] = {DECIMATOR_MEAN, DECIMATOR_CIC};
+    float worst[2] = {0};
+    struct decimator dec;
+
+    for (int i = 0; i < ALIAS_WINDOW * ALIAS_WINDOWS; i++) {
+        x[i] = sinf(2.0f * M_PI * 1.5f * i / ALIAS_WINDOW);
+    }
+
+    for (int m = 0; m < 2; m++) {
+        decimator_init(&dec, modes[m], 1, ALIAS_WINDOW);
+        run_decimator(&dec, cols, ALIAS_WINDOW * ALIAS_WINDOWS, ALIAS_BATCH, outputs);
+
+        /* Skip the windows where the filter's history is still filling */
+
+        for (int w = DECIMATOR_CIC_ORDER; w < ALIAS_WINDOWS; w++) {
+            if (fabs(outputs[w][0]) > worst[m]) {
+                worst[m] = fabs(outputs[w][0]);
+            }
+        }
+    }
+
+    TEST_ASSERT_GREATER_THAN_MESSAGE(0.1f, worst[0], "Tone should alias through a boxcar mean");
+    TEST_ASSERT_LESS_THAN_MESSAGE(0.05f, worst[1], "Tone aliased through the CIC decimator");
+}
+
+/* Compares the summed mean and the Welford mean on simulated accelerometer data with a double precision reference,
+ * fed in batches that don't divide the window */
+static void test_decimator_mean__matches_reference(void) {
+    static float outputs[2][REF_WINDOWS][DECIMATOR_MAX_AXES];
+    float *const cols[DECIMATOR_MAX_AXES] = {ref_samples[0], ref_samples[1], ref_samples[2]};
+    enum decimator_mode_e modes[] = {DECIMATOR_MEAN, DECIMATOR_WELFORD};
+    struct decimator dec;
+    float worst_error[2] = {0};
+
+    make_accel_samples();
+    for (int m = 0; m < 2; m++) {
+        decimator_init(&dec, modes[m], DECIMATOR_MAX_AXES, REF_WINDOW);
+        TEST_ASSERT_EQUAL_MESSAGE(REF_WINDOWS, run_decimator(&dec, cols, REF_SAMPLES, REF_BATCH, outputs[m]),
+                                  "Wrong number of windows");
+    }
+
+    for (int w = 0; w < REF_WINDOWS; w++) {
+        for (int a = 0; a < DECIMATOR_MAX_AXES; a++) {
+            double reference = 0;
+            for (int k = 0; k < REF_WINDOW; k++) {
+                reference += ref_samples[a][w * REF_WINDOW + k];
+            }
+            reference /= REF_WINDOW;
+            for (int m = 0; m < 2; m++) {
+                float error = fabs(outputs[m][w][a] - reference);
+                if (error > worst_error[m]) {
+                    worst_error[m] = error;
+                }
+            }
+        }
+    }
+
+    TEST_ASSERT_LESS_THAN_MESSAGE(1e-4f, worst_error[0], "Summed mean is not accurate");
+    TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(worst_error[1] + 1e-5f, worst_error[0],
+                                      "Summed mean is less accurate than Welford");
+}
+
+/* Benchmarks the summed mean against the Welford mean on the reference data, with the CIC decimator for comparison.
+ * Accuracy is checked by test_decimator_mean__matches_reference. */
+static void test_decimator_benchmark__mean_vs_welford(void) {
+    static float outputs[REF_WINDOWS][DECIMATOR_MAX_AXES];
+    float *const cols[DECIMATOR_MAX_AXES] = {ref_samples[0], ref_samples[1], ref_samples[2]};
+    enum decimator_mode_e modes[] = {DECIMATOR_MEAN, DECIMATOR_WELFORD, DECIMATOR_CIC};
+    struct decimator dec;
+    struct timespec start;
+    struct timespec end;
+    double ns[3];
+    char msg[100];
+
+    make_accel_samples();
+    for (int m = 0; m < 3; m++) {
+        decimator_init(&dec, modes[m], DECIMATOR_MAX_AXES, REF_WINDOW);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int r = 0; r < BENCH_ROUNDS; r++) {
+            TEST_ASSERT_EQUAL_MESSAGE(REF_WINDOWS, run_decimator(&dec, cols, REF_SAMPLES, BENCH_BATCH, outputs),
+                                      "Wrong number of windows");
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        ns[m] = elapsed_ns(&start, &end) / ((double)REF_SAMPLES * BENCH_ROUNDS);
+    }
+
+    snprintf(msg, sizeof(msg), "ns/sample: summed mean %.2f, Welford %.2f (%.2fx), CIC order %d %.2f",
+             ns[0], ns[1], ns[1] / ns[0], DECIMATOR_CIC_ORDER, ns[2]);
+    TEST_MESSAGE(msg);
+}
+
+/* Compares the fixed point path, including converting each float sample to an integer like the downsampler does, with
+ * the summed float mean on the same data. They must agree to within half a unit from rounding the mean, plus the
+ * average rounding error of the samples, which is much smaller. */
+static void test_decimator_fixed__matches_float(void) {
+    static int32_t units[DECIMATOR_MAX_AXES][REF_SAMPLES];
+    static float float_out[REF_WINDOWS][DECIMATOR_MAX_AXES];
+    static int32_t fixed_out[REF_WINDOWS][DECIMATOR_MAX_AXES];
+    float *const float_cols[DECIMATOR_MAX_AXES] = {ref_samples[0], ref_samples[1], ref_samples[2]};
+    int32_t *const fixed_cols[DECIMATOR_MAX_AXES] = {units[0], units[1], units[2]};
+    struct decimator dec;
+
+    make_accel_samples();
+    for (int a = 0; a < DECIMATOR_MAX_AXES; a++) {
+        for (int i = 0; i < REF_SAMPLES; i++) {
+            units[a][i] = lroundf(ref_samples[a][i] * REF_FIXED_SCALE);
+        }
+    }
+
+    decimator_init(&dec, DECIMATOR_MEAN, DECIMATOR_MAX_AXES, REF_WINDOW);
+    TEST_ASSERT_EQUAL(REF_WINDOWS, run_decimator(&dec, float_cols, REF_SAMPLES, REF_BATCH, float_out));
+    decimator_init(&dec, DECIMATOR_FIXED, DECIMATOR_MAX_AXES, REF_WINDOW);
+    TEST_ASSERT_EQUAL(REF_WINDOWS, run_decimator_fixed(&dec, fixed_cols, REF_SAMPLES, REF_BATCH, fixed_out));
+
+    for (int w = 0; w < REF_WINDOWS; w++) {
+        for (int a = 0; a < DECIMATOR_MAX_AXES; a++) {
+            TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.6f, float_out[w][a] * REF_FIXED_SCALE, fixed_out[w][a],
+                                             "Fixed point and float means disagree");
+        }
+    }
+}
+
+/* Benchmarks the fixed point path, including converting each float sample to an integer like the downsampler does,
+ * against the summed float mean on the reference data. Agreement is checked by test_decimator_fixed__matches_float. */
+static void test_decimator_benchmark__fixed_vs_float(void) {
+    static int32_t units[DECIMATOR_MAX_AXES][REF_SAMPLES];
+    static float float_out[REF_WINDOWS][DECIMATOR_MAX_AXES];
+    static int32_t fixed_out[REF_WINDOWS][DECIMATOR_MAX_AXES];
+    float *const float_cols[DECIMATOR_MAX_AXES] = {ref_samples[0], ref_samples[1], ref_samples[2]};
+    int32_t *const fixed_cols[DECIMATOR_MAX_AXES] = {units[0], units[1], units[2]};
+    struct decimator dec;
+    struct timespec start;
+    struct timespec end;
+    double float_ns;
+    double fixed_ns;
+    double convert_ns;
+    char msg[100];
+
+    make_accel_samples();
+
+    decimator_init(&dec, DECIMATOR_MEAN, DECIMATOR_MAX_AXES, REF_WINDOW);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        TEST_ASSERT_EQUAL(REF_WINDOWS, run_decimator(&dec, float_cols, REF_SAMPLES, BENCH_BATCH, float_out));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    float_ns = elapsed_ns(&start, &end) / ((double)REF_SAMPLES * BENCH_ROUNDS);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int a = 0; a < DECIMATOR_MAX_AXES; a++) {
+            for (int i = 0; i < REF_SAMPLES; i++) {
+                units[a][i] = lroundf(ref_samples[a][i] * REF_FIXED_SCALE);
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    convert_ns = elapsed_ns(&start, &end) / ((double)REF_SAMPLES * BENCH_ROUNDS);
+
+    decimator_init(&dec, DECIMATOR_FIXED, DECIMATOR_MAX_AXES, REF_WINDOW);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        TEST_ASSERT_EQUAL(REF_WINDOWS, run_decimator_fixed(&dec, fixed_cols, REF_SAMPLES, BENCH_BATCH, fixed_out));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fixed_ns = elapsed_ns(&start, &end) / ((double)REF_SAMPLES * BENCH_ROUNDS);
+
+    snprintf(msg, sizeof(msg), "ns/sample: float mean %.2f, fixed point %.2f plus %.2f converting", float_ns,
+             fixed_ns, convert_ns);
+    TEST_MESSAGE(msg);
+}
+
+void test_decimator(void) {
+    RUN_TEST(test_decimator_mean__averages_each_axis);
+    RUN_TEST(test_decimator_block__stops_at_window_end);
+    RUN_TEST(test_decimator_block__window_spans_blocks);
+    RUN_TEST(test_decimator_set_target__shrinks_current_window);
+    RUN_TEST(test_decimator_welford__matches_mean);
+    RUN_TEST(test_decimator_mean__matches_reference);
+    RUN_TEST(test_decimator_fixed__rounds_to_nearest);
+    RUN_TEST(test_decimator_fixed__exact_coordinates);
+    RUN_TEST(test_decimator_fixed__matches_float);
+    RUN_TEST(test_decimator_envelope__tracks_range_of_window);
+    RUN_TEST(test_decimator_cic__passes_dc);
+    RUN_TEST(test_decimator_cic__limits_window);
+    RUN_TEST(test_decimator_cic__attenuates_aliases);
+    RUN_TEST(test_decimator_benchmark__mean_vs_welford);
+    RUN_TEST(test_decimator_benchmark__fixed_vs_float);
+}
@@ -0,0 +1,131 @@
+#include <errno.h>
+#include <nuttx/config.h>
+#include <testing/unity.h>
+
+#include "../telemetry/src/packets/packets.h"
+
+/* The number of samples in a test run */
+
+#define RUN_SAMPLES 20
+
+static struct axes_blk_t samples[RUN_SAMPLES];
+static struct axes_blk_t decoded[RUN_SAMPLES];
+static uint8_t body[PACKET_MAX_SIZE];
+
+/* Helpers */
+
+/* Fill the samples with a slow ramp on a regular period, with time offsets rounded down to the millisecond */
+static void make_run(double period_ms, int16_t step) {
+    for (int i = 0; i < RUN_SAMPLES; i++) {
+        samples[i].time_offset = -1000 + (int16_t)(i * period_ms);
+        samples[i].axes[0] = 100 + i * step;
+        samples[i].axes[1] = -981 - i * step / 2;
+        samples[i].axes[2] = (i % 2) * step;
+    }
+}
+
+/* Check the first `n` samples decoded the same as they were encoded */
+static void assert_decoded(int n) {
+    for (int i = 0; i < n; i++) {
+        TEST_ASSERT_INT_WITHIN_MESSAGE(1, samples[i].time_offset, decoded[i].time_offset, "Sample time is off");
+        for (int a = 0; a < 3; a++) {
+            TEST_ASSERT_EQUAL_MESSAGE(samples[i].axes[a], decoded[i].axes[a], "Sample value changed");
+        }
+    }
+}
+
+/* Tests */
+
+static void test_delta_blk__round_trip(void) {
+    size_t len;
+
+    make_run(70, 5);
+    TEST_ASSERT_EQUAL_MESSAGE(RUN_SAMPLES, delta_blk_encode(body, sizeof(body), samples, RUN_SAMPLES, &len),
+                              "A regular run should fit in one block");
+    TEST_ASSERT_EQUAL_MESSAGE(len, delta_blk_decode(body, len, RUN_SAMPLES, decoded), "Wrong decoded length");
+    assert_decoded(RUN_SAMPLES);
+}
+
+static void test_delta_blk__compresses_slow_samples(void) {
+    size_t len;
+
+    make_run(70, 5);
+    delta_blk_encode(body, sizeof(body), samples, RUN_SAMPLES, &len);
+    TEST_ASSERT_EQUAL_MESSAGE(sizeof(struct delta_blk_t) + (RUN_SAMPLES - 1) * 3, len,
+                              "Small changes should take a byte per axis");
+    TEST_ASSERT_TRUE_MESSAGE(len * 2 < RUN_SAMPLES * sizeof(struct accel_blk_t),
+                             "Delta blocks should be less than half the size of fixed size blocks");
+}
+
+static void test_delta_blk__extreme_values(void) {
+    size_t len;
+
+    make_run(70, 0);
+    for (int i = 0; i < RUN_SAMPLES; i++) {
+        samples[i].axes[0] = i % 2 ? INT16_MAX : INT16_MIN;
+        samples[i].axes[1] = i % 2 ? INT16_MIN : INT16_MAX;
+    }
+
+    int n = delta_blk_encode(body, sizeof(body), samples, RUN_SAMPLES, &len);
+    TEST_ASSERT_EQUAL_MESSAGE(RUN_SAMPLES, n, "Full scale changes should still be encoded");
+    TEST_ASSERT_EQUAL_MESSAGE(len, delta_blk_decode(body, len, n, decoded), "Wrong decoded length");
+    assert_decoded(n);
+}
+
+static void test_delta_blk__fractional_period(void) {
+    size_t len;
+
+    /* Rounding the time offsets to milliseconds leaves the period uneven by a millisecond */
+
+    make_run(160.0 + 1.0 / 3, 5);
+    TEST_ASSERT_EQUAL_MESSAGE(RUN_SAMPLES, delta_blk_encode(body, sizeof(body), samples, RUN_SAMPLES, &len),
+                              "Millisecond rounding shouldn't split the run");
+    delta_blk_decode(body, len, RUN_SAMPLES, decoded);
+    assert_decoded(RUN_SAMPLES);
+}
+
+static void test_delta_blk__irregular_run_splits(void) {
+    size_t len;
+
+    make_run(70, 5);
+    for (int i = RUN_SAMPLES / 2; i < RUN_SAMPLES; i++) {
+        samples[i].time_offset += 500;
+    }
+
+    int n = delta_blk_encode(body, sizeof(body), samples, RUN_SAMPLES, &len);
+    TEST_ASSERT_EQUAL_MESSAGE(RUN_SAMPLES / 2, n, "The block should end at the gap");
+    delta_blk_decode(body, len, n, decoded);
+    assert_decoded(n);
+}
+
+static void test_delta_blk__limited_space(void) {
+    size_t space = sizeof(struct delta_blk_t) + 10;
+    size_t len;
+
+    make_run(70, 5);
+    int n = delta_blk_encode(body, space, samples, RUN_SAMPLES, &len);
+    TEST_ASSERT_EQUAL_MESSAGE(4, n, "Wrong number of samples in the space");
+    TEST_ASSERT_TRUE_MESSAGE(len <= space, "The block grew past its space");
+    TEST_ASSERT_EQUAL_MESSAGE(0, delta_blk_encode(body, sizeof(struct delta_blk_t) - 1, samples, RUN_SAMPLES, &len),
+                              "Nothing should fit without room for the base sample");
+}
+
+static void test_delta_blk__malformed(void) {
+    size_t len;
+
+    make_run(70, 100);
+    int n = delta_blk_encode(body, sizeof(body), samples, RUN_SAMPLES, &len);
+    TEST_ASSERT_EQUAL_MESSAGE(-EINVAL, delta_blk_decode(body, len - 1, n, decoded), "Truncated block was decoded");
+    TEST_ASSERT_EQUAL_MESSAGE(-EINVAL, delta_blk_decode(body, len, n + 1, decoded), "Missing samples weren't noticed");
+    TEST_ASSERT_EQUAL_MESSAGE(-EINVAL, delta_blk_decode(body, len, n - 1, decoded), "Extra bytes weren't noticed");
+}
+
+void test_delta_blk(void) {
+    RUN_TEST(test_delta_blk__round_trip);
+    RUN_TEST(test_delta_blk__compresses_slow_samples);
+    RUN_TEST(test_delta_blk__extreme_values);
+    RUN_TEST(test_delta_blk__fractional_period);
+    RUN_TEST(test_delta_blk__irregular_run_splits);
+    RUN_TEST(test_delta_blk__limited_space);
+    RUN_TEST(test_delta_blk__malformed);
+}
@@ -0,0 +1,73 @@
+#include <nuttx/config.h>
+#include <testing/unity.h>
+
+#include "../telemetry/src/transmission/downlink-profile.h"
+
+/* Bytes of a packet that aren't data blocks: the packet header, and a status and an error block */
+
+#define PACKET_OVERHEAD                                                                                                \
+    (sizeof(pkt_hdr_t) + 2 * sizeof(blk_hdr_t) + sizeof(struct status_blk_t) + sizeof(struct error_blk_t))
+
+/* The resampled IMU channels */
+
+static const enum radio_channel_e imu_channels[] = {RADIO_ACCEL, RADIO_GYRO, RADIO_MAG};
+
+#define NUM_IMU_CHANNELS (sizeof(imu_channels) / sizeof(imu_channels[0]))
+
+/* Tests */
+
+static void test_downlink_profile__fits_in_packet(void) {
+    for (int p = 0; p < ODR_NUM_PROFILES; p++) {
+        for (int ch = 0; ch < RADIO_NUM_CHANNELS; ch++) {
+            TEST_ASSERT_TRUE_MESSAGE(downlink_outputs(ch, p) <= CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ,
+                                     "More outputs than the radio buffer holds");
+        }
+
+        /* Envelopes nearly triple the IMU channels' share, the profiles aren't sized for them */
+
+#if defined(CONFIG_INSPACE_TELEMETRY_DOWNLINK_PROFILES) && !defined(CONFIG_INSPACE_DOWNSAMPLING_ENVELOPE)
+        TEST_ASSERT_TRUE_MESSAGE(downlink_bytes(p) + PACKET_OVERHEAD <= PACKET_MAX_SIZE,
+                                 "A period of outputs doesn't fit in a packet");
+#endif
+    }
+}
+
+static void test_downlink_profile__imu_grids_aligned(void) {
+    for (int p = 0; p < ODR_NUM_PROFILES; p++) {
+        for (int i = 0; i < NUM_IMU_CHANNELS; i++) {
+            for (int j = 0; j < NUM_IMU_CHANNELS; j++) {
+                uint8_t a = downlink_outputs(imu_channels[i], p);
+                uint8_t b = downlink_outputs(imu_channels[j], p);
+                TEST_ASSERT_TRUE_MESSAGE(a < b || a % b == 0, "IMU outputs don't divide each other");
+            }
+        }
+    }
+}
+
+static void test_downlink_profile__phase_emphasis(void) {
+#ifdef CONFIG_INSPACE_TELEMETRY_DOWNLINK_PROFILES
+    TEST_ASSERT_TRUE_MESSAGE(downlink_outputs(RADIO_ACCEL, ODR_PROFILE_ASCENT) >
+                                 downlink_outputs(RADIO_ACCEL, ODR_PROFILE_IDLE),
+                             "Ascent should get more accelerometer data than the pad");
+    TEST_ASSERT_TRUE_MESSAGE(downlink_outputs(RADIO_GNSS, ODR_PROFILE_IDLE) >
+                                 downlink_outputs(RADIO_GNSS, ODR_PROFILE_ASCENT),
+                             "The pad should get more GNSS data than ascent");
+    TEST_ASSERT_TRUE_MESSAGE(downlink_outputs(RADIO_GNSS, ODR_PROFILE_LANDED) >=
+                                 downlink_outputs(RADIO_GNSS, ODR_PROFILE_DESCENT),
+                             "Landed should get the most GNSS data");
+    TEST_ASSERT_TRUE_MESSAGE(downlink_outputs(RADIO_ALT, ODR_PROFILE_DESCENT) >
+                                 downlink_outputs(RADIO_ACCEL, ODR_PROFILE_DESCENT),
+                             "Descent should favour altitude over acceleration");
+#else
+    for (int ch = 0; ch < RADIO_NUM_CHANNELS; ch++) {
+        TEST_ASSERT_EQUAL_MESSAGE(CONFIG_INSPACE_DOWNSAMPLING_TARGET_FREQ, downlink_outputs(ch, ODR_PROFILE_ASCENT),
+                                  "Every channel should get the target without profiles");
+    }
+#endif
+}
+
+void test_downlink_profile(void) {
+    RUN_TEST(test_downlink_profile__fits_in_packet);
+    RUN_TEST(test_downlink_profile__imu_grids_aligned);
+    RUN_TEST(test_downlink_profile__phase_emphasis);
+}
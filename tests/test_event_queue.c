@@ -0,0 +1,120 @@
+#include <nuttx/config.h>
+#include <string.h>
+#include <testing/unity.h>
+
+#include "../telemetry/src/transmission/event-queue.h"
+
+/* A mission time whose events can all be offset from the packet header's timestamp */
+
+#define MISSION_TIME_MS 60000
+
+static uint8_t packet[PACKET_MAX_SIZE];
+static struct event_queue queue;
+static struct block_drops drops;
+
+/* Queue an error message published at the mission time
+ *
+ * @param proc_id The process the error is about
+ */
+static void push_error(enum process_id_e proc_id) {
+    struct error_message error = {
+        .timestamp = MISSION_TIME_MS * 1000ull,
+        .proc_id = proc_id,
+        .error_code = ERROR_PROCESS_DEAD,
+    };
+    event_queue_push_error(&queue, &error);
+}
+
+/* Queue a status message published at the mission time
+ *
+ * @param code The status code
+ */
+static void push_status(enum status_code_e code) {
+    struct status_message status = {.timestamp = MISSION_TIME_MS * 1000ull, .status_code = code};
+    event_queue_push_status(&queue, &status);
+}
+
+/* Tests */
+
+static void test_event_queue__every_event_packed(void) {
+    struct packer pk;
+
+    memset(&drops, 0, sizeof(drops));
+    event_queue_init(&queue, &drops);
+    push_status(STATUS_TELEMETRY_UPDATE_IDLE);
+    push_error(PROC_ID_FUSION);
+    push_status(STATUS_TELEMETRY_UPDATE_AIRBORNE);
+    push_error(PROC_ID_LOGGING);
+    push_status(STATUS_TELEMETRY_UPDATE_ASCENT);
+
+    packer_init(&pk, packet, 0, MISSION_TIME_MS);
+    TEST_ASSERT_EQUAL_MESSAGE(5, event_queue_pack(&queue, &pk), "Not every event was packed");
+
+    blk_hdr_t *errors = (blk_hdr_t *)(packet + sizeof(pkt_hdr_t));
+    blk_hdr_t *statuses = (blk_hdr_t *)(block_body((uint8_t *)errors) + 2 * sizeof(struct error_blk_t));
+    TEST_ASSERT_EQUAL_MESSAGE(2, ((pkt_hdr_t *)packet)->type_count, "Events of a type should share a block");
+    TEST_ASSERT_EQUAL(DATA_ERROR, errors->type);
+    TEST_ASSERT_EQUAL(2, errors->count);
+    TEST_ASSERT_EQUAL(DATA_STATUS, statuses->type);
+    TEST_ASSERT_EQUAL(3, statuses->count);
+    TEST_ASSERT_EQUAL_MESSAGE(2, queue.len, "Only the errors should be kept to repeat");
+}
+
+static void test_event_queue__critical_repeated(void) {
+    struct packer pk;
+
+    memset(&drops, 0, sizeof(drops));
+    event_queue_init(&queue, &drops);
+    push_status(STATUS_TELEMETRY_CHANGED_APOGEE);
+
+    for (int i = 0; i < EVENT_CRITICAL_REPEATS; i++) {
+        packer_init(&pk, packet, i, MISSION_TIME_MS);
+        TEST_ASSERT_EQUAL_MESSAGE(1, event_queue_pack(&queue, &pk), "A critical event wasn't repeated");
+    }
+
+    packer_init(&pk, packet, EVENT_CRITICAL_REPEATS, MISSION_TIME_MS);
+    TEST_ASSERT_EQUAL_MESSAGE(0, event_queue_pack(&queue, &pk), "A critical event was repeated too often");
+    TEST_ASSERT_EQUAL(0, queue.len);
+}
+
+static void test_event_queue__full_drops_sent(void) {
+    struct packer pk;
+
+    memset(&drops, 0, sizeof(drops));
+    event_queue_init(&queue, &drops);
+    push_error(PROC_ID_GENERAL);
+    packer_init(&pk, packet, 0, MISSION_TIME_MS);
+    event_queue_pack(&queue, &pk);
+
+    for (int i = 1; i < EVENT_QUEUE_LEN; i++) {
+        push_error(PROC_ID_FUSION);
+    }
+    push_error(PROC_ID_LOGGING);
+
+    TEST_ASSERT_EQUAL(EVENT_QUEUE_LEN, queue.len);
+    TEST_ASSERT_EQUAL(1, drops.size[DATA_ERROR]);
+    TEST_ASSERT_EQUAL_MESSAGE(PROC_ID_FUSION, queue.events[0].error.proc_id, "The sent event should be dropped");
+    TEST_ASSERT_EQUAL(PROC_ID_LOGGING, queue.events[EVENT_QUEUE_LEN - 1].error.proc_id);
+}
+
+static void test_event_queue__stale_dropped(void) {
+    struct packer pk;
+    struct status_message status = {.timestamp = 0, .status_code = STATUS_TELEMETRY_CHANGED_LANDED};
+
+    memset(&drops, 0, sizeof(drops));
+    event_queue_init(&queue, &drops);
+    event_queue_push_status(&queue, &status);
+
+    packer_init(&pk, packet, 0, MISSION_TIME_MS);
+    TEST_ASSERT_EQUAL(0, event_queue_pack(&queue, &pk));
+    TEST_ASSERT_EQUAL_MESSAGE(0, ((pkt_hdr_t *)packet)->type_count, "A stale event was packed");
+    TEST_ASSERT_EQUAL(0, queue.len);
+    TEST_ASSERT_EQUAL(1, drops.time[DATA_STATUS]);
+}
+
+void test_event_queue(void) {
+    RUN_TEST(test_event_queue__every_event_packed);
+    RUN_TEST(test_event_queue__critical_repeated);
+    RUN_TEST(test_event_queue__full_drops_sent);
+    RUN_TEST(test_event_queue__stale_dropped);
+}
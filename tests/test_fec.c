@@ -0,0 +1,153 @@
+#include <nuttx/config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <testing/unity.h>
+
+#include "../telemetry/src/packets/fec.h"
+
+/* The longest data packet a parity packet can cover */
+
+#define DATA_MAX_SIZE (PACKET_MAX_SIZE - PACKET_FEC_OVERHEAD)
+
+/* The number of data packets sent in the loss simulation */
+
+#define SIM_PACKETS 4000
+
+static uint8_t data[FEC_MAX_GROUP][PACKET_MAX_SIZE];
+static size_t data_lens[FEC_MAX_GROUP];
+static uint8_t rebuilt[PACKET_MAX_SIZE];
+
+/* Fill a data packet with random blocks. Most packets are nearly full, since the transmit thread packs what it can.
+ *
+ * @param packet The packet to fill
+ * @param packet_num The packet's sequence number
+ * @return The length of the packet
+ */
+static size_t random_packet(uint8_t *packet, uint8_t packet_num) {
+    uint8_t *end = pkt_init(packet, packet_num, 60000 + rand() % 30000);
+    size_t len = rand() % 8 == 0 ? sizeof(pkt_hdr_t) + rand() % (DATA_MAX_SIZE - sizeof(pkt_hdr_t) + 1)
+                                 : DATA_MAX_SIZE - rand() % 32;
+
+    ((pkt_hdr_t *)packet)->type_count = rand() % 8;
+    for (; end < packet + len; end++) {
+        *end = rand();
+    }
+    return len;
+}
+
+/* Encode a group of random data packets
+ *
+ * @param enc The encoder, at the start of a group
+ * @param group The number of packets in the group
+ * @param first_num The sequence number of the first packet
+ * @return The length of the group's parity packet in enc->parity, or 0 if it was finished early or never
+ */
+static int encode_group(struct fec_encoder *enc, int group, uint8_t first_num) {
+    int parity_len = 0;
+    for (int i = 0; i < group; i++) {
+        if (parity_len != 0) {
+            return 0;
+        }
+        data_lens[i] = random_packet(data[i], first_num + i);
+        parity_len = fec_encoder_add(enc, data[i], data_lens[i]);
+    }
+    return parity_len;
+}
+
+/* Tests */
+
+static void test_fec__rebuilds_any_lost_packet(void) {
+    struct fec_encoder enc;
+    const uint8_t *received[4];
+    size_t out_len;
+
+    srand(20);
+    TEST_ASSERT_EQUAL(0, fec_encoder_init(&enc, 4));
+    int parity_len = encode_group(&enc, 4, 254);
+    TEST_ASSERT_TRUE_MESSAGE(parity_len > 0 && parity_len <= PACKET_MAX_SIZE, "Parity packet doesn't fit");
+    TEST_ASSERT_TRUE(fec_is_parity(enc.parity, parity_len));
+    TEST_ASSERT_FALSE(fec_is_parity(data[0], data_lens[0]));
+
+    for (int lost = 0; lost < 4; lost++) {
+        for (int i = 0; i < 4; i++) {
+            received[i] = i == lost ? NULL : data[i];
+        }
+        TEST_ASSERT_EQUAL(lost, fec_recover(enc.parity, parity_len, received, data_lens, rebuilt, &out_len));
+        TEST_ASSERT_EQUAL_MESSAGE(data_lens[lost], out_len, "Rebuilt packet has the wrong length");
+        TEST_ASSERT_EQUAL_MESSAGE(0, memcmp(data[lost], rebuilt, out_len), "Rebuilt packet doesn't match");
+    }
+}
+
+static void test_fec__one_loss_per_group(void) {
+    struct fec_encoder enc;
+    const uint8_t *received[3] = {data[0], data[1], data[2]};
+    size_t out_len;
+
+    srand(21);
+    TEST_ASSERT_EQUAL(-EINVAL, fec_encoder_init(&enc, 1));
+    TEST_ASSERT_EQUAL(0, fec_encoder_init(&enc, 3));
+    int parity_len = encode_group(&enc, 3, 0);
+
+    TEST_ASSERT_EQUAL(-ENOENT, fec_recover(enc.parity, parity_len, received, data_lens, rebuilt, &out_len));
+    received[0] = NULL;
+    received[2] = NULL;
+    TEST_ASSERT_EQUAL(-ERANGE, fec_recover(enc.parity, parity_len, received, data_lens, rebuilt, &out_len));
+    TEST_ASSERT_EQUAL(-EINVAL, fec_recover(data[1], data_lens[1], received, data_lens, rebuilt, &out_len));
+}
+
+static void test_fec__loss_simulation(void) {
+    static const int groups[] = {4, 8};
+    static const int loss_permille[] = {10, 50, 100, 200};
+    const uint8_t *received[FEC_MAX_GROUP];
+    struct fec_encoder enc;
+    size_t out_len;
+
+    srand(22);
+    for (int g = 0; g < sizeof(groups) / sizeof(groups[0]); g++) {
+        for (int l = 0; l < sizeof(loss_permille) / sizeof(loss_permille[0]); l++) {
+            int group = groups[g];
+            long sent = 0, parity_sent = 0, delivered = 0, recovered = 0;
+
+            TEST_ASSERT_EQUAL(0, fec_encoder_init(&enc, group));
+            for (int n = 0; n < SIM_PACKETS; n += group) {
+                int parity_len = encode_group(&enc, group, n);
+                TEST_ASSERT_GREATER_THAN_MESSAGE(0, parity_len, "No parity sent for the group");
+                bool parity_lost = rand() % 1000 < loss_permille[l];
+
+                for (int i = 0; i < group; i++) {
+                    received[i] = rand() % 1000 < loss_permille[l] ? NULL : data[i];
+                    sent += data_lens[i];
+                    delivered += received[i] != NULL ? data_lens[i] : 0;
+                }
+                parity_sent += parity_len;
+
+                int lost = parity_lost ? -ENOENT
+                                       : fec_recover(enc.parity, parity_len, received, data_lens, rebuilt, &out_len);
+                if (lost >= 0) {
+                    TEST_ASSERT_EQUAL_MESSAGE(0, memcmp(data[lost], rebuilt, data_lens[lost]), "Bad rebuild");
+                    recovered += data_lens[lost];
+                }
+            }
+
+            char msg[100];
+            snprintf(msg, sizeof(msg), "Group %d, %d%% loss: delivered %.1f%% -> %.1f%%, goodput %.1f%%", group,
+                     loss_permille[l] / 10, 100.0 * delivered / sent, 100.0 * (delivered + recovered) / sent,
+                     100.0 * (delivered + recovered) / (sent + parity_sent));
+            TEST_MESSAGE(msg);
+            if (loss_permille[l] >= 50) {
+                TEST_ASSERT_GREATER_THAN_MESSAGE(0, recovered, "No lost packets were rebuilt");
+            }
+            if (loss_permille[l] <= 10) {
+                TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(sent * 995 / 1000, delivered + recovered,
+                                                     "Light loss wasn't almost entirely rebuilt");
+            }
+        }
+    }
+}
+
+void test_fec(void) {
+    RUN_TEST(test_fec__rebuilds_any_lost_packet);
+    RUN_TEST(test_fec__one_loss_per_group);
+    RUN_TEST(test_fec__loss_simulation);
+}
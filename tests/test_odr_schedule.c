@@ -0,0 +1,37 @@
+#include <nuttx/config.h>
+#include <testing/unity.h>
+
+#include "../telemetry/src/collection/odr-schedule.h"
+
+/* Tests */
+
+static void test_odr_schedule__profile_of_each_state(void) {
+    TEST_ASSERT_EQUAL_MESSAGE(ODR_PROFILE_IDLE, odr_profile(STATE_IDLE, SUBSTATE_UNKNOWN), "Wrong idle profile");
+    TEST_ASSERT_EQUAL_MESSAGE(ODR_PROFILE_ASCENT, odr_profile(STATE_AIRBORNE, SUBSTATE_ASCENT), "Wrong ascent profile");
+    TEST_ASSERT_EQUAL_MESSAGE(ODR_PROFILE_DESCENT, odr_profile(STATE_AIRBORNE, SUBSTATE_DESCENT),
+                              "Wrong descent profile");
+    TEST_ASSERT_EQUAL_MESSAGE(ODR_PROFILE_LANDED, odr_profile(STATE_LANDED, SUBSTATE_UNKNOWN), "Wrong landed profile");
+}
+
+static void test_odr_schedule__unknown_substate_uses_ascent(void) {
+    TEST_ASSERT_EQUAL_MESSAGE(ODR_PROFILE_ASCENT, odr_profile(STATE_AIRBORNE, SUBSTATE_UNKNOWN),
+                              "An airborne rocket in an unknown substate should get the ascent rates");
+}
+
+static void test_odr_schedule__max_frequency_covers_every_profile(void) {
+    for (int s = 0; s < ODR_NUM_SENSORS; s++) {
+        uint32_t max = odr_max_frequency(s);
+        int reached = 0;
+        for (int p = 0; p < ODR_NUM_PROFILES; p++) {
+            TEST_ASSERT_TRUE_MESSAGE(odr_frequency(s, p) <= max, "A profile is above the maximum");
+            reached |= odr_frequency(s, p) == max;
+        }
+        TEST_ASSERT_TRUE_MESSAGE(reached, "No profile reaches the maximum");
+    }
+}
+
+void test_odr_schedule(void) {
+    RUN_TEST(test_odr_schedule__profile_of_each_state);
+    RUN_TEST(test_odr_schedule__unknown_substate_uses_ascent);
+    RUN_TEST(test_odr_schedule__max_frequency_covers_every_profile);
+}
@@ -0,0 +1,76 @@
+#include <nuttx/config.h>
+#include <testing/unity.h>
+
+#include "../telemetry/src/packets/packer.h"
+
+/* A mission time whose samples can all be offset from the packet header's timestamp */
+
+#define MISSION_TIME_MS 60000
+
+static uint8_t packet[PACKET_MAX_SIZE];
+
+/* Tests */
+
+static void test_packer__never_exceeds_mtu(void) {
+    struct packer pk;
+    int added = 0;
+
+    packer_init(&pk, packet, 0, MISSION_TIME_MS);
+    while (packer_add(&pk, DATA_ACCEL_REL, MISSION_TIME_MS) != NULL) {
+        added++;
+        TEST_ASSERT_TRUE_MESSAGE(packer_size(&pk) <= PACKET_DATA_MAX_SIZE, "Packet grew past the MTU");
+    }
+
+    TEST_ASSERT_EQUAL_MESSAGE((PACKET_DATA_MAX_SIZE - sizeof(pkt_hdr_t) - sizeof(blk_hdr_t)) /
+                                  sizeof(struct accel_blk_t),
+                              added, "The packet wasn't filled");
+    TEST_ASSERT_EQUAL_MESSAGE(1, ((pkt_hdr_t *)packet)->type_count, "Samples of one type should share a block");
+    TEST_ASSERT_EQUAL_MESSAGE(added, ((blk_hdr_t *)(packet + sizeof(pkt_hdr_t)))->count, "Wrong block count");
+    TEST_ASSERT_NULL_MESSAGE(packer_add(&pk, DATA_LAT_LONG, MISSION_TIME_MS),
+                             "A new block was added to a full packet");
+}
+
+static void test_packer__blocks_follow_types(void) {
+    struct packer pk;
+
+    packer_init(&pk, packet, 0, MISSION_TIME_MS);
+    TEST_ASSERT_NOT_NULL(packer_add(&pk, DATA_ALT_SEA, MISSION_TIME_MS));
+    TEST_ASSERT_NOT_NULL(packer_add(&pk, DATA_ALT_SEA, MISSION_TIME_MS));
+    TEST_ASSERT_NOT_NULL(packer_add(&pk, DATA_LAT_LONG, MISSION_TIME_MS));
+
+    blk_hdr_t *alt = (blk_hdr_t *)(packet + sizeof(pkt_hdr_t));
+    blk_hdr_t *coord = (blk_hdr_t *)(block_body((uint8_t *)alt) + 2 * sizeof(struct alt_blk_t));
+    TEST_ASSERT_EQUAL_MESSAGE(2, ((pkt_hdr_t *)packet)->type_count, "Wrong number of blocks");
+    TEST_ASSERT_EQUAL_MESSAGE(DATA_ALT_SEA, alt->type, "Wrong first block type");
+    TEST_ASSERT_EQUAL_MESSAGE(2, alt->count, "Wrong first block count");
+    TEST_ASSERT_EQUAL_MESSAGE(DATA_LAT_LONG, coord->type, "Wrong second block type");
+    TEST_ASSERT_EQUAL_MESSAGE(1, coord->count, "Wrong second block count");
+    TEST_ASSERT_EQUAL_MESSAGE((uint8_t *)block_body((uint8_t *)coord) + sizeof(struct coord_blk_t) - packet,
+                              packer_size(&pk), "Wrong packet size");
+}
+
+static void test_packer__undo(void) {
+    struct packer pk;
+
+    packer_init(&pk, packet, 0, MISSION_TIME_MS);
+    packer_add(&pk, DATA_ALT_SEA, MISSION_TIME_MS);
+    packer_add(&pk, DATA_ERROR, MISSION_TIME_MS);
+    packer_add(&pk, DATA_ERROR, MISSION_TIME_MS);
+
+    packer_undo(&pk);
+    TEST_ASSERT_EQUAL_MESSAGE(2, ((pkt_hdr_t *)packet)->type_count, "A block with samples left was removed");
+    TEST_ASSERT_EQUAL_MESSAGE(sizeof(pkt_hdr_t) + 2 * sizeof(blk_hdr_t) + sizeof(struct alt_blk_t) +
+                                  sizeof(struct error_blk_t),
+                              packer_size(&pk), "The sample wasn't removed");
+
+    packer_undo(&pk);
+    TEST_ASSERT_EQUAL_MESSAGE(1, ((pkt_hdr_t *)packet)->type_count, "The empty block wasn't removed");
+    TEST_ASSERT_EQUAL_MESSAGE(sizeof(pkt_hdr_t) + sizeof(blk_hdr_t) + sizeof(struct alt_blk_t), packer_size(&pk),
+                              "The empty block's header wasn't removed");
+}
+
+void test_packer(void) {
+    RUN_TEST(test_packer__never_exceeds_mtu);
+    RUN_TEST(test_packer__blocks_follow_types);
+    RUN_TEST(test_packer__undo);
+}
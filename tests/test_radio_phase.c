@@ -0,0 +1,111 @@
+#include <nuttx/config.h>
+#include <testing/unity.h>
+
+#include "../telemetry/src/transmission/radio-phase.h"
+
+/* A radio configuration with a spread factor and bandwidth between the rate and range settings */
+
+static const struct radio_options base = {
+    .freq = 433050000,
+    .bw = 250,
+    .spread = 9,
+    .preamble = 8,
+    .crc = true,
+};
+
+/* Tests */
+
+static void test_radio_phase__options_follow_flight(void) {
+    struct radio_options out;
+
+    for (int p = 0; p < ODR_NUM_PROFILES; p++) {
+        radio_phase_options(&base, p, &out);
+        TEST_ASSERT_EQUAL_MESSAGE(base.freq, out.freq, "Only the spread factor and bandwidth should change");
+        TEST_ASSERT_EQUAL_MESSAGE(base.preamble, out.preamble, "Only the spread factor and bandwidth should change");
+#ifdef CONFIG_INSPACE_TELEMETRY_RADIO_PHASES
+        if (p == ODR_PROFILE_IDLE || p == ODR_PROFILE_ASCENT) {
+            TEST_ASSERT_EQUAL_MESSAGE(CONFIG_INSPACE_TELEMETRY_RADIO_RATE_SPREAD, out.spread, "Wrong rate spread");
+            TEST_ASSERT_EQUAL_MESSAGE(CONFIG_INSPACE_TELEMETRY_RADIO_RATE_BW, out.bw, "Wrong rate bandwidth");
+        } else {
+            TEST_ASSERT_EQUAL_MESSAGE(CONFIG_INSPACE_TELEMETRY_RADIO_RANGE_SPREAD, out.spread, "Wrong range spread");
+            TEST_ASSERT_EQUAL_MESSAGE(CONFIG_INSPACE_TELEMETRY_RADIO_RANGE_BW, out.bw, "Wrong range bandwidth");
+        }
+#else
+        TEST_ASSERT_EQUAL_MESSAGE(base.spread, out.spread, "The configured settings should be kept");
+        TEST_ASSERT_EQUAL_MESSAGE(base.bw, out.bw, "The configured settings should be kept");
+#endif
+    }
+}
+
+static void test_radio_phase__switch_announced(void) {
+    struct radio_phase rp;
+
+    radio_phase_init(&rp, &base);
+#ifdef CONFIG_INSPACE_TELEMETRY_RADIO_PHASES
+    uint8_t first = 250 + CONFIG_INSPACE_TELEMETRY_RADIO_SWITCH_NOTICE;
+
+    TEST_ASSERT_TRUE_MESSAGE(radio_phase_plan(&rp, ODR_PROFILE_IDLE, 250), "A switch should be planned");
+    TEST_ASSERT_EQUAL_MESSAGE(first, rp.first_packet, "The switch should follow the notice packets");
+    TEST_ASSERT_FALSE_MESSAGE(radio_phase_plan(&rp, ODR_PROFILE_DESCENT, 250), "Only one switch at a time");
+
+    /* The notice packets are built and sent on the old settings */
+
+    for (uint8_t num = 250; num != first; num++) {
+        TEST_ASSERT_TRUE_MESSAGE(rp.announcing, "Packets before the switch should announce it");
+        TEST_ASSERT_FALSE_MESSAGE(radio_phase_due(&rp, num), "Switched before the announced packet");
+        TEST_ASSERT_EQUAL_MESSAGE((uint8_t)(num + 1) == first, radio_phase_advance(&rp, num + 1),
+                                  "Packets should be built for the new settings from the announced one");
+    }
+    TEST_ASSERT_FALSE_MESSAGE(rp.announcing, "Should stop announcing at the first packet");
+    TEST_ASSERT_EQUAL_MESSAGE(CONFIG_INSPACE_TELEMETRY_RADIO_RATE_SPREAD, rp.config.spread,
+                              "Packets from the switch on should be built for the new settings");
+
+    TEST_ASSERT_TRUE_MESSAGE(radio_phase_due(&rp, first), "Should switch before the announced packet");
+    radio_phase_done(&rp);
+    TEST_ASSERT_FALSE_MESSAGE(radio_phase_due(&rp, first), "Switched twice");
+
+    TEST_ASSERT_FALSE_MESSAGE(radio_phase_plan(&rp, ODR_PROFILE_ASCENT, first), "The settings haven't changed");
+    TEST_ASSERT_TRUE_MESSAGE(radio_phase_plan(&rp, ODR_PROFILE_DESCENT, first), "Apogee should switch to range");
+#else
+    TEST_ASSERT_FALSE_MESSAGE(radio_phase_plan(&rp, ODR_PROFILE_DESCENT, 0), "The settings don't follow the flight");
+    TEST_ASSERT_FALSE(radio_phase_due(&rp, 0));
+#endif
+}
+
+static void test_radio_phase__switch_after_lost_packet(void) {
+    struct radio_phase rp;
+
+    radio_phase_init(&rp, &base);
+    rp.first_packet = 2;
+    atomic_store(&rp.pending, true);
+
+    /* The announced packet can be overwritten before it's sent, so any later one switches the radio */
+
+    TEST_ASSERT_FALSE_MESSAGE(radio_phase_due(&rp, 1), "Switched before the announced packet");
+    TEST_ASSERT_FALSE_MESSAGE(radio_phase_due(&rp, 200), "Packet numbers should wrap around");
+    TEST_ASSERT_TRUE_MESSAGE(radio_phase_due(&rp, 3), "A packet after the announced one should switch");
+}
+
+static void test_radio_phase__failed_switch_retried(void) {
+    struct radio_phase rp;
+
+    radio_phase_init(&rp, &base);
+    rp.first_packet = 2;
+    atomic_store(&rp.pending, true);
+
+    /* Until the switch works, every packet retries it, even once the packet numbers wrap past the announced one */
+
+    TEST_ASSERT_TRUE_MESSAGE(radio_phase_due(&rp, 2), "The announced packet should switch");
+    for (int i = 1; i <= 256; i++) {
+        TEST_ASSERT_TRUE_MESSAGE(radio_phase_due(&rp, (uint8_t)(2 + i)), "A failed switch should be retried");
+    }
+    radio_phase_done(&rp);
+    TEST_ASSERT_FALSE_MESSAGE(radio_phase_due(&rp, 3), "Switched again after the switch worked");
+}
+
+void test_radio_phase(void) {
+    RUN_TEST(test_radio_phase__options_follow_flight);
+    RUN_TEST(test_radio_phase__switch_announced);
+    RUN_TEST(test_radio_phase__switch_after_lost_packet);
+    RUN_TEST(test_radio_phase__failed_switch_retried);
+}
@@ -0,0 +1,268 @@
+#include <nuttx/config.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <testing/unity.h>
+#include <time.h>
+
+#include "../telemetry/src/radio-telem.h"
+
+/* The number of elements the stress test sends through each channel */
+
+#define STRESS_ELEMENTS 200000
+
+/* How long the stress test can run before it's considered stuck, in seconds */
+
+#define STRESS_TIMEOUT_S 60
+
+/* The channels filled by the stress test */
+
+static const enum radio_channel_e stress_channels[] = {RADIO_ALT, RADIO_ACCEL, RADIO_GYRO};
+
+#define NUM_STRESS_CHANNELS (sizeof(stress_channels) / sizeof(stress_channels[0]))
+
+static radio_telem_t radio_telem;
+
+/* Set when the stress test's consumer stops, so the producer doesn't wait for room forever */
+
+static atomic_int stress_stop;
+
+/* Helpers */
+
+/* Get the element count of a channel */
+static int *count_of(radio_raw_data *data, enum radio_channel_e ch) {
+    switch (ch) {
+    case RADIO_ALT:
+        return &data->alt_n;
+    case RADIO_ACCEL:
+        return &data->accel_n;
+    case RADIO_GYRO:
+        return &data->gyro_n;
+    default:
+        return NULL;
+    }
+}
+
+/* Append an element to a channel, with every field derived from its sequence number so a torn copy can be detected */
+static void append(radio_raw_data *data, enum radio_channel_e ch) {
+    int n = *count_of(data, ch);
+    uint32_t seq = data->first_seq[ch] + n;
+
+    switch (ch) {
+    case RADIO_ALT:
+        data->alt[n] = (struct fusion_altitude){.timestamp = seq, .altitude = seq};
+        break;
+    case RADIO_ACCEL:
+        data->accel[n] = (struct sensor_accel){.timestamp = seq, .x = seq, .y = -(float)seq, .z = seq / 2};
+        break;
+    case RADIO_GYRO:
+        data->gyro[n] = (struct sensor_gyro){.timestamp = seq, .x = -(float)seq, .y = seq / 2, .z = seq};
+        break;
+    default:
+        break;
+    }
+    (*count_of(data, ch))++;
+}
+
+/* Check that an element was copied whole, returning its sequence number or -1 if it's torn */
+static int64_t element_seq(radio_raw_data *data, enum radio_channel_e ch, int i) {
+    switch (ch) {
+    case RADIO_ALT: {
+        struct fusion_altitude *alt = &data->alt[i];
+        return alt->altitude == alt->timestamp ? (int64_t)alt->timestamp : -1;
+    }
+    case RADIO_ACCEL: {
+        struct sensor_accel *a = &data->accel[i];
+        uint32_t seq = a->timestamp;
+        return a->x == seq && a->y == -(float)seq && a->z == seq / 2 ? seq : -1;
+    }
+    case RADIO_GYRO: {
+        struct sensor_gyro *g = &data->gyro[i];
+        uint32_t seq = g->timestamp;
+        return g->x == -(float)seq && g->y == seq / 2 && g->z == seq ? seq : -1;
+    }
+    default:
+        return -1;
+    }
+}
+
+/* Adds elements to every stress channel as fast as there is room for them, publishing after each round */
+static void *stress_producer(void *arg) {
+    uint32_t produced[NUM_STRESS_CHANNELS] = {0};
+    int done = 0;
+
+    while (!done && !atomic_load(&stress_stop)) {
+        radio_raw_data *data = radio_telem_writable(&radio_telem);
+        int added = 0;
+
+        radio_telem_reclaim(&radio_telem);
+        done = 1;
+        for (int c = 0; c < NUM_STRESS_CHANNELS; c++) {
+            enum radio_channel_e ch = stress_channels[c];
+            if (produced[c] < STRESS_ELEMENTS && *count_of(data, ch) < RADIO_DATA_LEN) {
+                append(data, ch);
+                produced[c]++;
+                added++;
+            }
+            done &= produced[c] == STRESS_ELEMENTS;
+        }
+
+        if (added) {
+            radio_telem_publish(&radio_telem);
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/* Tests */
+
+static void test_radio_telem__empty_before_publish(void) {
+    radio_telem_init(&radio_telem);
+    radio_raw_data *data = radio_telem_acquire(&radio_telem);
+    TEST_ASSERT_EQUAL_MESSAGE(0, data->accel_n, "Nothing should be acquired before a publish");
+    TEST_ASSERT_EQUAL_MESSAGE(0, radio_telem_reclaim(&radio_telem), "Nothing was published to be taken");
+}
+
+static void test_radio_telem__unread_publish_is_not_lost(void) {
+    radio_telem_init(&radio_telem);
+    append(radio_telem_writable(&radio_telem), RADIO_ACCEL);
+    radio_telem_publish(&radio_telem);
+    append(radio_telem_writable(&radio_telem), RADIO_ACCEL);
+    radio_telem_publish(&radio_telem);
+
+    radio_raw_data *data = radio_telem_acquire(&radio_telem);
+    TEST_ASSERT_EQUAL_MESSAGE(2, data->accel_n, "Data from the replaced publish was lost");
+    TEST_ASSERT_EQUAL_MESSAGE(0, element_seq(data, RADIO_ACCEL, 0), "Wrong first element");
+    TEST_ASSERT_EQUAL_MESSAGE(1, element_seq(data, RADIO_ACCEL, 1), "Wrong second element");
+
+    data = radio_telem_acquire(&radio_telem);
+    TEST_ASSERT_EQUAL_MESSAGE(0, data->accel_n, "Data was acquired twice");
+}
+
+static void test_radio_telem__acquired_data_not_repeated(void) {
+    radio_telem_init(&radio_telem);
+    append(radio_telem_writable(&radio_telem), RADIO_ACCEL);
+    append(radio_telem_writable(&radio_telem), RADIO_ALT);
+    radio_telem_publish(&radio_telem);
+    radio_telem_acquire(&radio_telem);
+
+    /* The producer hasn't reclaimed yet, so the next publish still holds the acquired elements */
+
+    append(radio_telem_writable(&radio_telem), RADIO_ACCEL);
+    radio_telem_publish(&radio_telem);
+    TEST_ASSERT_EQUAL_MESSAGE(1, radio_telem_reclaim(&radio_telem), "Acquire wasn't reported to the producer");
+    TEST_ASSERT_EQUAL_MESSAGE(1, radio_telem_writable(&radio_telem)->accel_n, "Acquired data wasn't reclaimed");
+
+    radio_raw_data *data = radio_telem_acquire(&radio_telem);
+    TEST_ASSERT_EQUAL_MESSAGE(1, data->accel_n, "Acquired data was repeated");
+    TEST_ASSERT_EQUAL_MESSAGE(1, element_seq(data, RADIO_ACCEL, 0), "Wrong element after the acquired one");
+    TEST_ASSERT_EQUAL_MESSAGE(0, data->alt_n, "Acquired data was repeated");
+}
+
+static void test_radio_telem__merge_drops_oldest(void) {
+    static radio_raw_data dst;
+    static radio_raw_data src;
+
+    memset(&dst, 0, sizeof(dst));
+    memset(&src, 0, sizeof(src));
+    for (int i = 0; i < RADIO_DATA_LEN; i++) {
+        append(&dst, RADIO_ALT);
+    }
+    src.first_seq[RADIO_ALT] = RADIO_DATA_LEN;
+    append(&src, RADIO_ALT);
+    append(&src, RADIO_ACCEL);
+
+    TEST_ASSERT_EQUAL_MESSAGE(1, radio_data_merge(&dst, &src), "Only the oldest overflowing element should be dropped");
+    TEST_ASSERT_EQUAL_MESSAGE(RADIO_DATA_LEN, radio_data_count(&dst, RADIO_ALT), "Wrong merged count");
+    TEST_ASSERT_EQUAL_MESSAGE(1, element_seq(&dst, RADIO_ALT, 0), "The oldest element wasn't dropped");
+    TEST_ASSERT_EQUAL_MESSAGE(RADIO_DATA_LEN, element_seq(&dst, RADIO_ALT, RADIO_DATA_LEN - 1),
+                              "The new element wasn't appended");
+    TEST_ASSERT_EQUAL_MESSAGE(1, radio_data_count(&dst, RADIO_ACCEL), "An empty channel wasn't merged");
+}
+
+static void test_radio_telem__take_keeps_newest(void) {
+    static radio_raw_data data;
+    int taken[RADIO_NUM_CHANNELS] = {[RADIO_ACCEL] = 2};
+
+    memset(&data, 0, sizeof(data));
+    for (int i = 0; i < 3; i++) {
+        append(&data, RADIO_ACCEL);
+    }
+    append(&data, RADIO_GYRO);
+
+    radio_data_take(&data, taken);
+    TEST_ASSERT_EQUAL_MESSAGE(1, data.accel_n, "Wrong number of elements left");
+    TEST_ASSERT_EQUAL_MESSAGE(2, element_seq(&data, RADIO_ACCEL, 0), "The oldest elements weren't taken");
+    TEST_ASSERT_EQUAL_MESSAGE(1, data.gyro_n, "An untaken channel changed");
+}
+
+/* Runs the producer and consumer on separate threads, checking every element arrives exactly once, in order and
+ * whole */
+static void test_radio_telem__stress_exactly_once(void) {
+    pthread_t producer;
+    uint32_t expected[NUM_STRESS_CHANNELS] = {0};
+    int torn = 0;
+    int out_of_order = 0;
+    unsigned acquires = 0;
+    struct timespec start;
+    struct timespec now;
+
+    radio_telem_init(&radio_telem);
+    atomic_store(&stress_stop, 0);
+    TEST_ASSERT_EQUAL_MESSAGE(0, pthread_create(&producer, NULL, stress_producer, NULL), "Couldn't start producer");
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (;;) {
+        radio_raw_data *data = radio_telem_acquire(&radio_telem);
+        int done = 1;
+
+        acquires++;
+        for (int c = 0; c < NUM_STRESS_CHANNELS; c++) {
+            int n = *count_of(data, stress_channels[c]);
+            for (int i = 0; i < n; i++) {
+                int64_t seq = element_seq(data, stress_channels[c], i);
+                if (seq < 0) {
+                    torn++;
+                } else if (seq != expected[c]) {
+                    out_of_order++;
+                    expected[c] = seq + 1;
+                } else {
+                    expected[c]++;
+                }
+            }
+            done &= expected[c] >= STRESS_ELEMENTS;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (done || torn || out_of_order || now.tv_sec - start.tv_sec > STRESS_TIMEOUT_S) {
+            break;
+        }
+        sched_yield();
+    }
+
+    atomic_store(&stress_stop, 1);
+    pthread_join(producer, NULL);
+
+    char msg[60];
+    snprintf(msg, sizeof(msg), "Stress test took %u acquires", acquires);
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_EQUAL_MESSAGE(0, torn, "Acquired a torn element");
+    TEST_ASSERT_EQUAL_MESSAGE(0, out_of_order, "Elements were lost or repeated");
+    for (int c = 0; c < NUM_STRESS_CHANNELS; c++) {
+        TEST_ASSERT_EQUAL_MESSAGE(STRESS_ELEMENTS, expected[c], "Not every element was acquired");
+    }
+}
+
+void test_radio_telem(void) {
+    RUN_TEST(test_radio_telem__empty_before_publish);
+    RUN_TEST(test_radio_telem__unread_publish_is_not_lost);
+    RUN_TEST(test_radio_telem__acquired_data_not_repeated);
+    RUN_TEST(test_radio_telem__merge_drops_oldest);
+    RUN_TEST(test_radio_telem__take_keeps_newest);
+    RUN_TEST(test_radio_telem__stress_exactly_once);
+}
@@ -0,0 +1,142 @@
+#include <math.h>
+#include <nuttx/config.h>
+#include <stdlib.h>
+#include <testing/unity.h>
+
+#include "../telemetry/src/collection/rate-control.h"
+
+/* Outputs wanted every period in the simulations */
+
+#define SIM_TARGET 10
+
+/* Outputs the radio buffer holds, room for a burst of two periods' worth like RADIO_DATA_LEN by default */
+
+#define SIM_BUFFER (2 * SIM_TARGET)
+
+/* Transmit periods simulated, and how many at the end are checked */
+
+#define SIM_PERIODS 120
+#define SIM_CHECKED 60
+
+/* A simulated sensor feeding a downsampler whose radio buffer holds SIM_BUFFER outputs per period */
+struct sim_sensor {
+    double rate_hz;    /* Actual sample rate */
+    double drift_hz;   /* Change in the sample rate every period */
+    double period_s;   /* Nominal transmit period */
+    double jitter_s;   /* Maximum random change to each transmit period */
+    int max_batch;     /* Maximum number of samples delivered at once */
+    double next_us;    /* Timestamp of the next sample */
+    uint16_t window_n; /* Current downsampling window */
+    int exact_periods; /* Checked periods with exactly SIM_TARGET outputs */
+    double outputs;    /* Outputs over the checked periods */
+    int dropped;       /* Outputs that didn't fit in the radio buffer in the last period */
+    int drops;         /* Outputs that didn't fit in the radio buffer over the checked periods */
+};
+
+/* Helpers */
+
+/* Runs one transmit period of the simulation, returning the number of outputs */
+static int sim_period(struct sim_sensor *sim, struct rate_control *rc, double start_us) {
+    double period_s = sim->period_s + sim->jitter_s * (2.0 * rand() / RAND_MAX - 1.0);
+    double end_us = start_us + period_s * 1e6;
+    int outputs = 0;
+    int window = 0;
+    int dropped = 0;
+
+    while (sim->next_us < end_us) {
+        int batch = 1 + rand() % sim->max_batch;
+        uint64_t first_us = sim->next_us;
+        uint64_t last_us = first_us;
+
+        for (int i = 0; i < batch && sim->next_us < end_us; i++) {
+            last_us = sim->next_us;
+            sim->next_us += 1e6 / sim->rate_hz;
+            if (++window == sim->window_n) {
+                window = 0;
+                if (outputs == SIM_BUFFER) {
+                    dropped++;
+                    continue;
+                }
+                outputs++;
+            }
+        }
+        rate_control_samples(rc, first_us, last_us, batch);
+    }
+
+    sim->window_n = rate_control_update(rc, period_s, outputs + dropped);
+    sim->dropped = dropped;
+    sim->rate_hz += sim->drift_hz;
+    return outputs;
+}
+
+/* Runs a whole simulation, collecting statistics over the last periods */
+static void sim_run(struct sim_sensor *sim, struct rate_control *rc) {
+    double start_us = 1e6;
+
+    sim->next_us = start_us;
+    sim->exact_periods = 0;
+    sim->outputs = 0;
+    sim->drops = 0;
+    for (int p = 0; p < SIM_PERIODS; p++) {
+        int outputs = sim_period(sim, rc, start_us);
+        start_us = sim->next_us;
+        if (p >= SIM_PERIODS - SIM_CHECKED) {
+            sim->exact_periods += outputs == SIM_TARGET;
+            sim->outputs += outputs;
+            sim->drops += sim->dropped;
+        }
+    }
+}
+
+/* Tests */
+
+static void test_rate_control__converges_from_wrong_guess(void) {
+    struct rate_control rc;
+    struct sim_sensor sim = {.rate_hz = 1337, .period_s = 0.7, .max_batch = 1, .window_n = 100};
+
+    srand(42);
+    rate_control_init(&rc, SIM_TARGET, 1000, 1.0);
+    sim_run(&sim, &rc);
+
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(5, 1337, rc.input_hz, "Input rate wasn't measured");
+    TEST_ASSERT_EQUAL_MESSAGE(SIM_CHECKED, sim.exact_periods, "Not every period produced the target outputs");
+    TEST_ASSERT_EQUAL_MESSAGE(0, sim.drops, "Outputs were overproduced and dropped");
+}
+
+static void test_rate_control__tracks_drift_and_batches(void) {
+    struct rate_control rc;
+    struct sim_sensor sim = {
+        .rate_hz = 6600, .drift_hz = -3, .period_s = 0.7, .jitter_s = 0.01, .max_batch = 32, .window_n = 462};
+
+    srand(1234);
+    rate_control_init(&rc, SIM_TARGET, 6600, 0.7);
+    sim_run(&sim, &rc);
+
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.02f * sim.rate_hz, sim.rate_hz, rc.input_hz, "Drifting rate wasn't tracked");
+    TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(SIM_CHECKED * 95 / 100, sim.exact_periods,
+                                         "Too few periods produced the target outputs");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.1f, SIM_TARGET, sim.outputs / SIM_CHECKED, "Average outputs aren't the target");
+    TEST_ASSERT_EQUAL_MESSAGE(0, sim.drops, "Outputs were overproduced and dropped");
+}
+
+static void test_rate_control__low_rate_sensor(void) {
+    struct rate_control rc;
+    struct sim_sensor sim = {.rate_hz = 25, .period_s = 0.7, .jitter_s = 0.005, .max_batch = 2, .window_n = 1};
+
+    srand(7);
+    rate_control_init(&rc, SIM_TARGET, 25, 0.7);
+    sim_run(&sim, &rc);
+
+    /* 17.5 samples a period can't be split evenly into ten windows, so the window alternates to average the target */
+
+    TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(1, sim.window_n, "Window can't be empty");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.5f, SIM_TARGET, sim.outputs / SIM_CHECKED,
+                                     "Slow sensor produced the wrong outputs");
+    TEST_ASSERT_EQUAL_MESSAGE(0, sim.drops, "Outputs were overproduced and dropped");
+}
+
+void test_rate_control(void) {
+    RUN_TEST(test_rate_control__converges_from_wrong_guess);
+    RUN_TEST(test_rate_control__tracks_drift_and_batches);
+    RUN_TEST(test_rate_control__low_rate_sensor);
+}
@@ -0,0 +1,110 @@
+#include <nuttx/config.h>
+#include <testing/unity.h>
+
+#include "../telemetry/src/collection/resample.h"
+
+/* Spacing of the grid in the tests, in microseconds */
+
+#define GRID_US 1000
+
+/* Largest number of grid instants collected from a test channel */
+
+#define MAX_GRID 64
+
+/* Helpers */
+
+/* Pushes window outputs of a linear signal `value = slope * t` at `first_us + i * window_us`, collecting the grid
+ * instants produced. Returns the number collected. */
+static int resample_line(struct resampler *rs, uint64_t first_us, uint64_t window_us, int windows, float slope,
+                         uint64_t *grid, float *values) {
+    int n = 0;
+    uint64_t t;
+    float v[DECIMATOR_MAX_AXES];
+
+    for (int i = 0; i < windows; i++) {
+        uint64_t ts = first_us + i * window_us;
+        float in[DECIMATOR_MAX_AXES] = {slope * ts, -slope * ts, 0.0f};
+        resampler_push(rs, ts, in);
+        while (n < MAX_GRID && resampler_next(rs, &t, v)) {
+            grid[n] = t;
+            values[n] = v[0];
+            TEST_ASSERT_EQUAL_FLOAT_MESSAGE(-v[0], v[1], "Axes weren't interpolated the same way");
+            n++;
+        }
+    }
+    return n;
+}
+
+/* Tests */
+
+static void test_resample__channels_share_grid(void) {
+    struct resampler a;
+    struct resampler b;
+    uint64_t grid_a[MAX_GRID];
+    uint64_t grid_b[MAX_GRID];
+    float values[MAX_GRID];
+
+    /* Two channels whose windows are out of phase and of different lengths */
+
+    resampler_init(&a, 3, GRID_US);
+    resampler_init(&b, 3, GRID_US);
+    int n_a = resample_line(&a, 100370, 700, 40, 1.0f, grid_a, values);
+    int n_b = resample_line(&b, 100910, 1300, 22, 1.0f, grid_b, values);
+
+    TEST_ASSERT_GREATER_THAN_MESSAGE(20, n_b, "Too few grid instants produced");
+    for (int i = 0; i < n_a; i++) {
+        TEST_ASSERT_EQUAL_MESSAGE(0, grid_a[i] % GRID_US, "Grid instant isn't a multiple of the period");
+    }
+
+    /* Both channels start at their first grid instant, so the shorter one's instants are a subset of the other's */
+
+    uint64_t offset = (grid_b[0] - grid_a[0]) / GRID_US;
+    for (int i = 0; i < n_b && offset + i < (uint64_t)n_a; i++) {
+        TEST_ASSERT_EQUAL_MESSAGE(grid_a[offset + i], grid_b[i], "Channels produced different grid instants");
+    }
+}
+
+static void test_resample__interpolates_between_windows(void) {
+    struct resampler rs;
+    uint64_t grid[MAX_GRID];
+    float values[MAX_GRID];
+
+    resampler_init(&rs, 3, GRID_US);
+    int n = resample_line(&rs, 5250, 1700, 20, 0.5f, grid, values);
+
+    TEST_ASSERT_GREATER_THAN_MESSAGE(0, n, "No grid instants produced");
+    TEST_ASSERT_EQUAL_MESSAGE(6000, grid[0], "First grid instant isn't the first one after the first window");
+    for (int i = 0; i < n; i++) {
+        TEST_ASSERT_EQUAL_MESSAGE(6000 + i * GRID_US, grid[i], "Grid instant skipped or repeated");
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.01f, 0.5f * grid[i], values[i], "Linear signal wasn't reproduced");
+    }
+}
+
+static void test_resample__restarts_after_gap(void) {
+    struct resampler rs;
+    uint64_t t;
+    float v[DECIMATOR_MAX_AXES];
+    float in[DECIMATOR_MAX_AXES] = {1.0f, 2.0f, 3.0f};
+
+    resampler_init(&rs, 3, GRID_US);
+    resampler_push(&rs, 10500, in);
+    resampler_push(&rs, 11500, in);
+    TEST_ASSERT_TRUE_MESSAGE(resampler_next(&rs, &t, v), "Expected a grid instant between the windows");
+    TEST_ASSERT_FALSE_MESSAGE(resampler_next(&rs, &t, v), "Grid instant produced past the latest window");
+
+    /* A sensor that stopped for longer than the longest interpolated gap starts over instead of filling it */
+
+    in[0] = 100.0f;
+    resampler_push(&rs, 50200, in);
+    TEST_ASSERT_FALSE_MESSAGE(resampler_next(&rs, &t, v), "Grid instants produced across a gap");
+    resampler_push(&rs, 51200, in);
+    TEST_ASSERT_TRUE_MESSAGE(resampler_next(&rs, &t, v), "Expected a grid instant after the gap");
+    TEST_ASSERT_EQUAL_MESSAGE(51000, t, "Grid didn't restart at the first instant after the gap");
+    TEST_ASSERT_EQUAL_FLOAT_MESSAGE(100.0f, v[0], "Value interpolated from before the gap");
+}
+
+void test_resample(void) {
+    RUN_TEST(test_resample__channels_share_grid);
+    RUN_TEST(test_resample__interpolates_between_windows);
+    RUN_TEST(test_resample__restarts_after_gap);
+}
@@ -7,5 +7,22 @@ void test_logging(void);
 void test_detection(void);
 void test_circular_buffer(void);
 void test_filtering(void);
+void test_decimator(void);
+void test_radio_telem(void);
+void test_rate_control(void);
+void test_odr_schedule(void);
+void test_resample(void);
+void test_deadband(void);
+void test_downlink_profile(void);
+void test_packer(void);
+void test_airtime(void);
+void test_delta_blk(void);
+void test_buffering(void);
+void test_event_queue(void);
+void test_fec(void);
+void test_sim_radio(void);
+void test_transmit_stats(void);
+void test_radio_phase(void);
+void test_blocks(void);
 
 #endif // _TEST_RUNNERS_H_
@@ -0,0 +1,119 @@
+#include <fcntl.h>
+#include <nuttx/config.h>
+#include <stdio.h>
+#include <string.h>
+#include <testing/unity.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../telemetry/src/packets/packets.h"
+#include "../telemetry/src/transmission/airtime.h"
+#include "../telemetry/src/transmission/sim-radio.h"
+
+/* Where the tests store received frames */
+
+#define CAPTURE_PATH "/tmp/test_sim_radio.bin"
+
+/* The fastest radio configuration, so the tests don't spend long on air */
+
+static const struct radio_options fast_radio = {.bw = 500, .spread = 7, .preamble = 8, .crc = false};
+
+static uint8_t frame[PACKET_MAX_SIZE];
+static uint8_t capture[8 * (1 + PACKET_MAX_SIZE)];
+
+/* Open an empty capture file
+ *
+ * @return The capture file descriptor
+ */
+static int open_capture(void) { return open(CAPTURE_PATH, O_RDWR | O_CREAT | O_TRUNC, 0644); }
+
+/* Read back everything stored in the capture file
+ *
+ * @param fd The capture file
+ * @return The number of bytes stored
+ */
+static ssize_t read_capture(int fd) {
+    lseek(fd, 0, SEEK_SET);
+    return read(fd, capture, sizeof(capture));
+}
+
+/* Tests */
+
+static void test_sim_radio__blocks_for_airtime(void) {
+    struct sim_radio sim;
+    struct timespec start, end;
+    uint32_t airtime_us;
+    int fd = open_capture();
+
+    TEST_ASSERT_TRUE(fd >= 0);
+    TEST_ASSERT_EQUAL(0, sim_radio_init(&sim, &fast_radio, fd, 0, 0, 1));
+    for (size_t i = 0; i < 100; i++) {
+        frame[i] = i;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    TEST_ASSERT_EQUAL(100, sim_radio_write(&sim, frame, 100));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    lora_airtime_us(&fast_radio, 100, &airtime_us);
+    uint64_t elapsed_us = (end.tv_sec - start.tv_sec) * 1000000ull + (end.tv_nsec - start.tv_nsec) / 1000;
+    TEST_ASSERT_TRUE_MESSAGE(elapsed_us >= airtime_us, "The write returned before the frame was off air");
+
+    TEST_ASSERT_EQUAL_MESSAGE(101, read_capture(fd), "The frame wasn't stored after its length");
+    TEST_ASSERT_EQUAL(100, capture[0]);
+    TEST_ASSERT_EQUAL_MESSAGE(0, memcmp(frame, &capture[1], 100), "A lossless radio changed the frame");
+    TEST_ASSERT_EQUAL(-EINVAL, sim_radio_write(&sim, frame, 0));
+    close(fd);
+}
+
+static void test_sim_radio__loses_frames(void) {
+    struct sim_radio sim;
+    int fd = open_capture();
+
+    TEST_ASSERT_EQUAL(0, sim_radio_init(&sim, &fast_radio, fd, 1000, 0, 2));
+    TEST_ASSERT_EQUAL_MESSAGE(10, sim_radio_write(&sim, frame, 10), "A lost frame should still be sent");
+    TEST_ASSERT_EQUAL(1, sim.lost);
+    TEST_ASSERT_EQUAL_MESSAGE(0, read_capture(fd), "A lost frame was stored");
+
+    TEST_ASSERT_EQUAL(0, sim_radio_init(&sim, &fast_radio, fd, 500, 0, 3));
+    for (int i = 0; i < 40; i++) {
+        sim_radio_write(&sim, frame, 1);
+    }
+    TEST_ASSERT_EQUAL(40, sim.sent);
+    TEST_ASSERT_INT_WITHIN_MESSAGE(12, 20, sim.lost, "Loss is far from the configured rate");
+    TEST_ASSERT_EQUAL_MESSAGE(2 * (40 - sim.lost), read_capture(fd), "Received frames weren't all stored");
+    close(fd);
+}
+
+static void test_sim_radio__bit_errors(void) {
+    struct radio_options crc_radio = fast_radio;
+    struct sim_radio sim;
+    int flipped = 0;
+    int fd = open_capture();
+
+    memset(frame, 0, sizeof(frame));
+    TEST_ASSERT_EQUAL(0, sim_radio_init(&sim, &fast_radio, fd, 0, 100000, 4));
+    TEST_ASSERT_EQUAL(PACKET_MAX_SIZE, sim_radio_write(&sim, frame, PACKET_MAX_SIZE));
+    TEST_ASSERT_EQUAL(1 + PACKET_MAX_SIZE, read_capture(fd));
+    for (int i = 1; i <= PACKET_MAX_SIZE; i++) {
+        flipped += __builtin_popcount(capture[i]);
+    }
+    TEST_ASSERT_INT_WITHIN_MESSAGE(80, 8 * PACKET_MAX_SIZE / 10, flipped,
+                                   "Bit errors are far from the configured rate");
+    TEST_ASSERT_EQUAL(1, sim.corrupted);
+
+    /* The ground station's CRC check drops a frame with errors instead */
+
+    crc_radio.crc = true;
+    TEST_ASSERT_EQUAL(0, sim_radio_init(&sim, &crc_radio, fd, 0, 100000, 4));
+    sim_radio_write(&sim, frame, PACKET_MAX_SIZE);
+    TEST_ASSERT_EQUAL(1, sim.lost);
+    TEST_ASSERT_EQUAL(0, read_capture(fd));
+    close(fd);
+}
+
+void test_sim_radio(void) {
+    RUN_TEST(test_sim_radio__blocks_for_airtime);
+    RUN_TEST(test_sim_radio__loses_frames);
+    RUN_TEST(test_sim_radio__bit_errors);
+}
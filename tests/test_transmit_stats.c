@@ -0,0 +1,20 @@
+#include <nuttx/config.h>
+#include <testing/unity.h>
+
+#include "../telemetry/src/transmission/transmit-stats.h"
+
+/* Tests */
+
+static void test_transmit_stats__hist_buckets(void) {
+    TEST_ASSERT_EQUAL_MESSAGE(0, transmit_hist_bucket(0), "Under 1 ms should be the first bucket");
+    TEST_ASSERT_EQUAL(1, transmit_hist_bucket(1));
+    TEST_ASSERT_EQUAL(2, transmit_hist_bucket(2));
+    TEST_ASSERT_EQUAL(2, transmit_hist_bucket(3));
+    TEST_ASSERT_EQUAL(10, transmit_hist_bucket(700));
+    TEST_ASSERT_EQUAL(10, transmit_hist_bucket(1023));
+    TEST_ASSERT_EQUAL(11, transmit_hist_bucket(1024));
+    TEST_ASSERT_EQUAL_MESSAGE(TRANSMIT_HIST_BUCKETS - 1, transmit_hist_bucket(UINT32_MAX),
+                              "Long times should land in the last bucket");
+}
+
+void test_transmit_stats(void) { RUN_TEST(test_transmit_stats__hist_buckets); }
@@ -14,5 +14,22 @@ int main(void) {
     test_detection();
     test_filtering();
     test_logging();
+    test_decimator();
+    test_radio_telem();
+    test_rate_control();
+    test_odr_schedule();
+    test_resample();
+    test_deadband();
+    test_downlink_profile();
+    test_packer();
+    test_airtime();
+    test_delta_blk();
+    test_buffering();
+    test_event_queue();
+    test_fec();
+    test_sim_radio();
+    test_transmit_stats();
+    test_radio_phase();
+    test_blocks();
     return UNITY_END();
 }